@@ -27,12 +27,18 @@
 #include <assert.h>
 
 namespace queens {
+
+ /**
+  * An NxN board with its blocking vectors. The dimension is a template
+  * parameter so that all the derived masks and loop bounds are compile-time
+  * constants.
+  */
+  template<unsigned N>
   class Board {
-  public:
-    unsigned const  N;
+    static_assert((5 <= N) && (N <= 32), "Board dimension must be from 5..32.");
 
   private:
-    signed *const  board;
+    signed  board[N];
 
     uint64_t  bv;
     uint64_t  bh;
@@ -40,14 +46,10 @@ namespace queens {
     uint64_t  bd;
 
   public:
-    Board(unsigned const  dim)
-      : N(dim), board(new signed[dim]),
-	bv(0), bh(0), bu(0), bd(0) {
-      for(unsigned  i = 0; i < dim; board[i++] = -1);
-    }
-    ~Board() {
-      delete [] board;
+    Board() : bv(0), bh(0), bu(0), bd(0) {
+      for(unsigned  i = 0; i < N; board[i++] = -1);
     }
+    ~Board() {}
 
   private:
     class Cell {
@@ -108,7 +110,7 @@ namespace queens {
 	// Check Validity of new Placement
 	uint64_t const  bv = UINT64_C(1)<<x;
 	uint64_t const  bh = UINT64_C(1)<<y;
-	uint64_t const  bu = UINT64_C(1)<<(parent.N-1-x+y);
+	uint64_t const  bu = UINT64_C(1)<<(N-1-x+y);
 	uint64_t const  bd = UINT64_C(1)<<(           x+y);
 	if((parent.bv&bv)||(parent.bh&bh)||(parent.bu&bu)||(parent.bd&bd)) {
 	  valid = false;
@@ -128,7 +130,7 @@ namespace queens {
 	if(owner) {
 	  parent.bv ^= UINT64_C(1)<<x;
 	  parent.bh ^= UINT64_C(1)<<y;
-	  parent.bu ^= UINT64_C(1)<<(parent.N-1-x+y);
+	  parent.bu ^= UINT64_C(1)<<(N-1-x+y);
 	  parent.bd ^= UINT64_C(1)<<(           x+y);
 	  parent(x, y) = false;
 	}
@@ -137,12 +139,27 @@ namespace queens {
     public:
       operator bool() { return  valid; }
 
+      friend std::ostream& operator<<(std::ostream &out, Placement const &p) {
+	out << '(' << p.x << ',' << p.y << ')';
+	return  out;
+      }
+
     }; // class Placement
 
     Placement place(unsigned  x, unsigned  y) {
       return  Placement(*this, x, y);
     }
 
+    // Adds a queen known not to conflict with the placed ones without
+    // checks. It may coincide with a queen already placed.
+    void add(unsigned  x, unsigned  y) {
+      board[x] = (signed)y;
+      bv |= UINT64_C(1)<<x;
+      bh |= UINT64_C(1)<<y;
+      bu |= UINT64_C(1)<<(N-1-x+y);
+      bd |= UINT64_C(1)<<(           x+y);
+    }
+
     uint64_t getBV() const { return  bv; }
     uint64_t getBH() const { return  bh; }
     uint64_t getBU() const { return  bu; }
@@ -177,8 +194,8 @@ namespace queens {
 
   }; // class Board
 
-  std::ostream& operator<<(std::ostream &out, Board const &brd) {
-    unsigned const  N = brd.N;
+  template<unsigned N>
+  std::ostream& operator<<(std::ostream &out, Board<N> const &brd) {
     for(unsigned  y = N; y-- > 0;) {
       for(unsigned  x = 0; x < N; x++) {
 	out << (brd(x, y)? 'Q' : '.');
@@ -188,11 +205,6 @@ namespace queens {
     return  out;
   }
 
-  std::ostream& operator<<(std::ostream &out, Board::Placement const &p) {
-    out << '(' << p.x << ',' << p.y << ')';
-    return  out;
-  }
-
 } // namespace queens
 
 #endif
@@ -0,0 +1,279 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "DBArchive.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace queens;
+
+namespace {
+
+  uint64_t const  MAGIC   = UINT64_C(0x5132374152434856);  // "Q27ARCHV"
+  uint32_t const  VERSION = 1;
+
+ /**
+  * Field Layout of the Entry Words by Column. The spec word is the key
+  * shifted up by KEY with the time stamp below. The solution word is
+  * solver:12 | residues:8 | stamp:12 | count:32 with three rings, and
+  * solver:12 | residues:8 | count:44 with two.
+  */
+  unsigned const  COLUMNS = 6;
+  struct Layout {
+    unsigned  key;    // shift of the key within the spec word
+    uint64_t  time;   // time stamp within the spec word
+    uint64_t  stamp;  // time stamp within the solution word (>> 32)
+    uint64_t  count;
+  };
+  Layout layout(unsigned const  rings) {
+    if(rings == 3)  return { 0, 0, 0xFFF, UINT64_C(0xFFFFFFFF) };
+    return { 20, UINT64_C(0xFFFFF), 0, UINT64_C(0xFFFFFFFFFFF) };
+  }
+
+  inline uint64_t zigzag  (uint64_t  d) { return (d << 1) ^ uint64_t(int64_t(d) >> 63); }
+  inline uint64_t unzigzag(uint64_t  z) { return (z >> 1) ^ (~(z & 1) + 1); }
+
+  // Number of bits to represent the given value.
+  inline unsigned width(uint64_t  v) { return  v == 0? 0 : 64 - __builtin_clzll(v); }
+
+  // Appends the frame-of-reference bit-packing of the column.
+  void pack(std::vector<uint64_t> &out, uint64_t const *const  col, size_t const  n) {
+    uint64_t  lo = ~UINT64_C(0);
+    uint64_t  hi =  0;
+    for(size_t  i = 0; i < n; i++) {
+      if(col[i] < lo)  lo = col[i];
+      if(col[i] > hi)  hi = col[i];
+    }
+    unsigned const  w = width(hi - lo);
+    out.push_back(lo);
+    out.push_back(w);
+    if(w == 0)  return;
+
+    size_t const  beg = out.size();
+    out.resize(beg + (n*w + 63)/64);
+    uint64_t *const  words = out.data() + beg;
+    for(size_t  i = 0; i < n; i++) {
+      uint64_t const  v   = col[i] - lo;
+      size_t   const  pos = i*w;
+      unsigned const  ofs = pos & 63;
+      words[pos >> 6] |= v << ofs;
+      if(ofs + w > 64)  words[(pos >> 6) + 1] |= v >> (64 - ofs);
+    }
+  }
+
+  // Unpacks a column passing each value to f(i, v). Returns the next column.
+  template<typename F>
+  uint64be_t const *unpack(uint64be_t const *p, size_t const  n, F &&f) {
+    uint64_t const  lo = *p++;
+    unsigned const  w  = uint64_t(*p++);
+    if(w == 0) {
+      for(size_t  i = 0; i < n; i++)  f(i, lo);
+      return  p;
+    }
+    uint64_t const  mask = w == 64? ~UINT64_C(0) : ~(~UINT64_C(0) << w);
+    for(size_t  i = 0; i < n; i++) {
+      size_t   const  pos = i*w;
+      unsigned const  ofs = pos & 63;
+      uint64_t  v = uint64_t(p[pos >> 6]) >> ofs;
+      if(ofs + w > 64)  v |= uint64_t(p[(pos >> 6) + 1]) << (64 - ofs);
+      f(i, lo + (v & mask));
+    }
+    return  p + (n*w + 63)/64;
+  }
+
+  void writeFully(int const  fd, void const *const  buf, size_t const  len, off_t  pos, char const *const  file) {
+    size_t  ofs = 0;
+    while(ofs < len) {
+      ssize_t const  k = ::pwrite(fd, static_cast<char const*>(buf)+ofs, len-ofs, pos+ofs);
+      if(k > 0)  ofs += k;
+      else if((k < 0) && (errno != EINTR)) {
+	throw  std::system_error(errno, std::system_category(), std::string("Cannot write ") + file);
+      }
+    }
+  }
+
+} // anonymous namespace
+
+//- Construction / Destruction -----------------------------------------------
+DBArchive::DBArchive(char const *const  file, unsigned const  rings)
+  : boost::iostreams::mapped_file_source(file), m_cache(new DBEntry[BLOCK]), m_cached(NONE) {
+  size_t const  bytes = boost::iostreams::mapped_file_source::size();
+  m_header = reinterpret_cast<Header const*>(data());
+  m_index  = reinterpret_cast<Index  const*>(m_header + 1);
+  if((bytes < sizeof(Header)) || (m_header->magic != MAGIC) || (m_header->version != VERSION) ||
+     (m_header->block != BLOCK)) {
+    throw  std::runtime_error(std::string(file) + ": Not a database archive of this version.");
+  }
+  m_rings = m_header->rings;
+  if((m_rings != 2) && (m_rings != 3)) {
+    throw  std::runtime_error(std::string(file) + ": Archive of " + std::to_string(m_rings) + " rings.");
+  }
+  if((rings != 0) && (m_rings != rings)) {
+    throw  std::runtime_error(std::string(file) + ": Archive of " + std::to_string(m_rings) + " rings where " +
+			      std::to_string(rings) + " are expected.");
+  }
+  m_entries = m_header->entries;
+  m_blocks  = (m_entries + BLOCK-1) / BLOCK;
+  if((bytes < sizeof(Header) + (m_blocks+1)*sizeof(Index)) || (m_index[m_blocks].offset != bytes)) {
+    throw  std::runtime_error(std::string(file) + ": Truncated database archive.");
+  }
+}
+
+DBArchive::~DBArchive() {}
+
+bool DBArchive::detect(char const *const  file) {
+  int const  fd = ::open(file, O_RDONLY);
+  if(fd < 0)  return  false;
+  uint64be_t  magic;
+  bool const  res = (::pread(fd, &magic, sizeof(magic), 0) == sizeof(magic)) && (magic == MAGIC);
+  ::close(fd);
+  return  res;
+}
+
+void DBArchive::compress(DBConstRange const &db, char const *const  file) {
+  int const  fd = ::open(file, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+  if(fd < 0)  throw  std::system_error(errno, std::system_category(), std::string("Cannot open ") + file);
+
+  try {
+    Layout const  lay = layout(db.rings());
+    size_t const  n   = db.size();
+    size_t const  blocks = (n + BLOCK-1) / BLOCK;
+
+    // Blocks follow the Index, which is written last.
+    std::vector<Index>  index(blocks+1);
+    off_t  pos = sizeof(Header) + index.size()*sizeof(Index);
+
+    std::vector<uint64_t>  col[COLUMNS];
+    for(auto &c : col)  c.resize(BLOCK);
+    std::vector<uint64_t>  out;
+    uint64_t const *const  raw = reinterpret_cast<uint64_t const*>(db.begin());
+    for(size_t  b = 0; b < blocks; b++) {
+      size_t const  beg = b*BLOCK;
+      size_t const  cnt = b+1 < blocks? BLOCK : n - beg;
+
+      uint64_t  prev = __builtin_bswap64(raw[2*beg]) >> lay.key;
+      index[b].spec   = prev;
+      index[b].offset = pos;
+      for(size_t  i = 0; i < cnt; i++) {
+	uint64_t const  s   = __builtin_bswap64(raw[2*(beg+i)]);
+	uint64_t const  o   = __builtin_bswap64(raw[2*(beg+i)+1]);
+	uint64_t const  key = s >> lay.key;
+	col[0][i] = zigzag(key - prev);
+	col[1][i] = s & lay.time;
+	col[2][i] = o >> 52;
+	col[3][i] = (o >> 44) & 0xFF;
+	col[4][i] = (o >> 32) & lay.stamp;
+	col[5][i] = o & lay.count;
+	prev = key;
+      }
+      out.clear();
+      for(auto const &c : col)  pack(out, c.data(), cnt);
+      for(uint64_t &w : out)  w = __builtin_bswap64(w);
+      writeFully(fd, out.data(), out.size()*sizeof(uint64_t), pos, file);
+      pos += out.size()*sizeof(uint64_t);
+    }
+    index[blocks].offset = pos;
+
+    Header  hdr;
+    hdr.magic   = MAGIC;
+    hdr.version = VERSION;
+    hdr.rings   = db.rings();
+    hdr.entries = n;
+    hdr.block   = BLOCK;
+    writeFully(fd, index.data(), index.size()*sizeof(Index), sizeof(Header), file);
+    writeFully(fd, &hdr, sizeof(hdr), 0, file);
+    if(::close(fd) != 0)  throw  std::system_error(errno, std::system_category(), std::string("Cannot close ") + file);
+  }
+  catch(...) {
+    ::close(fd);
+    throw;
+  }
+}
+
+//- Access -------------------------------------------------------------------
+size_t DBArchive::decode(size_t const  b, DBEntry *const  out) const {
+  Layout const  lay = layout(m_rings);
+  size_t const  n   = count(b);
+  uint64_t     *raw = reinterpret_cast<uint64_t*>(out);
+  uint64be_t const *p = reinterpret_cast<uint64be_t const*>(data() + m_index[b].offset);
+
+  uint64_t  key = m_index[b].spec;
+  p = unpack(p, n, [&](size_t  i, uint64_t  v) { key += unzigzag(v); raw[2*i] = key << lay.key; });
+  p = unpack(p, n, [&](size_t  i, uint64_t  v) { raw[2*i]   |= v; });
+  p = unpack(p, n, [&](size_t  i, uint64_t  v) { raw[2*i+1]  = v << 52; });
+  p = unpack(p, n, [&](size_t  i, uint64_t  v) { raw[2*i+1] |= v << 44; });
+  p = unpack(p, n, [&](size_t  i, uint64_t  v) { raw[2*i+1] |= v << 32; });
+  p = unpack(p, n, [&](size_t  i, uint64_t  v) { raw[2*i+1] |= v; });
+  for(size_t  i = 0; i < 2*n; i++)  raw[i] = __builtin_bswap64(raw[i]);
+  return  n;
+}
+
+DBEntry const &DBArchive::entry(size_t const  i) const {
+  size_t const  b = i / BLOCK;
+  if(b != m_cached) {
+    decode(b, m_cache.get());
+    m_cached = b;
+  }
+  return  m_cache[i % BLOCK];
+}
+
+size_t DBArchive::lub(uint64_t  spec, size_t const  beg, size_t const  end) const {
+  if(beg >= end)  return  end;
+  spec &= ~UINT64_C(0x1F); // ignore symmetry and CRC
+
+  // The last block starting below spec holds the bound unless it is the
+  // first entry of the following block.
+  size_t  lo = 0;
+  size_t  hi = m_blocks;
+  while(hi - lo > 1) {
+    size_t const  m = (lo + hi) / 2;
+    if(m_index[m].spec < spec)  lo = m;
+    else                        hi = m;
+  }
+  size_t  i = lo*BLOCK;
+  size_t const  last = i + count(lo);
+  while((i < last) && (entry(i).spec(m_rings) < spec))  i++;
+  return  i < beg? beg : i > end? end : i;
+}
+
+size_t DBArchive::glb(uint64_t  spec, size_t const  beg, size_t const  end) const {
+  if(beg >= end)  return  NONE;
+  spec |= UINT64_C(0x1F); // ignore symmetry and CRC
+
+  // The last block starting at or below spec holds the bound.
+  if(m_index[0].spec > spec)  return  NONE;
+  size_t  lo = 0;
+  size_t  hi = m_blocks;
+  while(hi - lo > 1) {
+    size_t const  m = (lo + hi) / 2;
+    if(m_index[m].spec <= spec)  lo = m;
+    else                         hi = m;
+  }
+  size_t  i = lo*BLOCK + count(lo) - 1;
+  while((i > lo*BLOCK) && (entry(i).spec(m_rings) > spec))  i--;
+  return  i < beg? NONE : i >= end? end-1 : i;
+}
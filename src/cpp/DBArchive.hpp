@@ -0,0 +1,162 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef QUEENS_DBARCHIVE_HPP
+#define QUEENS_DBARCHIVE_HPP
+
+#include "Database.hpp"
+#include "endian.hpp"
+
+#include <cstdint>
+#include <memory>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+namespace queens {
+
+ /**
+  * Read-only, block-compressed database file.
+  *
+  * The entries are compressed in blocks of BLOCK entries. Each block
+  * stores the fields of its entries in columns:
+  *
+  *  - the sorted spec as zigzag-encoded deltas,
+  *  - the time stamp of the spec word (two rings),
+  *  - the solver, the residues, the time stamp of the solution word
+  *    (three rings) and the count.
+  *
+  * Each column is bit-packed relative to its minimum with the width of its
+  * largest offset, so the columns of unsolved entries take no space at
+  * all. An index of the first spec and the offset of every block provides
+  * random access for lub() and glb() by decoding a single block.
+  *
+  * File Layout (all words big endian):
+  *
+  *  Header | Index[blocks+1] | Block ...
+  *  Block:  { uint64 base, uint64 width, uint64 packed[] } per column
+  */
+  class DBArchive : private boost::iostreams::mapped_file_source {
+  public:
+    static size_t const  BLOCK = 4096;
+    static size_t const  NONE  = ~size_t(0);  // no entry, cf. nullptr
+
+    class Range;
+
+  private:
+    struct Header {
+      uint64be_t  magic;
+      uint32be_t  version;
+      uint32be_t  rings;
+      uint64be_t  entries;
+      uint64be_t  block;
+    };
+    struct Index {
+      uint64be_t  spec;    // spec() of the first entry
+      uint64be_t  offset;  // of the block data within the file
+    };
+
+    Header const *m_header;
+    Index  const *m_index;
+    size_t        m_entries;
+    size_t        m_blocks;
+    unsigned      m_rings;
+
+    // Most recently decoded block for entry()
+    mutable std::unique_ptr<DBEntry[]>  m_cache;
+    mutable size_t                      m_cached;
+
+    //- Construction / Destruction -------------------------------------------
+  public:
+    // Opens an archive, which records the layout of its entries. Unless
+    // rings is zero, a std::runtime_error is thrown for any other layout.
+    DBArchive(char const *file, unsigned  rings = 0);
+    ~DBArchive();
+
+  private:
+    DBArchive(DBArchive const&) = delete;
+    DBArchive& operator=(DBArchive const&) = delete;
+
+  public:
+    // Tells if the given file is an archive rather than a plain database.
+    static bool detect(char const *file);
+
+    // Writes the given range of a plain database as an archive.
+    static void compress(DBConstRange const &db, char const *file);
+
+    //- Access ---------------------------------------------------------------
+  public:
+    size_t   size()   const { return  m_entries; }
+    size_t   blocks() const { return  m_blocks; }
+    unsigned rings()  const { return  m_rings; }
+    Range    range()  const;
+
+    // The number of entries of the given block.
+    size_t count(size_t  b) const {
+      return  b+1 < m_blocks? BLOCK : m_entries - b*BLOCK;
+    }
+
+    // Decodes the given block into out, which holds at least BLOCK entries.
+    // Returns the number of its entries. Safe for concurrent use.
+    size_t decode(size_t  b, DBEntry *out) const;
+
+    // Random access through a cache of the last decoded block. Sequential
+    // access thus decodes each block once. Not safe for concurrent use.
+    DBEntry const &entry(size_t  i) const;
+
+    // The search bounds of DBConstRange within [beg, end).
+    size_t lub(uint64_t  spec, size_t  beg, size_t  end) const;
+    size_t glb(uint64_t  spec, size_t  beg, size_t  end) const;
+
+  }; // class DBArchive
+
+ /**
+  * Range of archived entries by their indices, the counterpart of
+  * DBConstRange for the resolution of range specifications.
+  */
+  class DBArchive::Range {
+    DBArchive const *m_arc;
+    size_t           m_beg;
+    size_t           m_end;
+
+  public:
+    Range(DBArchive const &arc, size_t  beg, size_t  end)
+      : m_arc(&arc), m_beg(beg), m_end(end) {}
+    ~Range() {}
+
+  public:
+    DBArchive const &archive() const { return *m_arc; }
+    size_t size()  const { return  m_end - m_beg; }
+    size_t begin() const { return  m_beg; }
+    size_t end()   const { return  m_end; }
+
+    DBEntry const &operator[](size_t  i) const { return  m_arc->entry(i); }
+
+    // The search bounds requires a sorted Range.
+    size_t lub(uint64_t  spec) const { return  m_arc->lub(spec, m_beg, m_end); }
+    size_t glb(uint64_t  spec) const { return  m_arc->glb(spec, m_beg, m_end); }
+  };
+
+  inline DBArchive::Range DBArchive::range() const {
+    return  Range(*this, 0, m_entries);
+  }
+
+} // namespace queens
+
+#endif
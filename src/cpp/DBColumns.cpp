@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "DBColumns.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace queens;
+
+namespace {
+
+  // Buffered sequential output of one column file.
+  class ColumnWriter {
+    static size_t const  BUFFER = 1 << 19;  // words, 4 MiB
+
+    std::string const              m_name;
+    int                            m_fd;
+    std::unique_ptr<uint64be_t[]>  m_buf;
+    size_t                         m_fill;
+
+  public:
+    ColumnWriter(std::string const &name)
+      : m_name(name), m_fd(::open(name.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0666)),
+	m_buf(new uint64be_t[BUFFER]), m_fill(0) {
+      if(m_fd < 0)  fail("Cannot open");
+    }
+    ~ColumnWriter() {
+      if(m_fd >= 0)  ::close(m_fd);
+    }
+
+  public:
+    void put(uint64be_t const &w) {
+      if(m_fill == BUFFER)  flush();
+      m_buf[m_fill++] = w;
+    }
+    void close() {
+      flush();
+      int const  fd = m_fd;
+      m_fd = -1;
+      if(::close(fd) != 0)  fail("Cannot close");
+    }
+
+  private:
+    void flush() {
+      char const *const  buf = reinterpret_cast<char const*>(m_buf.get());
+      size_t const  len = m_fill * sizeof(uint64be_t);
+      for(size_t  ofs = 0; ofs < len;) {
+	ssize_t const  k = ::write(m_fd, buf+ofs, len-ofs);
+	if(k > 0)  ofs += k;
+	else if((k < 0) && (errno != EINTR))  fail("Cannot write");
+      }
+      m_fill = 0;
+    }
+    void fail(char const *const  what) const {
+      throw  std::system_error(errno, std::system_category(), std::string(what) + ' ' + m_name);
+    }
+  };
+
+  // Maps a column file, of which an empty one cannot be mapped.
+  void openColumn(boost::iostreams::mapped_file_source &f, std::string const &name) {
+    struct stat  st;
+    if(::stat(name.c_str(), &st) != 0)  throw  std::system_error(errno, std::system_category(), "Cannot open " + name);
+    if(st.st_size > 0)  f.open(name);
+  }
+
+} // anonymous namespace
+
+//- Construction / Destruction -----------------------------------------------
+DBColumns::DBColumns(char const *const  base, unsigned const  rings) : m_rings(rings) {
+  openColumn(m_spec, std::string(base) + ".spec");
+  openColumn(m_sol,  std::string(base) + ".sol");
+  m_size = m_spec.size() / sizeof(uint64be_t);
+  if((m_sol.size() != m_spec.size()) || (m_spec.size() % sizeof(uint64be_t) != 0)) {
+    throw  std::runtime_error(std::string(base) + ": Columns of different sizes.");
+  }
+
+  // Check the Layout on reassembled Samples
+  DBEntry       sample[64];
+  size_t const  k = m_size < 64? m_size : 64;
+  for(size_t  i = 0; i < k; i++)  sample[i] = entry(i*m_size/k);
+  unsigned const  r = DBEntry::layout(sample, sample+k);
+  if((r != 0) && (rings != 0) && (r != rings)) {
+    throw  std::runtime_error(std::string(base) + ": Entries of " + std::to_string(r) + " rings where " +
+			      std::to_string(rings) + " are expected.");
+  }
+  if(m_rings == 0)  m_rings = r == 0? 2 : r;
+}
+
+DBColumns::~DBColumns() {}
+
+bool DBColumns::detect(char const *const  base) {
+  struct stat  st;
+  return
+    (::stat(base, &st) != 0) &&
+    (::stat((std::string(base) + ".spec").c_str(), &st) == 0) &&
+    (::stat((std::string(base) + ".sol" ).c_str(), &st) == 0);
+}
+
+void DBColumns::split(DBConstRange const &db, char const *const  base) {
+  ColumnWriter  spec(std::string(base) + ".spec");
+  ColumnWriter  sol (std::string(base) + ".sol");
+  uint64be_t const *const  raw = reinterpret_cast<uint64be_t const*>(db.begin());
+  for(size_t  i = 0; i < db.size(); i++) {
+    spec.put(raw[2*i]);
+    sol .put(raw[2*i+1]);
+  }
+  spec.close();
+  sol .close();
+}
@@ -0,0 +1,139 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef QUEENS_DBCOLUMNS_HPP
+#define QUEENS_DBCOLUMNS_HPP
+
+#include "Database.hpp"
+#include "endian.hpp"
+
+#include <cstdint>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+namespace queens {
+
+ /**
+  * Read-only columnar representation of a database in the two files
+  * <base>.spec and <base>.sol, which hold the spec and the solution words
+  * of the entries under the same index.
+  *
+  * A Column iterates the words of one kind as entries whose other word is
+  * zero. Only the fields backed by the iterated word are meaningful:
+  *
+  *  specs() - spec(), sym(), valid(), queens() and, with two rings, the
+  *            time stamp (taken(), time(), ...),
+  *  sols()  - solved(), solver(), mod13(), mod15(), count(), wrapped()
+  *            and, with three rings, the time stamp.
+  *
+  * Scans needing a single column thus touch half of the bytes of the
+  * plain layout. entry() reassembles complete entries.
+  */
+  class DBColumns {
+    boost::iostreams::mapped_file_source  m_spec;
+    boost::iostreams::mapped_file_source  m_sol;
+    size_t                                m_size;
+    unsigned                              m_rings;
+
+  public:
+    class Column;
+
+    //- Construction / Destruction -------------------------------------------
+  public:
+    // Maps the columns of the given base name, whose entries must be of the
+    // layout of the given number of rings, detected from them if zero as by
+    // Database. Throws a std::runtime_error if the columns do not match in
+    // size or their entries the layout.
+    DBColumns(char const *base, unsigned  rings = 0);
+    ~DBColumns();
+
+  private:
+    DBColumns(DBColumns const&) = delete;
+    DBColumns& operator=(DBColumns const&) = delete;
+
+  public:
+    // Tells if base names a column store rather than a plain database.
+    static bool detect(char const *base);
+
+    // Writes the given range of a plain database as a column store.
+    static void split(DBConstRange const &db, char const *base);
+
+    //- Access ---------------------------------------------------------------
+  public:
+    size_t   size()  const { return  m_size; }
+    unsigned rings() const { return  m_rings; }
+
+    Column specs() const;
+    Column sols()  const;
+
+    DBEntry entry(size_t  i) const {
+      return  DBEntry(words(m_spec)[i], words(m_sol)[i]);
+    }
+
+  private:
+    static uint64be_t const *words(boost::iostreams::mapped_file_source const &f) {
+      return  reinterpret_cast<uint64be_t const*>(f.data());
+    }
+
+  }; // class DBColumns
+
+  class DBColumns::Column {
+    uint64be_t const *m_beg;
+    uint64be_t const *m_end;
+    bool              m_sol;
+
+  public:
+    class iterator {
+      uint64be_t const *m_ptr;
+      bool              m_sol;
+
+    public:
+      iterator(uint64be_t const *ptr, bool  sol) : m_ptr(ptr), m_sol(sol) {}
+
+    public:
+      DBEntry operator*() const {
+	uint64be_t const  zero;
+	return  m_sol? DBEntry(zero, *m_ptr) : DBEntry(*m_ptr, zero);
+      }
+      iterator& operator++() { m_ptr++; return *this; }
+      bool operator!=(iterator const &o) const { return  m_ptr != o.m_ptr; }
+    };
+
+  public:
+    Column(uint64be_t const *beg, uint64be_t const *end, bool  sol)
+      : m_beg(beg), m_end(end), m_sol(sol) {}
+    ~Column() {}
+
+  public:
+    size_t   size()  const { return  m_end - m_beg; }
+    iterator begin() const { return  iterator(m_beg, m_sol); }
+    iterator end()   const { return  iterator(m_end, m_sol); }
+  };
+
+  inline DBColumns::Column DBColumns::specs() const {
+    return  Column(words(m_spec), words(m_spec) + m_size, false);
+  }
+  inline DBColumns::Column DBColumns::sols() const {
+    return  Column(words(m_sol), words(m_sol) + m_size, true);
+  }
+
+} // namespace queens
+
+#endif
@@ -23,134 +23,271 @@
 #include <iomanip>
 #include <ctime>
 #include <cassert>
+#include <cstring>
 
 using queens::DBEntry;
 
-char const *DBEntry::check() const {
-  if(!valid())   return "CRC Error";
-  if(wrapped())  return "Residue Error";
+unsigned DBEntry::layout(DBEntry const *const  beg, DBEntry const *const  end) {
+  size_t const  n = end - beg;
+  size_t const  k = n < 64? n : 64;
+  unsigned  v2 = 0;
+  unsigned  v3 = 0;
+  for(size_t  i = 0; i < k; i++) {
+    uint64_t const  spec = beg[i*n/k].m_spec;
+    v2 += valid2(spec) && (sym2(spec) != 0);
+    v3 += valid3(spec) && (sym3(spec) != 0);
+  }
+  return  v2 > v3? 2 : v3 > v2? 3 : 0;
+}
+
+unsigned DBEntry::stamp(unsigned const  rings, time_t  t) {
+  struct tm  ptm;
+  gmtime_r(&t, &ptm);
+  if(rings == 3)  return  (((ptm.tm_mday << 5) | ptm.tm_hour) << 2) | (ptm.tm_min/15);
+  return (((((((((ptm.tm_year-115)&3) << 4) | (ptm.tm_mon+1)) << 5) | ptm.tm_mday) << 5) |  ptm.tm_hour) << 4) | (ptm.tm_min/4);
+}
+
+time_t DBEntry::stamped(unsigned const  rings, unsigned const  time, time_t const  now) {
+  // Fields of the Stamp
+  bool const  L3 = rings == 3;
+  int  year, mon, day, hour, min;
+  if(L3) {
+    year = 0;
+    mon  = 0;
+    day  = time >> 7;
+    hour = (time >> 2) & 31;
+    min  = (time & 3) * 15;
+  }
+  else {
+    year = (time >> 18) & 3;
+    mon  = ((time >> 14) & 15) - 1;
+    day  = (time >>  9) & 31;
+    hour = (time >>  4) & 31;
+    min  = (time & 15) * 4;
+  }
+  if((mon < 0) || (mon > 11) || (day < 1) || (hour > 23))  return  0;
+
+  // Walk back from the current month (or year) to the first match.
+  time_t const  ref = now + 3600;
+  struct tm  cur;
+  gmtime_r(&ref, &cur);
+  for(int  k = 0; k < (L3? 3 : 5); k++) {
+    if(!L3 && (((cur.tm_year - k - 115) & 3) != year))  continue;
+    struct tm  ptm;
+    memset(&ptm, 0, sizeof(ptm));
+    ptm.tm_year = L3? cur.tm_year : cur.tm_year - k;
+    ptm.tm_mon  = L3? cur.tm_mon  - k : mon;
+    ptm.tm_mday = day;
+    ptm.tm_hour = hour;
+    ptm.tm_min  = min;
+    time_t const  t = timegm(&ptm);
+    if((ptm.tm_mday == day) && (t <= ref))  return  t;  // day exists in that month
+  }
+  return  0;
+
+} // stamped()
+
+unsigned DBEntry::year(unsigned const  rings) const {
+  if(rings == 3)  return  0;
+  time_t const  t = stamped(rings, time(rings), ::time(NULL));
+  struct tm  ptm;
+  return  t == 0? 0 : gmtime_r(&t, &ptm)->tm_year + 1900;
+}
+
+char const *DBEntry::check(unsigned const  rings) const {
+  if(!valid(rings))   return "CRC Error";
+  if(wrapped(rings))  return "Residue Error";
   return  0;
 }
 
-unsigned DBEntry::queens(uint64_t _spec) {
+unsigned DBEntry::queens(unsigned const  L) const {
+  // Queens within the rings rather than in their shared corners
+  uint64_t  _spec = m_spec;
   unsigned  res = 0;
-  for(_spec >>= 25; _spec != 0; _spec >>= 5) {
-    if((_spec & 0x1F) > 1)  res++;
+  for(_spec >>= (L == 3? 5 : 25); _spec != 0; _spec >>= 5) {
+    if((_spec & 0x1F) > L-1)  res++;
   }
   return  res;
 }
 
-void DBEntry::timestamp() {
-  time_t rawtime;
-  ::time(&rawtime);
-  struct tm *ptm = gmtime(&rawtime);
+void DBEntry::update(uint64be_t &w, uint64_t const  mask, uint64_t const  bits) {
+  uint64_t *const  word = reinterpret_cast<uint64_t*>(&w);
+  uint64_t  raw = __atomic_load_n(word, __ATOMIC_ACQUIRE);
+  while(true) {
+    uint64_t const  upd = (be64toh(raw) & ~mask) | bits;
+    if(__atomic_compare_exchange_n(word, &raw, htobe64(upd), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))  break;
+  }
+}
 
-  m_spec =
-    (m_spec & ~UINT64_C(0xFFFFF)) |
-    ((((((((((ptm->tm_year-115)&3 << 4) | (ptm->tm_mon+1)) << 5) | ptm->tm_mday) << 5) |  ptm->tm_hour) << 4) | (ptm->tm_min/4)) & 0xFFFFF);
+void DBEntry::timestamp(unsigned const  rings) {
+  uint64_t const  t = stamp(rings, ::time(NULL));
+  if(rings == 3)  update(m_sol,  STAMP3, t << 32);
+  else            update(m_spec, STAMP2, t);
 }
 
-bool DBEntry::solve(unsigned  solver, uint64_t  cnt, unsigned  m15, unsigned  m13) {
+bool DBEntry::claim(unsigned const  rings, time_t const  stale) {
+  bool      const  L3   = rings == 3;
+  uint64_t *const  word = reinterpret_cast<uint64_t*>(L3? &m_sol : &m_spec);
+  uint64_t  raw = __atomic_load_n(word, __ATOMIC_ACQUIRE);
+  while(true) {
+    uint64_t const  val = be64toh(raw);
+    if(L3? (val & ~STAMP3) != 0 : __atomic_load_n(reinterpret_cast<uint64_t*>(&m_sol), __ATOMIC_ACQUIRE) != 0) {
+      return  false;
+    }
+    time_t   const  now = ::time(NULL);
+    unsigned const  t   = L3? time3(val) : time2(val);
+    if((t != 0) && ((stale == 0) || (stamped(rings, t, now) >= stale)))  return  false;
+
+    uint64_t const  s = stamp(rings, now);
+    uint64_t const  upd = L3? (val & ~STAMP3) | (s << 32) : (val & ~STAMP2) | s;
+    if(__atomic_compare_exchange_n(word, &raw, htobe64(upd), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))  break;
+  }
+  // A concurrent solve() stamps the spec word after its solution.
+  return  L3 || !solved(rings);
+}
+
+bool DBEntry::solve(unsigned const  rings, unsigned  solver, uint64_t  cnt, unsigned  m15, unsigned  m13) {
   if((14 < m15) || (12 < m13))  return  false;
-  timestamp();
-  m_sol =
+  uint64_t const  sol =
     (((uint64_t)solver)<<52)|
     (((uint64_t)m13)<<48)|
     (((uint64_t)m15)<<44)|
-    (cnt&UINT64_C(0xFFFFFFFFFFF));
+    (cnt&(rings == 3? UINT64_C(0xFFFFFFFF) : UINT64_C(0xFFFFFFFFFFF)));
 
+  // The solution precedes its stamp so that a claim() racing on the spec
+  // word of two rings finds the entry solved.
+  if(rings == 3)  update(m_sol, ~UINT64_C(0), sol | (uint64_t(stamp(rings, ::time(NULL))) << 32));
+  else {
+    update(m_sol, ~UINT64_C(0), sol);
+    timestamp(rings);
+  }
   return  true;
 }
 
-uint64_t DBEntry::encodeSpec(int8_t const *const  pre2, Symmetry  sym) {
+// Order of the coronal Fields in the Spec of the Three-Ring Layout
+static unsigned const  ORDER3[12] = { 0, 1, 3, 4, 6, 7, 9, 10, 2, 5, 8, 11 };
+
+uint64_t DBEntry::encodeSpec(unsigned const  rings, int8_t const *const  pre, Symmetry  sym) {
   uint64_t  spec = 0;
-  for(unsigned  i = 0; i < 8; i++)  spec = (spec<<5)|pre2[i];
+  if(rings == 3) {
+    for(unsigned  i = 0; i < 12; i++)  spec = (spec<<5)|pre[ORDER3[i]];
+    spec = (spec<<2)|sym;
+    assert(spec < UINT64_C(0x2000000000000000));
+    return (spec<<3)|crc3(spec);
+  }
+  for(unsigned  i = 0; i < 8; i++)  spec = (spec<<5)|pre[i];
   spec = (spec<<2)|sym;
   assert(spec < UINT64_C(0x20000000000));
   return ((spec<<3)|crc3(spec))<<20;
 }
-unsigned DBEntry::crc3(uint64_t  val) {
-  // Precomputed CRC for Generator 0xB
-  static uint8_t const  FSC[256] = {
-    0x00, 0x60, 0xC0, 0xA0, 0xE0, 0x80, 0x20, 0x40,
-    0xA0, 0xC0, 0x60, 0x00, 0x40, 0x20, 0x80, 0xE0,
-    0x20, 0x40, 0xE0, 0x80, 0xC0, 0xA0, 0x00, 0x60,
-    0x80, 0xE0, 0x40, 0x20, 0x60, 0x00, 0xA0, 0xC0,
-    0x40, 0x20, 0x80, 0xE0, 0xA0, 0xC0, 0x60, 0x00,
-    0xE0, 0x80, 0x20, 0x40, 0x00, 0x60, 0xC0, 0xA0,
-    0x60, 0x00, 0xA0, 0xC0, 0x80, 0xE0, 0x40, 0x20,
-    0xC0, 0xA0, 0x00, 0x60, 0x20, 0x40, 0xE0, 0x80,
-    0x80, 0xE0, 0x40, 0x20, 0x60, 0x00, 0xA0, 0xC0,
-    0x20, 0x40, 0xE0, 0x80, 0xC0, 0xA0, 0x00, 0x60,
-    0xA0, 0xC0, 0x60, 0x00, 0x40, 0x20, 0x80, 0xE0,
-    0x00, 0x60, 0xC0, 0xA0, 0xE0, 0x80, 0x20, 0x40,
-    0xC0, 0xA0, 0x00, 0x60, 0x20, 0x40, 0xE0, 0x80,
-    0x60, 0x00, 0xA0, 0xC0, 0x80, 0xE0, 0x40, 0x20,
-    0xE0, 0x80, 0x20, 0x40, 0x00, 0x60, 0xC0, 0xA0,
-    0x40, 0x20, 0x80, 0xE0, 0xA0, 0xC0, 0x60, 0x00,
-    0x60, 0x00, 0xA0, 0xC0, 0x80, 0xE0, 0x40, 0x20,
-    0xC0, 0xA0, 0x00, 0x60, 0x20, 0x40, 0xE0, 0x80,
-    0x40, 0x20, 0x80, 0xE0, 0xA0, 0xC0, 0x60, 0x00,
-    0xE0, 0x80, 0x20, 0x40, 0x00, 0x60, 0xC0, 0xA0,
-    0x20, 0x40, 0xE0, 0x80, 0xC0, 0xA0, 0x00, 0x60,
-    0x80, 0xE0, 0x40, 0x20, 0x60, 0x00, 0xA0, 0xC0,
-    0x00, 0x60, 0xC0, 0xA0, 0xE0, 0x80, 0x20, 0x40,
-    0xA0, 0xC0, 0x60, 0x00, 0x40, 0x20, 0x80, 0xE0,
-    0xE0, 0x80, 0x20, 0x40, 0x00, 0x60, 0xC0, 0xA0,
-    0x40, 0x20, 0x80, 0xE0, 0xA0, 0xC0, 0x60, 0x00,
-    0xC0, 0xA0, 0x00, 0x60, 0x20, 0x40, 0xE0, 0x80,
-    0x60, 0x00, 0xA0, 0xC0, 0x80, 0xE0, 0x40, 0x20,
-    0xA0, 0xC0, 0x60, 0x00, 0x40, 0x20, 0x80, 0xE0,
-    0x00, 0x60, 0xC0, 0xA0, 0xE0, 0x80, 0x20, 0x40,
-    0x80, 0xE0, 0x40, 0x20, 0x60, 0x00, 0xA0, 0xC0,
-    0x20, 0x40, 0xE0, 0x80, 0xC0, 0xA0, 0x00, 0x60
-  };
-  unsigned  crc = 0;
-  for(unsigned  i = 0; i < 8; i++) {
-    crc = FSC[(val>>56)^crc];
-    val <<= 8;
-  }
-  return  crc>>5;
+void DBEntry::coronal(unsigned const  rings, uint64_t  _spec, int8_t *const  pre) {
+  if(rings == 3) {
+    _spec >>= 5;
+    for(unsigned  i = 12; i-- > 0;) {
+      pre[ORDER3[i]] = _spec & 0x1F;
+      _spec >>= 5;
+    }
+    return;
+  }
+  _spec >>= 25;
+  for(unsigned  i = 8; i-- > 0;) {
+    pre[i] = _spec & 0x1F;
+    _spec >>= 5;
+  }
 }
+bool DBEntry::expand(unsigned const  L, uint64_t const  _spec, unsigned const  N,
+		     uint64_t &bv, uint64_t &bh, uint64_t &bu, uint64_t &bd) {
+  int8_t  pre[12];
+  coronal(L, _spec, pre);
 
-std::ostream& queens::operator<<(std::ostream &out, DBEntry const&  entry) {
-  uint64_t const  spec = entry.m_spec;
-  uint64_t const  sol  = entry.m_sol;
+  // Board Coordinates of ring k on all sides: a corner queen appears on
+  // both of its sides.
+  unsigned  x[12], y[12];
+  for(unsigned  k = 0; k < L; k++) {
+    x[k]     = k;                 y[k]     = pre[k];
+    x[L+k]   = pre[L+k];          y[L+k]   = N-1-k;
+    x[2*L+k] = N-1-k;             y[2*L+k] = N-1-pre[2*L+k];
+    x[3*L+k] = N-1-pre[3*L+k];    y[3*L+k] = k;
+  }
+  uint64_t  v = 0;
+  uint64_t  h = 0;
+  uint64_t  u = 0;
+  uint64_t  d = 0;
+  for(unsigned  i = 0; i < 4*L; i++) {
+    if((x[i] >= N) || (y[i] >= N))  return  false;
 
+    uint64_t const  qv = UINT64_C(1) << x[i];
+    uint64_t const  qh = UINT64_C(1) << y[i];
+    if((v&qv) && (h&qh)) {
+      // Only the very same queen may share both column and row.
+      unsigned  j = 0;
+      while((x[j] != x[i]) || (y[j] != y[i]))  if(++j == i)  return  false;
+      continue;
+    }
+    uint64_t const  qu = UINT64_C(1) << (N-1-x[i]+y[i]);
+    uint64_t const  qd = UINT64_C(1) << (x[i]+y[i]);
+    if((v&qv)||(h&qh)||(u&qu)||(d&qd))  return  false;
+    v |= qv;
+    h |= qh;
+    u |= qu;
+    d |= qd;
+  }
+  bv = v;
+  bh = h;
+  bu = u;
+  bd = d;
+  return  true;
+}
+uint64_t const  DBEntry::CRC3[3] = {
+  UINT64_C(0x9D3A74E9D3A74E9D),
+  UINT64_C(0xA74E9D3A74E9D3A7),
+  UINT64_C(0x4E9D3A74E9D3A74E)
+};
+unsigned DBEntry::crc3(uint64_t const  val) {
+  return  __builtin_parityll(val & CRC3[0])       |
+	 (__builtin_parityll(val & CRC3[1]) << 1) |
+	 (__builtin_parityll(val & CRC3[2]) << 2);
+}
+
+std::ostream& queens::operator<<(std::ostream &out, DBEntry::Format const &f) {
+  DBEntry  const &entry = f.m_entry;
+  unsigned const  L     = f.m_rings;
   { // Pre-Placement
-    uint64_t  pre = spec>>1;
-    for(int  i = 0; i < 4; i++) {
-      out << '(' << std::setw(2) << (unsigned)(pre>>59);
-      pre <<= 5;
-      out << ',' << std::setw(2) << (unsigned)(pre>>59) << ')';
-      pre <<= 5;
+    int8_t  pre[12];
+    entry.coronal(L, pre);
+    for(unsigned  i = 0; i < 4*L; i++) {
+      out << (i%L == 0? '(' : ',') << std::setw(2) << (unsigned)pre[i];
+      if(i%L == L-1)  out << ')';
     }
   }
   // Solution
   out << '\t';
-  if(sol) {
-    out << std::setfill('0')
-      // Date
-	<< DBEntry::year(spec) << '-' << std::setw(2) << DBEntry::month(spec) << '-' << std::setw(2) << DBEntry::day(spec) << ' '
-      // Time
-	<< std::setw(2) << DBEntry::hour(spec) << ':' << std::setw(2) << DBEntry::min(spec) << std::setfill(' ')
+  if(entry.solved(L)) {
+    out << std::setfill('0');
+    // Date
+    if(L == 3)  out << "day " << std::setw(2) << entry.day(L) << ' ';
+    else {
+      out << entry.year(L) << '-' << std::setw(2) << entry.month(L) << '-' << std::setw(2) << entry.day(L) << ' ';
+    }
+    // Time
+    out << std::setw(2) << entry.hour(L) << ':' << std::setw(2) << entry.min(L) << std::setfill(' ')
       // Solution
-	<< "\t#" << std::setw(4) << DBEntry::solver(sol) << '\t' << std::setw(14) << DBEntry::count(sol);
+	<< "\t#" << std::setw(4) << entry.solver() << '\t' << std::setw(14) << entry.count(L);
   }
   else {
     out << "<todo>";
   }
 
-  if(!DBEntry::valid(spec)) {
+  if(!entry.valid(L)) {
     out << "\tINVALID";
   }
-  if(DBEntry::wrapped(sol)) {
-    unsigned const  m13 = DBEntry::mod13(sol);
-    unsigned const  m15 = DBEntry::mod15(sol);
-    uint64_t cand = DBEntry::count(sol);
-    while((cand%13 != m13) || (cand%15 != m15))  cand += UINT64_C(1)<<44;
+  if(entry.wrapped(L)) {
+    unsigned const  m13 = entry.mod13();
+    unsigned const  m15 = entry.mod15();
+    unsigned const  bits = L == 3? 32 : 44;
+    uint64_t cand = entry.count(L);
+    while((cand%13 != m13) || (cand%15 != m15))  cand += UINT64_C(1)<<bits;
     out << "\tWRAPPED[%13=" << std::setw(2) << m13 << ", %15=" << std::setw(2) << m15 << " -> " << cand << ']';
   }
   return  out;
-
-} // operator<<
+}
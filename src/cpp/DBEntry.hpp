@@ -21,6 +21,7 @@
 #ifndef QUEENS_DBENTRY_HPP
 #define QUEENS_DBENTRY_HPP
 
+#include <ctime>
 #include <ostream>
 
 #include "endian.hpp"
@@ -50,7 +51,7 @@ namespace queens {
   *    24-23     2     sym - Symmetry: 3-None, 2-Point, 1-Rotate
   *    22-20     3     CRC-3 over 63-23 (Generator: 0xB)
   *  [Solution Timestamp]
-  *    19-18     2     year-2015
+  *    19-18     2     (year-2015)%4
   *    17-14     4     month
   *    13- 9     5     day
   *     8- 4     5     hour
@@ -64,6 +65,38 @@ namespace queens {
   *    47-44     4     cnt%15
   *    43- 0    44     cnt - Solution Count
   *
+  * Databases of pre-placements of three outer rings (L=3) use a second
+  * layout, which keeps the two outer rings in place so that ranges over
+  * them select all refinements by the third ring:
+  *
+  *    Bits    Width   Description
+  *  ------------------------------------------------------------------
+  * uint64_t  m_spec:
+  *  [Pre-Placement]
+  *    63-25    39     wa, wb, na, nb, ea, eb, sa, sb - as above
+  *    24-20     5     wc  - West
+  *    19-15     5     nc  - North
+  *    14-10     5     ec  - East
+  *     9- 5     5     sc  - South
+  *     4- 3     2     sym - Symmetry: 3-None, 2-Point, 1-Rotate
+  *     2- 0     3     CRC-3 over 63-3 (Generator: 0xB)
+  *
+  * uint64_t  m_sol;
+  *  [Solver]
+  *    63-52    12     solver ID
+  *  [Solution]
+  *    51-48     4     cnt%13
+  *    47-44     4     cnt%15
+  *  [Solution Timestamp]
+  *    43-39     5     day
+  *    38-34     5     hour
+  *    33-32     2     min/15
+  *  [Solution]
+  *    31- 0    32     cnt - Solution Count
+  *
+  * A database holds entries of a single layout, which it detects and
+  * passes on to all accessors as the number of its pre-placed rings.
+  *
   * A fresh DBEntry can be constructed from a pre-placement.
   * Its [Solution Timestamp], [Solver] and [Solution] fields will all be
   * zero in this case. Otherwise, a DBEntry just provides the interpretation
@@ -79,9 +112,12 @@ namespace queens {
     //- Construction / Destruction -------------------------------------------
   public:
     DBEntry() : m_spec(0), m_sol(0) {}
-    DBEntry(int8_t const *pre2, Symmetry  sym) : m_sol(0) {
-      m_spec = encodeSpec(pre2, sym);
+    // Constructs the entry from the coronal format of Board::coronal(pre, rings).
+    DBEntry(unsigned  rings, int8_t const *pre, Symmetry  sym) : m_sol(0) {
+      m_spec = encodeSpec(rings, pre, sym);
     }
+    // Reassembles the entry from its two words as stored, e.g. by DBColumns.
+    DBEntry(uint64be_t const &spec, uint64be_t const &sol) : m_spec(spec), m_sol(sol) {}
     ~DBEntry() {}
 
   public:
@@ -97,81 +133,172 @@ namespace queens {
       return !(*this == o);
     }
 
-    //- Data Accessors -------------------------------------------------------
-  private:
-    friend std::ostream& operator<<(std::ostream &out, DBEntry const &entry);
+    //- Entry Layout ---------------------------------------------------------
+  public:
+    // The number of rings whose layout a sample of up to 64 of the given
+    // entries matches better by CRC and a non-zero symmetry, or 0 if it
+    // matches both equally well. The entries of one layout match the other
+    // only by a chance of 3/32 each (an untaken two-ring entry has a zero
+    // symmetry as three rings), so that a database file of the wrong layout
+    // is recognized reliably although it records none.
+    static unsigned layout(DBEntry const *beg, DBEntry const *end);
+
+    // The time() value of an entry of the given layout stamped at time t.
+    static unsigned stamp(unsigned  rings, time_t  t);
 
-    static bool taken(uint64_t _spec) { return time(_spec) != 0; }
-    static bool solved(uint64_t _sol) { return _sol        != 0; }
+    // The latest time up to now whose stamp() is the given non-zero time()
+    // value, or 0 if there is none. The stamps only keep the year modulo 4
+    // (and not even the month with three rings), so they must be compared
+    // by this time rather than numerically. Stamps up to an hour ahead of
+    // now, as by a host with a skewed clock, count as recent.
+    static time_t stamped(unsigned  rings, unsigned  time, time_t  now);
 
-    static uint64_t spec (uint64_t _spec) { return (_spec >> 20)&UINT64_C(0xFFFFFFFFFFF); }
-    static Symmetry sym  (uint64_t _spec) { return (_spec >> 23)&3; }
-    static bool     valid(uint64_t _spec) { return  crc3(_spec >> 20) == 0; }
-    static unsigned queens(uint64_t _spec);
+    //- Data Accessors -------------------------------------------------------
+  private:
+    // Two-Ring Layout
+    static uint64_t const  STAMP2 = UINT64_C(0xFFFFF);
+    static uint64_t spec2  (uint64_t _spec) { return (_spec >> 20)&UINT64_C(0xFFFFFFFFFFF); }
+    static Symmetry sym2   (uint64_t _spec) { return (_spec >> 23)&3; }
+    static bool     valid2 (uint64_t _spec) { return  crc3(_spec >> 20) == 0; }
+    static unsigned month2 (uint64_t _spec) { return (_spec >> 14)&15; }
+    static unsigned day2   (uint64_t _spec) { return (_spec >>  9)&31; }
+    static unsigned hour2  (uint64_t _spec) { return (_spec >>  4)&31; }
+    static unsigned min2   (uint64_t _spec) { return (_spec&15)*4; }
+    static unsigned time2  (uint64_t _spec) { return _spec & STAMP2; }
+    static uint64_t count2 (uint64_t _sol)  { return _sol & UINT64_C(0xFFFFFFFFFFF); }
 
-    static unsigned year (uint64_t _spec) { return ((_spec >> 18)&3) + 2015; }
-    static unsigned month(uint64_t _spec) { return (_spec >> 14)&15; }
-    static unsigned day  (uint64_t _spec) { return (_spec >>  9)&31; }
-    static unsigned hour (uint64_t _spec) { return (_spec >>  4)&31; }
-    static unsigned min  (uint64_t _spec) { return (_spec&15)*4; }
-    static unsigned time (uint64_t _spec) { return _spec & UINT64_C(0xFFFFF); }
+    // Three-Ring Layout
+    static uint64_t const  STAMP3 = UINT64_C(0xFFF00000000);
+    static uint64_t spec3  (uint64_t _spec) { return  _spec; }
+    static Symmetry sym3   (uint64_t _spec) { return (_spec >> 3)&3; }
+    static bool     valid3 (uint64_t _spec) { return  crc3(_spec) == 0; }
+    static unsigned day3   (uint64_t _sol)  { return (_sol >> 39)&31; }
+    static unsigned hour3  (uint64_t _sol)  { return (_sol >> 34)&31; }
+    static unsigned min3   (uint64_t _sol)  { return ((_sol >> 32)&3)*15; }
+    static unsigned time3  (uint64_t _sol)  { return (_sol & STAMP3) >> 32; }
+    static uint64_t count3 (uint64_t _sol)  { return _sol & UINT64_C(0xFFFFFFFF); }
 
-    static unsigned solver (uint64_t _sol) { return (_sol >> 52)&2047; }
+    static unsigned solver (uint64_t _sol) { return (_sol >> 52)&4095; }
     static unsigned mod13  (uint64_t _sol) { return (unsigned)((_sol >> 48)&15); }
     static unsigned mod15  (uint64_t _sol) { return (unsigned)((_sol >> 44)&15); }
-    static uint64_t count  (uint64_t _sol) { return _sol & UINT64_C(0xFFFFFFFFFFF); }
-    static bool     wrapped(uint64_t _sol) {
-      uint64_t const  cnt = count(_sol);
-      return (cnt%13 != mod13(_sol)) || (cnt%15 != mod15(_sol));
-    }
 
   public:
-    bool taken()  const { return  taken(m_spec); }
-    bool solved() const { return  solved(m_sol); }
-
-    uint64_t spec () const { return  spec (m_spec); }
-    Symmetry sym  () const { return  sym  (m_spec); }
-    bool     valid() const { return  valid(m_spec); }
-    unsigned queens()const { return  queens(m_spec);}
-    unsigned year () const { return  year (m_spec); }
-    unsigned month() const { return  month(m_spec); }
-    unsigned day  () const { return  day  (m_spec); }
-    unsigned hour () const { return  hour (m_spec); }
-    unsigned min  () const { return  min  (m_spec); }
-    unsigned time () const { return  time (m_spec); }
+    // The fields of the layout of the given number of rings
+    bool taken (unsigned  rings) const { return  time(rings) != 0; }
+    bool solved(unsigned  rings) const { return  rings == 3? (m_sol & ~STAMP3) != 0 : m_sol != 0; }
+
+    uint64_t spec  (unsigned  rings) const { return  rings == 3? spec3 (m_spec) : spec2 (m_spec); }
+    Symmetry sym   (unsigned  rings) const { return  rings == 3? sym3  (m_spec) : sym2  (m_spec); }
+    bool     valid (unsigned  rings) const { return  rings == 3? valid3(m_spec) : valid2(m_spec); }
+    unsigned queens(unsigned  rings) const;
+    unsigned year  (unsigned  rings) const;  // the latest one of the stamp up to now
+    unsigned month (unsigned  rings) const { return  rings == 3? 0 : month2(m_spec); }
+    unsigned day   (unsigned  rings) const { return  rings == 3? day3 (m_sol) : day2 (m_spec); }
+    unsigned hour  (unsigned  rings) const { return  rings == 3? hour3(m_sol) : hour2(m_spec); }
+    unsigned min   (unsigned  rings) const { return  rings == 3? min3 (m_sol) : min2 (m_spec); }
+    unsigned time  (unsigned  rings) const { return  rings == 3? time3(m_sol) : time2(m_spec); }
 
     unsigned solver  ()  const { return  solver (m_sol); }
     unsigned mod13   ()  const { return  mod13  (m_sol); }
     unsigned mod15   ()  const { return  mod15  (m_sol); }
-    uint64_t count   ()  const { return  count  (m_sol); }
-    bool     wrapped ()  const { return  wrapped(m_sol); }
+    uint64_t count   (unsigned  rings)  const { return  rings == 3? count3(m_sol) : count2(m_sol); }
+    bool     wrapped (unsigned  rings)  const {
+      uint64_t const  cnt = count(rings);
+      return (cnt%13 != mod13()) || (cnt%15 != mod15());
+    }
+
+  public:
+    // Decodes the pre-placement into the coronal format (wa, wb, na, nb,
+    // ea, eb, sa, sb) as produced by Board::coronal(pre, 2), or (wa, wb, wc,
+    // na, ..., sc) as produced by Board::coronal(pre, 3).
+    void coronal(unsigned  rings, int8_t *pre) const { coronal(rings, m_spec, pre); }
+
+    /**
+     * Expands the pre-placement into the blocking vectors of an NxN board
+     * as maintained by Board: bit x of bv and bit y of bh for a queen in
+     * column x and row y, which blocks bit N-1-x+y of bu and bit x+y of bd.
+     * Returns false without touching the vectors if the pre-placement is
+     * not conflict-free on a board of this dimension.
+     */
+    bool expand(unsigned  rings, unsigned  N, uint64_t &bv, uint64_t &bh, uint64_t &bu, uint64_t &bd) const {
+      return  expand(rings, m_spec, N, bv, bh, bu, bd);
+    }
 
   public:
-    char const *check() const;
-    uint64_t real_count() const { return  count() << (sym().weight()); }
+    char const *check(unsigned  rings) const;
+    uint64_t real_count(unsigned  rings) const { return  count(rings) << (sym(rings).weight()); }
 
   private:
-    void timestamp();
+    // Replaces the masked bits of a word by a compare-and-swap loop so that
+    // concurrent claim()s are neither lost nor overwritten with stale data.
+    static void update(uint64be_t &word, uint64_t  mask, uint64_t  bits);
+    void timestamp(unsigned  rings);
 
   public:
-    void take()   { timestamp(); }
-    void untake() { m_spec &= ~UINT64_C(0xFFFFF); }
-    void unsolve(){ untake(); m_sol = 0; }
+    void take  (unsigned  rings) { timestamp(rings); }
+    void untake(unsigned  rings) {
+      if(rings == 3)  update(m_sol,  STAMP3, 0);
+      else            update(m_spec, STAMP2, 0);
+    }
+    void unsolve(unsigned  rings) { untake(rings); m_sol = 0; }
+
+    /**
+     * Atomically takes this entry unless it is solved or taken. A taken
+     * entry is reclaimed if it was stamped before the non-zero time stale.
+     * The compare-and-swap on the word holding the timestamp makes claims
+     * safe among threads and among processes sharing the same mapping.
+     * Returns whether the entry was taken.
+     */
+    bool claim(unsigned  rings, time_t  stale = 0);
+
+    // Whether this entry is taken but unsolved since before the given time.
+    bool stale(unsigned  rings, time_t  cutoff) const {
+      return  taken(rings) && !solved(rings) && (stamped(rings, time(rings), ::time(NULL)) < cutoff);
+    }
 
     /**
      * Sets the solution and timestamp fields of this DBEntry
      * unless m13 > 12 or m15 > 14, in which case false is returned
      * without any further action.
      */
-    bool solve(unsigned  solver, uint64_t  cnt, unsigned  m15, unsigned  m13);
+    bool solve(unsigned  rings, unsigned  solver, uint64_t  cnt, unsigned  m15, unsigned  m13);
+
+  public:
+    // Textual form of the entry in the given layout for an output stream.
+    class Format;
+    Format format(unsigned  rings) const;
+
+  public:
+    // The CRC of generator 0xB is linear: bit k of crc3(val) is the parity
+    // of val & CRC3[k].
+    static uint64_t const  CRC3[3];
 
   private:
-    static uint64_t encodeSpec(int8_t const *pre2, Symmetry  sym);
+    static uint64_t encodeSpec(unsigned  rings, int8_t const *pre, Symmetry  sym);
+    static void     coronal(unsigned  rings, uint64_t _spec, int8_t *pre);
+    static bool     expand(unsigned  rings, uint64_t _spec, unsigned  N,
+			   uint64_t &bv, uint64_t &bh, uint64_t &bu, uint64_t &bd);
     static unsigned crc3(uint64_t  val);
 
   }; // class DBEntry
 
-  std::ostream& operator<<(std::ostream &out, DBEntry const &entry);
+  class DBEntry::Format {
+    DBEntry const &m_entry;
+    unsigned const  m_rings;
+
+  public:
+    Format(DBEntry const &entry, unsigned  rings) : m_entry(entry), m_rings(rings) {}
+    ~Format() {}
+
+  private:
+    friend std::ostream& operator<<(std::ostream &out, Format const &f);
+  };
+
+  inline DBEntry::Format DBEntry::format(unsigned const  rings) const {
+    return  Format(*this, rings);
+  }
+
+  std::ostream& operator<<(std::ostream &out, DBEntry::Format const &f);
 
 } // namespace queens
 
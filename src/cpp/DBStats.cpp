@@ -0,0 +1,227 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "DBStats.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace queens;
+
+namespace {
+
+  size_t const  CHUNK = 1 << 20;  // entries, 16 MiB
+
+  // Parity by shifts only, which vectorize unlike popcounts.
+  inline uint64_t parity(uint64_t  x) {
+    x ^= x >> 32;
+    x ^= x >> 16;
+    x ^= x >>  8;
+    x ^= x >>  4;
+    x ^= x >>  2;
+    x ^= x >>  1;
+    return  x & 1;
+  }
+
+ /**
+  * Branch-free scan of the raw big-endian words of n entries of the L-ring
+  * layout. Unsolved entries contribute zero counts and residues so that
+  * all sums are unconditional. As 2^12 = 1 both mod 13 and mod 15, the
+  * residues of a count are checked on the sum of its 12-bit digits, which
+  * fits 32-bit arithmetic.
+  */
+  template<unsigned L>
+  __attribute__((always_inline)) inline
+  void scanLanes(DBStats &st, uint64_t const *const  raw, size_t const  n) {
+    unsigned const  SPEC  = L == 3?  0 : 20;  // shift of the CRC-protected spec
+    unsigned const  SYM   = L == 3?  3 : 23;
+    uint64_t const  STAMP = L == 3? UINT64_C(0xFFF00000000) : UINT64_C(0xFFFFF);
+    uint64_t const  COUNT = L == 3? UINT64_C(0xFFFFFFFF)    : UINT64_C(0xFFFFFFFFFFF);
+    uint64_t const  CRC0  = DBEntry::CRC3[0];
+    uint64_t const  CRC1  = DBEntry::CRC3[1];
+    uint64_t const  CRC2  = DBEntry::CRC3[2];
+
+    uint64_t  invalid  = 0;
+    uint64_t  taken    = 0;
+    uint64_t  solved   = 0;
+    uint64_t  wrapped  = 0;
+    uint64_t  count    = 0;
+    uint64_t  countAll = 0;
+    uint64_t  mod13    = 0;
+    uint64_t  mod15    = 0;
+    uint64_t  mod13All = 0;
+    uint64_t  mod15All = 0;
+    for(size_t  i = 0; i < n; i++) {
+      uint64_t const  s = __builtin_bswap64(raw[2*i]);
+      uint64_t const  o = __builtin_bswap64(raw[2*i+1]);
+
+      uint64_t const  v = s >> SPEC;
+      invalid += parity(v & CRC0) | parity(v & CRC1) | parity(v & CRC2);
+
+      uint64_t const  sol = L == 3? o & ~STAMP : o;
+      uint64_t const  fin = sol != 0;
+      solved += fin;
+      taken  += (fin ^ 1) & ((L == 3? o : s) & STAMP? 1 : 0);
+
+      uint64_t const  cnt = sol & COUNT;
+      uint64_t const  r13 = (sol >> 48) & 15;
+      uint64_t const  r15 = (sol >> 44) & 15;
+      uint64_t const  sym = (s >> SYM) & 3;
+      count    += cnt;
+      countAll += cnt << sym;
+      mod13    += r13;
+      mod15    += r15;
+      mod13All += r13 << sym;
+      mod15All += r15 << sym;
+
+      uint32_t const  dig = uint32_t((cnt & 0xFFF) + ((cnt >> 12) & 0xFFF) + ((cnt >> 24) & 0xFFF) + (cnt >> 36));
+      wrapped += (dig%13 != r13) | (dig%15 != r15);
+    }
+    st.entries  = n;
+    st.invalid  = invalid;
+    st.taken    = taken;
+    st.solved   = solved;
+    st.wrapped  = wrapped;
+    st.count    = count;
+    st.countAll = countAll;
+    st.mod13    = mod13    % 13;
+    st.mod15    = mod15    % 15;
+    st.mod13All = mod13All % 13;
+    st.mod15All = mod15All % 15;
+
+  } // scanLanes()
+
+} // anonymous namespace
+
+//- Construction -------------------------------------------------------------
+DBStats::DBStats()
+  : entries(0), invalid(0), taken(0), solved(0), wrapped(0), gapped(0),
+    count(0), mod13(0), mod15(0), countAll(0), mod13All(0), mod15All(0),
+    m_tail(0) {}
+
+DBStats::DBStats(DBConstRange const &range, unsigned  threads, bool const  vectorize) : DBStats() {
+  DBEntry const *const  beg = range.begin();
+  unsigned const  L     = range.rings();
+  size_t  const  n      = range.size();
+  size_t  const  chunks = (n + CHUNK-1) / CHUNK;
+  if(threads == 0)  threads = std::thread::hardware_concurrency();
+  if(threads > chunks)  threads = chunks;
+
+  // Chunks are claimed dynamically and merged in order.
+  std::vector<DBStats>  parts(chunks);
+  std::atomic<size_t>   next(0);
+  auto const  work = [&]() {
+    for(size_t  c; (c = next++) < chunks;) {
+      DBEntry const *const  cb = beg + c*CHUNK;
+      parts[c] = chunk(cb, c+1 < chunks? cb + CHUNK : beg + n, L, vectorize);
+    }
+  };
+  std::vector<std::thread>  pool;
+  for(unsigned  t = 1; t < threads; t++)  pool.emplace_back(work);
+  work();
+  for(std::thread &t : pool)  t.join();
+
+  for(DBStats const &st : parts)  *this += st;
+}
+
+DBStats DBStats::chunk(DBEntry const *const  beg, DBEntry const *const  end,
+		       unsigned const  L, bool const  vectorize) {
+  static void (*const  scanner)(DBStats&, DBEntry const*, DBEntry const*, unsigned) =
+    __builtin_cpu_supports("avx512bw")? scan512 :
+    __builtin_cpu_supports("avx2")?     scanAVX2 : scan;
+
+  DBStats  st;
+  (vectorize? scanner : scanEntries)(st, beg, end, L);
+
+  // Gap Accounting: the unsolved entries after the last solved one may
+  // only be attributed to a gap by the following chunks.
+  DBEntry const *p = end;
+  while((p != beg) && !p[-1].solved(L))  p--;
+  st.m_tail = end - p;
+  st.gapped = (st.entries - st.solved) - st.m_tail;
+  return  st;
+}
+
+//- Merging ------------------------------------------------------------------
+DBStats& DBStats::operator+=(DBStats const &o) {
+  entries  += o.entries;
+  invalid  += o.invalid;
+  taken    += o.taken;
+  wrapped  += o.wrapped;
+  count    += o.count;
+  mod13     = (mod13 + o.mod13) % 13;
+  mod15     = (mod15 + o.mod15) % 15;
+  countAll += o.countAll;
+  mod13All  = (mod13All + o.mod13All) % 13;
+  mod15All  = (mod15All + o.mod15All) % 15;
+  if(o.solved > 0) {
+    gapped += m_tail + o.gapped;
+    m_tail  = o.m_tail;
+  }
+  else  m_tail += o.entries;
+  solved += o.solved;
+  return *this;
+}
+
+//- Chunk Scans --------------------------------------------------------------
+void DBStats::scanEntries(DBStats &st, DBEntry const *const  beg, DBEntry const *const  end, unsigned const  L) {
+  // The plain accessor loop, which serves as the reference.
+  uint64_t  mod13 = 0, mod15 = 0, mod13All = 0, mod15All = 0;
+  st.entries = end - beg;
+  for(DBEntry const *e = beg; e != end; e++) {
+    if(!e->valid(L))  st.invalid++;
+    if(!e->solved(L)) {
+      if(e->taken(L))  st.taken++;
+      continue;
+    }
+    st.solved++;
+    if(e->wrapped(L))  st.wrapped++;
+    uint64_t const  cnt = e->count(L);
+    unsigned const  w   = e->sym(L).weight();
+    st.count    += cnt;
+    st.countAll += w*cnt;
+    mod13       += e->mod13();
+    mod15       += e->mod15();
+    mod13All    += w*e->mod13();
+    mod15All    += w*e->mod15();
+  }
+  st.mod13    = mod13    % 13;
+  st.mod15    = mod15    % 15;
+  st.mod13All = mod13All % 13;
+  st.mod15All = mod15All % 15;
+}
+
+void DBStats::scan(DBStats &st, DBEntry const *const  beg, DBEntry const *const  end, unsigned const  L) {
+  if(L == 3)  scanLanes<3>(st, reinterpret_cast<uint64_t const*>(beg), end-beg);
+  else        scanLanes<2>(st, reinterpret_cast<uint64_t const*>(beg), end-beg);
+}
+
+__attribute__((target("avx2")))
+void DBStats::scanAVX2(DBStats &st, DBEntry const *const  beg, DBEntry const *const  end, unsigned const  L) {
+  if(L == 3)  scanLanes<3>(st, reinterpret_cast<uint64_t const*>(beg), end-beg);
+  else        scanLanes<2>(st, reinterpret_cast<uint64_t const*>(beg), end-beg);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void DBStats::scan512(DBStats &st, DBEntry const *const  beg, DBEntry const *const  end, unsigned const  L) {
+  if(L == 3)  scanLanes<3>(st, reinterpret_cast<uint64_t const*>(beg), end-beg);
+  else        scanLanes<2>(st, reinterpret_cast<uint64_t const*>(beg), end-beg);
+}
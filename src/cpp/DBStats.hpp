@@ -0,0 +1,94 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef QUEENS_DBSTATS_HPP
+#define QUEENS_DBSTATS_HPP
+
+#include "Database.hpp"
+
+#include <cstdint>
+
+namespace queens {
+
+ /**
+  * Entry statistics and solution totals of a database range as reported by
+  * q27db stats.
+  *
+  * A range is scanned in chunks by all threads. Each chunk is decoded by a
+  * branch-free loop, which the compiler vectorizes for the AVX2 and AVX-512
+  * entry points: the big-endian words are swapped in lanes, the CRC is
+  * checked by three parities, and the residues are accumulated as plain
+  * sums reduced only once per chunk. The chunk results are merged in range
+  * order so that the totals and the unsolved gaps spanning chunk
+  * boundaries are exactly those of a sequential scan.
+  */
+  class DBStats {
+    friend class ZoneMap;
+
+  public:
+    uint64_t  entries;
+    uint64_t  invalid;
+    uint64_t  taken;    // but not solved
+    uint64_t  solved;
+    uint64_t  wrapped;
+    uint64_t  gapped;   // unsolved but followed by a solved entry
+
+    uint64_t  count;    // fundamental solutions
+    unsigned  mod13;
+    unsigned  mod15;
+    uint64_t  countAll; // all solutions
+    unsigned  mod13All;
+    unsigned  mod15All;
+
+  private:
+    uint64_t  m_tail;   // unsolved entries after the last solved one
+
+    //- Construction ---------------------------------------------------------
+  public:
+    DBStats();
+
+    /**
+     * Scans the given range on the given number of threads, all cores if
+     * zero. The chunks are decoded by the widest supported vector code
+     * unless vectorize is false, which selects the plain accessor loop.
+     */
+    DBStats(DBConstRange const &range, unsigned  threads = 0, bool  vectorize = true);
+
+    // Scans the given chunk of entries of the layout of the given number of
+    // rings on the calling thread.
+    static DBStats chunk(DBEntry const *beg, DBEntry const *end, unsigned  rings, bool  vectorize = true);
+
+    //- Merging --------------------------------------------------------------
+  public:
+    // Appends the statistics of the range immediately following this one.
+    DBStats& operator+=(DBStats const &o);
+
+    //- Chunk Scans ----------------------------------------------------------
+  private:
+    static void scanEntries(DBStats &st, DBEntry const *beg, DBEntry const *end, unsigned  rings);
+    static void scan       (DBStats &st, DBEntry const *beg, DBEntry const *end, unsigned  rings);
+    static void scanAVX2   (DBStats &st, DBEntry const *beg, DBEntry const *end, unsigned  rings);
+    static void scan512    (DBStats &st, DBEntry const *beg, DBEntry const *end, unsigned  rings);
+
+  }; // class DBStats
+
+} // namespace queens
+
+#endif
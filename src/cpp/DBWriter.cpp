@@ -0,0 +1,311 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "DBWriter.hpp"
+
+#include <cstdlib>
+#include <new>
+#include <system_error>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace queens;
+
+namespace {
+  struct {
+    char const       *name;
+    DBWriter::Mode    mode;
+  } const  MODES[] = {
+    { "buffered", DBWriter::BUFFERED },
+    { "direct",   DBWriter::DIRECT   },
+    { "mapped",   DBWriter::MAPPED   }
+  };
+}
+
+bool DBWriter::parseMode(char const *const  name, Mode &mode) {
+  for(auto const &m : MODES) {
+    if(strcmp(m.name, name) == 0) {
+      mode = m.mode;
+      return  true;
+    }
+  }
+  return  false;
+}
+char const *DBWriter::modeName(Mode const  mode) {
+  return  MODES[mode].name;
+}
+
+//- DBWriter -----------------------------------------------------------------
+DBWriter::DBWriter(char const *const  file, Mode const  mode, bool const  keep)
+  : m_name(file), m_mode(mode), m_fd(-1), m_fdb(-1),
+    m_closing(false), m_error(0), m_size(0), m_alloc(0),
+    m_submitted(0), m_completed(0) {
+
+  int const  flags = O_CREAT|(keep? 0 : O_TRUNC)|(mode == MAPPED? O_RDWR : O_WRONLY);
+  m_fd = ::open(file, flags|(mode == DIRECT? O_DIRECT : 0), 0666);
+  if(m_fd < 0)  fail("Cannot open");
+  if(keep) {
+    // Mapped windows must not shrink the kept contents.
+    struct stat  st;
+    if(fstat(m_fd, &st) != 0)  fail("Cannot open");
+    m_alloc = st.st_size;
+  }
+  m_fdb = m_fd;
+  if(mode == DIRECT) {
+    m_fdb = ::open(file, O_WRONLY);
+    if(m_fdb < 0)  fail("Cannot open");
+  }
+  m_flusher = std::thread(&DBWriter::run, this);
+}
+
+DBWriter::~DBWriter() {
+  try {
+    close();
+  }
+  catch(std::system_error const&) {}
+}
+
+void DBWriter::preallocate(uint64_t const  entries) {
+  off_t const  size = entries * sizeof(DBEntry);
+  int   const  res  = posix_fallocate(m_fd, 0, size);
+  if(res != 0) {
+    // Not supported by the file system: at least establish the size.
+    if(((res != EOPNOTSUPP) && (res != EINVAL)) || (ftruncate(m_fd, size) != 0)) {
+      errno = res;
+      fail("Cannot allocate");
+    }
+  }
+  std::lock_guard<std::mutex>  lk(m_lock);
+  if(size > m_alloc)  m_alloc = size;
+  if(size > m_size)   m_size  = size;
+}
+
+void DBWriter::sync() {
+  check();
+  if(fdatasync(m_fd) != 0)  fail("Cannot sync");
+}
+
+void DBWriter::close() {
+  if(m_fd < 0)  return;
+  {
+    std::lock_guard<std::mutex>  lk(m_lock);
+    m_closing = true;
+  }
+  m_cond.notify_all();
+  m_flusher.join();
+
+  bool  ok = ftruncate(m_fd, m_size) == 0;
+  if(m_fdb != m_fd)  ok &= ::close(m_fdb) == 0;
+  ok &= ::close(m_fd) == 0;
+  m_fd = m_fdb = -1;
+  if(!ok)  fail("Cannot write");
+  check();
+}
+
+uint64_t DBWriter::submit(Job const &job) {
+  uint64_t  seq;
+  {
+    std::lock_guard<std::mutex>  lk(m_lock);
+    m_jobs.push_back(job);
+    if(job.base + (off_t)job.to > m_size)  m_size = job.base + job.to;
+    seq = ++m_submitted;
+  }
+  m_cond.notify_all();
+  return  seq;
+}
+
+void DBWriter::await(uint64_t const  seq) {
+  std::unique_lock<std::mutex>  lk(m_lock);
+  while(m_completed < seq)  m_cond.wait(lk);
+}
+
+void DBWriter::extend(off_t const  end) {
+  std::lock_guard<std::mutex>  lk(m_lock);
+  if(end > m_alloc) {
+    if(ftruncate(m_fd, end) != 0)  fail("Cannot extend");
+    m_alloc = end;
+  }
+}
+
+void DBWriter::check() {
+  int  err;
+  {
+    std::lock_guard<std::mutex>  lk(m_lock);
+    err = m_error;
+  }
+  if(err != 0) {
+    errno = err;
+    fail("Cannot write");
+  }
+}
+
+void DBWriter::fail(char const *const  what) {
+  throw  std::system_error(errno, std::system_category(), std::string(what) + ' ' + m_name);
+}
+
+void DBWriter::run() {
+  std::unique_lock<std::mutex>  lk(m_lock);
+  while(true) {
+    if(m_jobs.empty()) {
+      if(m_closing)  return;
+      m_cond.wait(lk);
+      continue;
+    }
+    Job const  job = m_jobs.front();
+    m_jobs.pop_front();
+
+    lk.unlock();
+    perform(job);
+    lk.lock();
+
+    if(m_mode != MAPPED)  job.stream->release(job.buf);
+    m_completed++;
+    m_cond.notify_all();
+  }
+}
+
+void DBWriter::perform(Job const &job) {
+  int  err = 0;
+  if(m_mode == MAPPED) {
+    if(munmap(job.buf, job.len) != 0)  err = errno;
+  }
+  else {
+    // Writes [lo, hi) of the buffer through the descriptor fd.
+    auto const  put = [&](int const  fd, size_t  lo, size_t const  hi) {
+      while((lo < hi) && (err == 0)) {
+	ssize_t const  k = pwrite(fd, job.buf+lo, hi-lo, job.base+lo);
+	if(k > 0)  lo += k;
+	else if((k < 0) && (errno != EINTR))  err = errno;
+      }
+    };
+    if(m_mode == DIRECT) {
+      // Aligned middle part bypassing the page cache
+      size_t const  a = (job.from + ALIGN-1) & ~(ALIGN-1);
+      size_t const  b =  job.to              & ~(ALIGN-1);
+      if(a < b) {
+	put(m_fdb, job.from, a);
+	put(m_fd,  a, b);
+	put(m_fdb, b, job.to);
+      }
+      else  put(m_fdb, job.from, job.to);
+    }
+    else  put(m_fd, job.from, job.to);
+  }
+  if(err != 0) {
+    std::lock_guard<std::mutex>  lk(m_lock);
+    if(m_error == 0)  m_error = err;
+  }
+}
+
+//- DBWriter::Stream ---------------------------------------------------------
+DBWriter::Stream::Stream(DBWriter &writer, uint64_t const  first)
+  : m_writer(writer), m_buf{nullptr, nullptr}, m_busy{false, false}, m_cur(0),
+    m_win(nullptr), m_seq(0) {
+  if(writer.m_mode != MAPPED) {
+    for(char *&b : m_buf) {
+      void *p;
+      if(posix_memalign(&p, ALIGN, BUFFER) != 0)  throw  std::bad_alloc();
+      b = static_cast<char*>(p);
+    }
+  }
+  open(first * sizeof(DBEntry));
+}
+
+DBWriter::Stream::~Stream() {
+  if(m_win != nullptr)  hand();
+  m_win = nullptr;
+  {
+    std::unique_lock<std::mutex>  lk(m_writer.m_lock);
+    while(m_busy[0] || m_busy[1])  m_writer.m_cond.wait(lk);
+  }
+  free(m_buf[0]);
+  free(m_buf[1]);
+}
+
+void DBWriter::Stream::close() {
+  if(m_win != nullptr) {
+    hand();
+    m_win = nullptr;
+    m_ptr = m_end = nullptr;
+  }
+  {
+    std::unique_lock<std::mutex>  lk(m_writer.m_lock);
+    while(m_busy[0] || m_busy[1])  m_writer.m_cond.wait(lk);
+  }
+  m_writer.check();
+}
+
+void DBWriter::Stream::sync() {
+  off_t const  pos = m_base + (m_ptr - m_win);
+  hand();
+  m_writer.await(m_seq);
+  m_writer.sync();
+  open(pos);
+}
+
+void DBWriter::Stream::open(off_t const  pos) {
+  m_base = pos & ~(off_t)(ALIGN-1);
+  if(m_writer.m_mode == MAPPED) {
+    m_len = WINDOW;
+    m_writer.extend(m_base + m_len);
+    void *const  p = mmap(nullptr, m_len, PROT_READ|PROT_WRITE, MAP_SHARED, m_writer.m_fd, m_base);
+    if(p == MAP_FAILED)  m_writer.fail("Cannot map");
+    m_win = static_cast<char*>(p);
+  }
+  else {
+    m_len = BUFFER;
+    m_win = m_buf[m_cur];
+  }
+  m_start = m_ptr = m_win + (pos - m_base);
+  m_end   = m_win + m_len;
+}
+
+void DBWriter::Stream::hand() {
+  Job const  job = { this, m_win, m_len, m_base,
+		     (size_t)(m_start-m_win), (size_t)(m_ptr-m_win) };
+  if(m_writer.m_mode != MAPPED) {
+    if(job.from == job.to)  return;
+    std::lock_guard<std::mutex>  lk(m_writer.m_lock);
+    m_busy[m_cur] = true;
+  }
+  m_seq = m_writer.submit(job);
+}
+
+void DBWriter::Stream::next() {
+  off_t const  pos = m_base + m_len;
+  hand();
+  if(m_writer.m_mode != MAPPED) {
+    m_cur ^= 1;
+    std::unique_lock<std::mutex>  lk(m_writer.m_lock);
+    while(m_busy[m_cur])  m_writer.m_cond.wait(lk);
+  }
+  m_writer.check();
+  open(pos);
+}
+
+void DBWriter::Stream::release(char *const  buf) {
+  // Called by the flusher holding the writer lock
+  if(buf == m_buf[0])  m_busy[0] = false;
+  if(buf == m_buf[1])  m_busy[1] = false;
+}
@@ -0,0 +1,192 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef QUEENS_DBWRITER_HPP
+#define QUEENS_DBWRITER_HPP
+
+#include "DBEntry.hpp"
+
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <string.h>
+#include <sys/types.h>
+
+namespace queens {
+
+ /**
+  * Writer of database files for producing large numbers of entries.
+  *
+  * The entries are written through Streams, each of which fills its own
+  * region of the file starting at a given entry index. Thus, several
+  * threads may produce disjoint parts of a database concurrently. A Stream
+  * collects the entries in large page-aligned buffers and hands full
+  * buffers to a background thread of the writer so that the producer only
+  * blocks on I/O when it has run a full buffer ahead. The I/O is performed
+  * in one of three modes:
+  *
+  *  BUFFERED - pwrite() through the page cache,
+  *  DIRECT   - pwrite() with O_DIRECT bypassing the page cache; the
+  *             unaligned head and tail of a Stream go through the page cache,
+  *  MAPPED   - copying into mmap'ed windows of the file, which are
+  *             unmapped in the background.
+  *
+  * I/O errors raise a std::system_error. Those encountered in the
+  * background are reported by the next Stream or writer operation.
+  */
+  class DBWriter {
+  public:
+    enum Mode { BUFFERED, DIRECT, MAPPED };
+
+    // Returns the mode of the given name or false if there is none.
+    static bool parseMode(char const *name, Mode &mode);
+    static char const *modeName(Mode  mode);
+
+    class Stream;
+
+  private:
+    // Size of the Buffers and mapped Windows of a Stream
+    static size_t const  ALIGN  = 4096;
+    static size_t const  BUFFER = 4 << 20;
+    static size_t const  WINDOW = 64 << 20;
+
+    // Background I/O Operation
+    struct Job {
+      Stream *stream;
+      char   *buf;     // buffer or mapped window
+      size_t  len;     // length of the buffer or window
+      off_t   base;    // file offset of buf
+      size_t  from;    // valid data within buf
+      size_t  to;
+    };
+
+    std::string const  m_name;
+    Mode        const  m_mode;
+    int                m_fd;   // primary descriptor
+    int                m_fdb;  // buffered descriptor for unaligned DIRECT I/O
+
+    std::mutex               m_lock;
+    std::condition_variable  m_cond;
+    std::deque<Job>          m_jobs;
+    std::thread              m_flusher;
+    bool                     m_closing;
+    int                      m_error;  // first background errno
+    off_t                    m_size;   // end of the written data
+    off_t                    m_alloc;  // current file size (MAPPED)
+    uint64_t                 m_submitted;  // sequence numbers of the jobs
+    uint64_t                 m_completed;
+
+    //- Construction / Destruction -------------------------------------------
+  public:
+    // Opens the file, which is truncated unless its contents are to be
+    // kept for resuming an interrupted output.
+    DBWriter(char const *file, Mode  mode = BUFFERED, bool  keep = false);
+    ~DBWriter();
+
+  private:
+    DBWriter(DBWriter const&) = delete;
+    DBWriter& operator=(DBWriter const&) = delete;
+
+    //- Usage Interface ------------------------------------------------------
+  public:
+    Mode mode() const { return  m_mode; }
+
+    // Reserves the disk space for the given number of entries, which the
+    // file will at least comprise when closed.
+    void preallocate(uint64_t  entries);
+
+    // Forces the data written by completed I/O operations to disk.
+    void sync();
+
+    // Completes all Streams' I/O and truncates the file to the end of
+    // the written entries.
+    void close();
+
+    //- Stream Support -------------------------------------------------------
+  private:
+    uint64_t submit(Job const &job);
+    void await(uint64_t  seq);
+    void extend(off_t  end);
+    void check();
+
+    void run();
+    void perform(Job const &job);
+    void fail(char const *what);
+
+  }; // class DBWriter
+
+ /**
+  * A sequential producer of entries writing into a DBWriter. The Stream
+  * is completed by close() or its destruction. Streams must be completed
+  * before their writer.
+  */
+  class DBWriter::Stream {
+    DBWriter &m_writer;
+
+    char   *m_buf[2];  // BUFFERED / DIRECT: double buffer
+    bool    m_busy[2]; // buffer handed to the flusher
+    unsigned m_cur;
+
+    char   *m_win;     // current buffer or window
+    size_t  m_len;     // its length
+    off_t   m_base;    // its file offset
+    char   *m_start;   // first entry written to it
+    char   *m_ptr;     // next entry
+    char   *m_end;
+    uint64_t m_seq;    // last job submitted
+
+  public:
+    Stream(DBWriter &writer, uint64_t  first = 0);
+    ~Stream();
+
+  private:
+    Stream(Stream const&) = delete;
+    Stream& operator=(Stream const&) = delete;
+
+  public:
+    void write(DBEntry const &e) {
+      if(m_ptr == m_end)  next();
+      memcpy(m_ptr, &e, sizeof(DBEntry));
+      m_ptr += sizeof(DBEntry);
+    }
+    void write(DBEntry const *beg, DBEntry const *end) {
+      while(beg < end)  write(*beg++);
+    }
+    void close();
+
+    // Forces the entries written so far to disk.
+    void sync();
+
+  private:
+    friend class DBWriter;
+    void open(off_t  pos);
+    void next();
+    void hand();
+    void release(char *buf);
+
+  }; // class DBWriter::Stream
+
+} // namespace queens
+
+#endif
@@ -20,6 +20,12 @@
  ****************************************************************************/
 #include "Database.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+
+#include <time.h>
+#include <sys/mman.h>
+
 using namespace queens;
 
 DBEntry const *DBConstRange::lub(uint64_t  spec) const {
@@ -28,16 +34,17 @@ DBEntry const *DBConstRange::lub(uint64_t  spec) const {
   if(lo >= hi)  return  hi;
   hi--;
 
+  unsigned const  L = m_rings;
   spec &= ~UINT64_C(0x1F); // ignore symmetry and CRC
-  if(spec <= lo->spec())  return  lo;
-  if(spec >  hi->spec())  return  end();
+  if(spec <= lo->spec(L))  return  lo;
+  if(spec >  hi->spec(L))  return  end();
 
   // Invariant: lo->spec() < spec <= hi->spec()
   while(true) {
     size_t const  m = (hi-lo)/2;
     if(m == 0)  return  hi;
     DBEntry const *const  mid = lo+m;
-    if(spec <= mid->spec())  hi = mid;
+    if(spec <= mid->spec(L))  hi = mid;
     else                     lo = mid;
   }
 }
@@ -47,16 +54,67 @@ DBEntry const *DBConstRange::glb(uint64_t  spec) const {
   if(lo >= hi)  return  nullptr;
   hi--;
 
+  unsigned const  L = m_rings;
   spec |= UINT64_C(0x1F); // ignore symmetry and CRC
-  if(spec <  lo->spec())  return  nullptr;
-  if(spec >= hi->spec())  return  hi;
+  if(spec <  lo->spec(L))  return  nullptr;
+  if(spec >= hi->spec(L))  return  hi;
 
   // Invariant: lo->spec() <= spec < hi->spec()
   while(true) {
     size_t const  m = (hi-lo)/2;
     if(m == 0)  return  lo;
     DBEntry const *const  mid = lo+m;
-    if(spec < mid->spec())  hi = mid;
+    if(spec < mid->spec(L))  hi = mid;
     else                    lo = mid;
   }
 }
+
+Database::Database(char const *const  file, boost::iostreams::mapped_file::mapmode const  mode,
+		   unsigned const  rings)
+  : boost::iostreams::mapped_file(file, mode), m_name(file), m_rings(rings) {
+  DBEntry const *const  beg = reinterpret_cast<DBEntry const*>(boost::iostreams::mapped_file::const_data());
+  unsigned       const  r   = DBEntry::layout(beg, beg+size());
+  if((r != 0) && (rings != 0) && (r != rings)) {
+    throw  std::runtime_error(m_name + ": Entries of " + std::to_string(r) + " rings where " +
+			      std::to_string(rings) + " are expected.");
+  }
+  if(m_rings == 0)  m_rings = r == 0? 2 : r;
+}
+
+bool Database::flush() {
+  char *const  beg = boost::iostreams::mapped_file::data();
+  if(beg == nullptr)  return  true;
+  return  msync(beg, boost::iostreams::mapped_file::size(), MS_SYNC) == 0;
+}
+
+DBCursor::DBCursor(DBRange const &range, unsigned const  worker, unsigned const  workers, unsigned const  timeout)
+  : m_range(range), m_blocks((range.size()+BLOCK-1)/BLOCK),
+    m_worker(worker), m_workers(workers == 0? 1 : workers),
+    m_timeout(60*time_t(timeout)),
+    m_block(worker), m_ofs(0), m_swept(0) {}
+
+DBEntry *DBCursor::claim() {
+  DBEntry *const  beg   = m_range.begin();
+  size_t   const  n     = m_range.size();
+  unsigned const  L     = m_range.rings();
+  time_t   const  stale = m_timeout == 0? 0 : ::time(NULL) - m_timeout;
+  while(true) {
+    if(m_block < m_blocks) {
+      size_t const  base = m_block*BLOCK;
+      size_t const  end  = std::min(base+BLOCK, n);
+      while(base+m_ofs < end) {
+	DBEntry *const  e = beg + base + m_ofs++;
+	if(!e->solved(L) && e->valid(L) && e->claim(L, stale))  return  e;
+      }
+    }
+
+    // Next own Block, then sweep all Blocks starting at the own first
+    m_ofs = 0;
+    if(m_swept == 0) {
+      m_block += m_workers;
+      if(m_block < m_blocks)  continue;
+    }
+    if(m_swept >= m_blocks)  return  nullptr;
+    m_block = (m_worker + m_swept++) % m_blocks;
+  }
+}
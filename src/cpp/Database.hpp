@@ -23,6 +23,8 @@
 
 #include "DBEntry.hpp"
 
+#include <string>
+
 #include <boost/iostreams/device/mapped_file.hpp>
 
 namespace queens {
@@ -30,16 +32,19 @@ namespace queens {
   class DBConstRange {
     DBEntry const *m_beg;
     DBEntry const *m_end;
+    unsigned       m_rings;
 
   public:
-    DBConstRange(DBEntry const *const  beg, DBEntry const *const  end)
-      : m_beg(beg), m_end(end) {}
+    // The entries from beg to end of the layout of the given number of rings.
+    DBConstRange(DBEntry const *const  beg, DBEntry const *const  end, unsigned const  rings)
+      : m_beg(beg), m_end(end), m_rings(rings) {}
     ~DBConstRange() {}
 
   public:
     size_t         size()  const { return  m_end - m_beg; }
     DBEntry const *begin() const { return  m_beg; }
     DBEntry const *end()   const { return  m_end; }
+    unsigned       rings() const { return  m_rings; }
 
     // The search bounds requires a sorted DBRange.
     DBEntry const *lub(uint64_t  spec) const;
@@ -49,8 +54,8 @@ namespace queens {
   class DBRange : public DBConstRange {
 
   public:
-    DBRange(DBEntry *const  beg, DBEntry *const  end)
-      : DBConstRange(beg, end) {}
+    DBRange(DBEntry *const  beg, DBEntry *const  end, unsigned const  rings)
+      : DBConstRange(beg, end, rings) {}
     ~DBRange() {}
 
   public:
@@ -62,24 +67,75 @@ namespace queens {
     DBEntry *glb(uint64_t  spec) { return  const_cast<DBEntry*>(DBConstRange::glb(spec)); }
   };
 
+  /**
+   * Claim cursor of one of a number of workers sharing a DBRange, be they
+   * threads or processes mapping the same database. The range is divided
+   * into blocks dealt out round-robin so that each worker first claims
+   * from its own blocks without contending with the others. Workers done
+   * with their own blocks sweep all of them for the entries left over,
+   * checking each entry as the claims of other processes on differently
+   * aligned ranges need not progress through these blocks front to back.
+   * Claims are taken by DBEntry::claim() so that no coordinator is needed.
+   */
+  class DBCursor {
+  public:
+    static size_t const  BLOCK = 256;  // entries, 4 KiB
+
+  private:
+    DBRange   const  m_range;
+    size_t    const  m_blocks;
+    size_t    const  m_worker;
+    size_t    const  m_workers;
+    time_t    const  m_timeout; // reclaim entries taken longer ago, in seconds
+    size_t           m_block;   // current block
+    size_t           m_ofs;     // within the current block
+    size_t           m_swept;   // blocks swept, or 0 before the sweep
+
+  public:
+    // Cursor of the given worker out of workers. Entries taken more than
+    // timeout minutes ago are reclaimed unless timeout is zero.
+    DBCursor(DBRange const &range, unsigned  worker, unsigned  workers, unsigned  timeout = 0);
+    ~DBCursor() {}
+
+  public:
+    // Claims the next valid entry or returns nullptr if there is none left.
+    DBEntry *claim();
+  };
+
   class Database : private boost::iostreams::mapped_file {
+    std::string const  m_name;
+    unsigned           m_rings;
+
   public:
-    Database(char const *file, boost::iostreams::mapped_file::mapmode  mode)
-      : boost::iostreams::mapped_file(file, mode) {}
+    // Maps the database file, whose entries must be of the layout of the
+    // given number of rings. A zero rings takes the layout detected from
+    // the entries, two rings if it is undecided as for an empty file.
+    // Throws a std::runtime_error if the detected layout does not match.
+    Database(char const *file, boost::iostreams::mapped_file::mapmode  mode, unsigned  rings = 0);
     ~Database() {}
 
   public:
+    // The file name the database was opened by.
+    char const *name() const { return  m_name.c_str(); }
+
+    // The number of pre-placed rings of the entries selecting their layout.
+    unsigned rings() const { return  m_rings; }
+
     size_t size() const {
       return  boost::iostreams::mapped_file::size()/sizeof(DBEntry);
     }
     DBConstRange roRange() const {
       DBEntry const *const  beg = reinterpret_cast<DBEntry const*>(boost::iostreams::mapped_file::const_data());
-      return DBConstRange(beg, beg+size());
+      return DBConstRange(beg, beg+size(), m_rings);
     }
     DBRange rwRange() {
       DBEntry *const  beg = reinterpret_cast<DBEntry*>(boost::iostreams::mapped_file::data());
-      return  DBRange(beg, beg == nullptr? nullptr : beg+size());
+      return  DBRange(beg, beg == nullptr? nullptr : beg+size(), m_rings);
     }
+
+    // Writes modified entries of a read-write mapping back to the file.
+    // Returns false if the system refused to do so.
+    bool flush();
   };
 }
 #endif
@@ -0,0 +1,117 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Journal.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace queens;
+
+Journal::Journal(char const *const  file, std::string const &tag)
+  : m_name(file), m_tag(tag), m_fd(-1) {
+
+  m_fd = ::open(file, O_RDWR|O_CREAT|O_APPEND, 0666);
+  if(m_fd < 0)  fail("Cannot open");
+
+  // Read the complete Journal
+  std::string  text;
+  {
+    char     buf[1<<16];
+    ssize_t  k;
+    while((k = ::read(m_fd, buf, sizeof(buf))) != 0) {
+      if(k > 0)  text.append(buf, k);
+      else if(errno != EINTR)  fail("Cannot read");
+    }
+  }
+
+  // A line torn by a crash is dropped so that appending continues cleanly.
+  size_t const  end = text.rfind('\n') + 1;
+  if(end < text.size()) {
+    if(ftruncate(m_fd, end) != 0)  fail("Cannot truncate");
+    text.resize(end);
+  }
+
+  std::string const  header = "# " + tag;
+  if(text.empty())  write(header);
+
+  std::istringstream  in(text);
+  std::string         line;
+  unsigned            no = 0;
+  while(std::getline(in, line)) {
+    no++;
+    if(line.empty())  continue;
+    if(line[0] == '#') {
+      // Concatenated journals repeat the header.
+      if(line != header) {
+	throw  std::runtime_error(m_name + ':' + std::to_string(no) + ": Journal of a different computation: " + line);
+      }
+      continue;
+    }
+
+    std::istringstream  fields(line);
+    unsigned  part;
+    Record    rec;
+    uint64_t  val;
+    if(!(fields >> part))  throw  std::runtime_error(m_name + ':' + std::to_string(no) + ": Malformed record.");
+    while(fields >> val)  rec.push_back(val);
+    if(!fields.eof())  throw  std::runtime_error(m_name + ':' + std::to_string(no) + ": Malformed record.");
+
+    auto const  res = m_done.insert(std::make_pair(part, rec));
+    if(!res.second && (res.first->second != rec)) {
+      throw  std::runtime_error(m_name + ':' + std::to_string(no) + ": Conflicting records of partition " + std::to_string(part) + '.');
+    }
+  }
+}
+
+Journal::~Journal() {
+  if(m_fd >= 0)  ::close(m_fd);
+}
+
+void Journal::record(unsigned const  part, Record const &rec) {
+  std::ostringstream  line;
+  line << part;
+  for(uint64_t const  v : rec)  line << ' ' << v;
+
+  std::lock_guard<std::mutex>  lk(m_lock);
+  write(line.str());
+  m_done[part] = rec;
+}
+
+void Journal::write(std::string const &line) {
+  std::string const  buf = line + '\n';
+  size_t  ofs = 0;
+  while(ofs < buf.size()) {
+    ssize_t const  k = ::write(m_fd, buf.data()+ofs, buf.size()-ofs);
+    if(k > 0)  ofs += k;
+    else if((k < 0) && (errno != EINTR))  fail("Cannot write");
+  }
+  if(fsync(m_fd) != 0)  fail("Cannot sync");
+}
+
+void Journal::fail(char const *const  what) const {
+  throw  std::system_error(errno, std::system_category(), std::string(what) + " journal " + m_name);
+}
@@ -0,0 +1,96 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef QUEENS_JOURNAL_HPP
+#define QUEENS_JOURNAL_HPP
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace queens {
+
+ /**
+  * Durable journal of the completed partitions of a long computation.
+  *
+  * Each completed partition is appended as a text line of its index and
+  * a record of numbers, which is forced to disk before record() returns.
+  * A restarted computation reads the journal and skips the partitions
+  * recorded in it. The journal starts with a header line identifying the
+  * computation so that it cannot be resumed by a different one:
+  *
+  *   # <tag>
+  *   <partition> <value> ...
+  *
+  * As the lines are independent, the journals of disjoint partitions
+  * computed on different machines can simply be concatenated.
+  *
+  * Errors are reported by a std::runtime_error.
+  */
+  class Journal {
+  public:
+    typedef std::vector<uint64_t>  Record;
+
+  private:
+    std::string const  m_name;
+    std::string const  m_tag;
+    int                m_fd;
+
+    std::mutex                  m_lock;
+    std::map<unsigned, Record>  m_done;
+
+  public:
+    // Opens the journal of the computation identified by tag creating
+    // it if necessary.
+    Journal(char const *file, std::string const &tag);
+    ~Journal();
+
+  private:
+    Journal(Journal const&) = delete;
+    Journal& operator=(Journal const&) = delete;
+
+  public:
+    char const *name() const { return  m_name.c_str(); }
+
+    // All recorded partitions. The lookups must not be run concurrently
+    // with record().
+    std::map<unsigned, Record> const& records() const { return  m_done; }
+
+    // The record of the given partition or nullptr if it is not done.
+    Record const* find(unsigned  part) const {
+      auto const  it = m_done.find(part);
+      return  it == m_done.end()? nullptr : &it->second;
+    }
+    bool done(unsigned  part) const { return  find(part) != nullptr; }
+
+    // Durably records the given partition as completed. Thread-safe.
+    void record(unsigned  part, Record const &rec);
+
+  private:
+    void fail(char const *what) const;
+    void write(std::string const &line);
+
+  }; // class Journal
+
+} // namespace queens
+
+#endif
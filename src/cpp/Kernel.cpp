@@ -0,0 +1,318 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Kernel.hpp"
+
+#include <string.h>
+
+using namespace queens;
+
+Kernel const  Kernel::KERNELS[] = {
+  Kernel("recursive", Kernel::scalar<Kernel::recursive>, Kernel::always, Kernel::RECURSIVE),
+  Kernel("iterative", Kernel::scalar<Kernel::iterative>, Kernel::always, Kernel::ITERATIVE, true),
+  Kernel("avx512",    Kernel::avx512,                    Kernel::hasAVX512)
+};
+unsigned const  Kernel::NUM_KERNELS = sizeof(KERNELS)/sizeof(KERNELS[0]);
+
+Kernel const *Kernel::find(char const *const  name) {
+  for(Kernel const &k : KERNELS) {
+    if(strcmp(k.name, name) == 0)  return &k;
+  }
+  return  nullptr;
+}
+
+namespace {
+  inline unsigned popcount(uint64_t  x) {
+#ifdef __POPCNT__
+    return  __builtin_popcountll(x);
+#else
+    unsigned  c = 0;
+    for(; x != 0; x &= x-1)  c++;
+    return  c;
+#endif
+  }
+
+  uint64_t countCompletions(uint64_t  bv,
+			    uint64_t  bh,
+			    uint64_t  bu,
+			    uint64_t  bd,
+			    uint64_t &nodes) {
+
+    // Placement Complete?
+    if(bh+1 == 0)  return  1;
+
+    // -> at least one more queen to place
+    while((bv&1) != 0) { // Column is covered by pre-placement
+      bv >>= 1;
+      bu <<= 1;
+      bd >>= 1;
+    }
+    bv >>= 1;
+
+    // Column needs to be placed
+    uint64_t  cnt = 0;
+    for(uint64_t  slots = ~(bh|bu|bd); slots != 0;) {
+      uint64_t const  slot = slots & -slots;
+      nodes++;
+      cnt   += countCompletions(bv, bh|slot, (bu|slot) << 1, (bd|slot) >> 1, nodes);
+      slots ^= slot;
+    }
+    return  cnt;
+
+  } // countCompletions()
+}
+
+uint64_t Kernel::recursive(Blocking const &b, uint64_t &nodes) {
+  return  countCompletions(b.bv, b.bh, b.bu, b.bd, nodes);
+}
+
+namespace {
+ /**
+  * countCompletions() unrolled by the number D of queens still to place:
+  * the recursion bottoms out at compile time, and the last queen is
+  * merely checked for a free slot rather than placed by another call.
+  */
+  template<unsigned D>
+  uint64_t placeQueens(uint64_t  bv, uint64_t  bh, uint64_t  bu, uint64_t  bd, uint64_t &nodes) {
+    while((bv&1) != 0) {
+      bv >>= 1;
+      bu <<= 1;
+      bd >>= 1;
+    }
+    bv >>= 1;
+
+    uint64_t  cnt = 0;
+    for(uint64_t  slots = ~(bh|bu|bd); slots != 0;) {
+      uint64_t const  slot = slots & -slots;
+      nodes++;
+      cnt   += placeQueens<D-1>(bv, bh|slot, (bu|slot) << 1, (bd|slot) >> 1, nodes);
+      slots ^= slot;
+    }
+    return  cnt;
+  }
+  template<>
+  uint64_t placeQueens<1>(uint64_t  bv, uint64_t  bh, uint64_t  bu, uint64_t  bd, uint64_t &nodes) {
+    while((bv&1) != 0) {
+      bv >>= 1;
+      bu <<= 1;
+      bd >>= 1;
+    }
+    // A single free row is left: its slot completes the board if open.
+    uint64_t const  cnt = ~(bh|bu|bd) != 0? 1 : 0;
+    nodes += cnt;
+    return  cnt;
+  }
+
+  // Dispatches to placeQueens<D> for the up to N-4 queens a pre-placement
+  // of board dimension N leaves to place.
+  template<unsigned N, unsigned D = N-4>
+  struct RecursiveSearch {
+    static uint64_t count(Blocking const &b, uint64_t &nodes) {
+      return  dispatch(popcount(~b.bh), b, nodes);
+    }
+    static uint64_t dispatch(unsigned  d, Blocking const &b, uint64_t &nodes) {
+      return  d == D? placeQueens<D>(b.bv, b.bh, b.bu, b.bd, nodes)
+	            : RecursiveSearch<N, D-1>::dispatch(d, b, nodes);
+    }
+  };
+  template<unsigned N>
+  struct RecursiveSearch<N, 0> {
+    static uint64_t dispatch(unsigned, Blocking const&, uint64_t&) { return  1; }
+  };
+}
+
+Kernel::solve_t const  Kernel::RECURSIVE[] = {
+  scalar<RecursiveSearch< 5>::count>, scalar<RecursiveSearch< 6>::count>, scalar<RecursiveSearch< 7>::count>,
+  scalar<RecursiveSearch< 8>::count>, scalar<RecursiveSearch< 9>::count>,
+  scalar<RecursiveSearch<10>::count>, scalar<RecursiveSearch<11>::count>, scalar<RecursiveSearch<12>::count>, scalar<RecursiveSearch<13>::count>,
+  scalar<RecursiveSearch<14>::count>, scalar<RecursiveSearch<15>::count>, scalar<RecursiveSearch<16>::count>, scalar<RecursiveSearch<17>::count>,
+  scalar<RecursiveSearch<18>::count>, scalar<RecursiveSearch<19>::count>, scalar<RecursiveSearch<20>::count>, scalar<RecursiveSearch<21>::count>,
+  scalar<RecursiveSearch<22>::count>, scalar<RecursiveSearch<23>::count>, scalar<RecursiveSearch<24>::count>, scalar<RecursiveSearch<25>::count>,
+  scalar<RecursiveSearch<26>::count>, scalar<RecursiveSearch<27>::count>, scalar<RecursiveSearch<28>::count>, scalar<RecursiveSearch<29>::count>,
+  scalar<RecursiveSearch<30>::count>, scalar<RecursiveSearch<31>::count>, scalar<RecursiveSearch<32>::count>
+};
+
+namespace {
+  // xorshift64*
+  inline uint64_t random(uint64_t &state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return  state * UINT64_C(2685821657736338717);
+  }
+}
+
+double Kernel::estimate(Blocking const &b, unsigned const  probes, uint64_t &seed) {
+  // Each probe walks a random path down the tree of countCompletions():
+  // a node with k children stands for the product of the branching
+  // factors along its path.
+  double  sum = 0.0;
+  for(unsigned  p = 0; p < probes; p++) {
+    uint64_t  bv = b.bv;
+    uint64_t  bh = b.bh;
+    uint64_t  bu = b.bu;
+    uint64_t  bd = b.bd;
+    double    w  = 1.0;
+    while(bh+1 != 0) {
+      while((bv&1) != 0) {
+	bv >>= 1;
+	bu <<= 1;
+	bd >>= 1;
+      }
+      bv >>= 1;
+
+      uint64_t        slots = ~(bh|bu|bd);
+      unsigned const  k     = popcount(slots);
+      if(k == 0)  break;
+      w   *= k;
+      sum += w;
+
+      // Pick one of the k Slots
+      for(unsigned  r = ((random(seed) >> 32) * k) >> 32; r > 0; r--)  slots &= slots-1;
+      uint64_t const  slot = slots & -slots;
+      bh |= slot;
+      bu  = (bu|slot) << 1;
+      bd  = (bd|slot) >> 1;
+    }
+  }
+  return  probes > 0? sum/probes : 0.0;
+
+} // estimate()
+
+namespace {
+ /**
+  * Explicit-stack search of the iterative kernel. A non-zero N specializes
+  * it for that board dimension: the column schedule is then derived by a
+  * fixed-trip scan over the N-4 inner columns, and the frame stack shrinks
+  * to the at most N-4 queens that may have to be placed.
+  */
+  template<unsigned N>
+  inline uint64_t iterativeSearch(Blocking const &b, uint64_t &nodes) {
+    unsigned const  MAX_D = N != 0? N-4 : 32;
+
+    // Number of Queens to place: one per free row
+    unsigned const  D = popcount(~b.bh);
+    if(D == 0)  return  1;
+
+    // Column Schedule: shift[d] aligns the diagonals from the column of
+    // placement d-1 (or column 2 for d=0) to the column of placement d,
+    // skipping over all columns covered by the pre-placement.
+    unsigned  shift[MAX_D+1];
+    if(N != 0) {
+      unsigned  d = 0;
+      unsigned  s = 0;
+      for(unsigned  c = 0; c < MAX_D; c++) {
+	unsigned const  f = ~(b.bv >> c) & 1;
+	shift[d] = s;
+	d += f;
+	s  = f? 1 : s+1;
+      }
+    }
+    else {
+      uint64_t  bv = b.bv;
+      unsigned  s  = 0;
+      for(unsigned  d = 0; d < D; d++) {
+	while((bv&1) != 0) {
+	  bv >>= 1;
+	  s++;
+	}
+	bv >>= 1;
+	shift[d] = s;
+	s = 1;
+      }
+    }
+    if(D == 1) {
+      uint64_t const  cnt = popcount(~(b.bh|(b.bu << shift[0])|(b.bd >> shift[0])));
+      nodes += cnt;
+      return  cnt;
+    }
+
+    // Explicit Frame Stack indexed by placement depth: the blocking at
+    // this depth and the slots still to explore
+    uint64_t  bh[MAX_D];
+    uint64_t  bu[MAX_D];
+    uint64_t  bd[MAX_D];
+    uint64_t  slots[MAX_D];
+
+    unsigned const  P  = D-2;        // last depth with a successor
+    unsigned const  sl = shift[D-1]; // alignment of the last placement
+
+    bh[0] = b.bh;
+    bu[0] = b.bu << shift[0];
+    bd[0] = b.bd >> shift[0];
+    slots[0] = ~(bh[0]|bu[0]|bd[0]);
+
+    uint64_t  cnt = 0;
+    uint64_t  nds = 0;
+    unsigned  d   = 0;
+    while(true) {
+      if(d == P) {
+	// Each free slot of the final placement completes the board.
+	uint64_t const  h = bh[d];
+	uint64_t const  u = bu[d];
+	uint64_t const  g = bd[d];
+	for(uint64_t  s = slots[d]; s != 0; s &= s-1) {
+	  uint64_t const  slot = s & -s;
+	  nds++;
+	  cnt += popcount(~((h|slot)|((u|slot) << sl)|((g|slot) >> sl)));
+	}
+	if(d == 0)  break;
+	d--;
+	continue;
+      }
+
+      uint64_t const  s = slots[d];
+      if(s == 0) { // Backtrack
+	if(d == 0)  break;
+	d--;
+	continue;
+      }
+
+      // Advance
+      uint64_t const  slot = s & -s;
+      unsigned const  sh   = shift[d+1];
+      slots[d] = s ^ slot;
+      nds++;
+      bh[d+1] =  bh[d]|slot;
+      bu[d+1] = (bu[d]|slot) << sh;
+      bd[d+1] = (bd[d]|slot) >> sh;
+      d++;
+      slots[d] = ~(bh[d]|bu[d]|bd[d]);
+    }
+    nodes += nds + cnt;
+    return  cnt;
+
+  } // iterativeSearch()
+}
+
+uint64_t Kernel::iterative(Blocking const &b, uint64_t &nodes) {
+  return  iterativeSearch<0>(b, nodes);
+}
+
+Kernel::solve_t const  Kernel::ITERATIVE[] = {
+  scalar<iterativeSearch< 5>>, scalar<iterativeSearch< 6>>, scalar<iterativeSearch< 7>>,
+  scalar<iterativeSearch< 8>>, scalar<iterativeSearch< 9>>,
+  scalar<iterativeSearch<10>>, scalar<iterativeSearch<11>>, scalar<iterativeSearch<12>>, scalar<iterativeSearch<13>>,
+  scalar<iterativeSearch<14>>, scalar<iterativeSearch<15>>, scalar<iterativeSearch<16>>, scalar<iterativeSearch<17>>,
+  scalar<iterativeSearch<18>>, scalar<iterativeSearch<19>>, scalar<iterativeSearch<20>>, scalar<iterativeSearch<21>>,
+  scalar<iterativeSearch<22>>, scalar<iterativeSearch<23>>, scalar<iterativeSearch<24>>, scalar<iterativeSearch<25>>,
+  scalar<iterativeSearch<26>>, scalar<iterativeSearch<27>>, scalar<iterativeSearch<28>>, scalar<iterativeSearch<29>>,
+  scalar<iterativeSearch<30>>, scalar<iterativeSearch<31>>, scalar<iterativeSearch<32>>
+};
@@ -0,0 +1,156 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef QUEENS_KERNEL_HPP
+#define QUEENS_KERNEL_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+namespace queens {
+
+ /**
+  * The blocking vectors of a board with its two outer rings pre-placed as
+  * seen by the completion kernels. The view is restricted to the inner
+  * columns and rows:
+  *
+  *  bv - columns 2, 3, ... occupied by the pre-placement in bits 0, 1, ...
+  *  bh - rows 2..N-3 blocked by the pre-placement in bits N-5..2N-10;
+  *       all other bits are set so that a completed placement yields ~0.
+  *  bu - up diagonals aligned with bh for column 2
+  *  bd - down diagonals aligned with bh for column 2
+  */
+  struct Blocking {
+    uint64_t  bv;
+    uint64_t  bh;
+    uint64_t  bu;
+    uint64_t  bd;
+
+  public:
+    Blocking() : bv(0), bh(0), bu(0), bd(0) {}
+    Blocking(uint64_t  _bv, uint64_t  _bh, uint64_t  _bu, uint64_t  _bd)
+      : bv(_bv), bh(_bh), bu(_bu), bd(_bd) {}
+    ~Blocking() {}
+
+  public:
+    // Derives the kernel view from the blocking vectors of the full board.
+    static Blocking fromBoard(unsigned  N,
+			      uint64_t  bv, uint64_t  bh,
+			      uint64_t  bu, uint64_t  bd) {
+      return  Blocking(bv >> 2,
+		       ((((bh>>2)|(~UINT64_C(0)<<(N-4)))+1)<<(N-5))-1,
+		       bu >> 4,
+		       (bd>>4)<<(N-5));
+    }
+  }; // struct Blocking
+
+ /**
+  * A completion kernel counts all valid completions of pre-placements
+  * given by their Blocking. It processes a batch of them at a time so that
+  * lane-parallel implementations can keep all their lanes busy. It also
+  * accumulates the number of queens placed during the search (nodes) so
+  * that kernels can be compared in terms of their raw search throughput.
+  */
+  class Kernel {
+  public:
+    typedef uint64_t (*count_t)(Blocking const &b, uint64_t &nodes);
+    typedef void     (*solve_t)(Blocking const *probs, size_t  n, uint64_t *cnts, uint64_t &nodes);
+
+    char const *const  name;
+    solve_t     const  solve;
+    bool        const  experimental;  // not faster than the default
+
+    // Supported Board Dimensions
+    static unsigned const  MIN_N =  5;
+    static unsigned const  MAX_N = 32;
+
+  private:
+    bool (*const  m_supported)();
+    solve_t const *const  m_special;  // indexed by N-MIN_N
+
+  private:
+    Kernel(char const *_name, solve_t  _solve, bool (*_supported)(),
+	   solve_t const *_special = nullptr, bool  _experimental = false)
+      : name(_name), solve(_solve), experimental(_experimental),
+	m_supported(_supported), m_special(_special) {}
+  public:
+    ~Kernel() {}
+
+  public:
+    // Whether this kernel can run on the executing CPU.
+    bool supported() const { return  m_supported(); }
+
+    // The variant of this kernel specialized for the board dimension N,
+    // which falls back to the generic solve if there is no such variant.
+    solve_t specialize(unsigned  N) const {
+      return  m_special != nullptr? m_special[N-MIN_N] : solve;
+    }
+
+    // Counts the completions of a single pre-placement.
+    uint64_t count(Blocking const &b, uint64_t &nodes) const {
+      uint64_t  cnt;
+      solve(&b, 1, &cnt, nodes);
+      return  cnt;
+    }
+
+  public:
+    // The available kernels, the default first.
+    static Kernel const  KERNELS[];
+    static unsigned const  NUM_KERNELS;
+
+    // Returns the kernel of the given name or nullptr if there is none.
+    static Kernel const *find(char const *name);
+
+  public:
+    // Knuth's estimate of the number of nodes the search for the completions
+    // of b visits, averaged over the given number of random probes from the
+    // root. The state of the random generator is kept in seed (non-zero).
+    static double estimate(Blocking const &b, unsigned  probes, uint64_t &seed);
+
+  public:
+    // Default: recursive descent, one call per placed queen. Its variants
+    // specialized for each N unroll the recursion by the number of queens
+    // to place and count the last one without a call.
+    static uint64_t recursive(Blocking const &b, uint64_t &nodes);
+
+    // Experimental: explicit frame stack walking a pre-computed column
+    // schedule. Although specialized for each N, it does not beat the
+    // recursive kernel (q27bench explore -k:all) and is kept for comparison.
+    static uint64_t iterative(Blocking const &b, uint64_t &nodes);
+
+    // Lane-parallel search of 16 pre-placements at a time in two
+    // interleaved vectors of 8 AVX-512 lanes.
+    static void avx512(Blocking const *probs, size_t  n, uint64_t *cnts, uint64_t &nodes);
+
+  private:
+    template<count_t  COUNT>
+    static void scalar(Blocking const *probs, size_t  n, uint64_t *cnts, uint64_t &nodes) {
+      for(size_t  i = 0; i < n; i++)  cnts[i] = COUNT(probs[i], nodes);
+    }
+    static solve_t const  RECURSIVE[MAX_N-MIN_N+1];
+    static solve_t const  ITERATIVE[MAX_N-MIN_N+1];
+    static bool always() { return  true; }
+    static bool hasAVX512();
+
+  }; // class Kernel
+
+} // namespace queens
+
+#endif
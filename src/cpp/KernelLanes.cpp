@@ -0,0 +1,222 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Kernel.hpp"
+
+#include <immintrin.h>
+
+using namespace queens;
+
+bool Kernel::hasAVX512() {
+  return  __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd");
+}
+
+namespace {
+
+  // Vectors of 8 64-bit Lanes: values and masks
+  typedef uint64_t  V __attribute__((vector_size(64)));
+  typedef int64_t   M __attribute__((vector_size(64)));
+
+  // Two vectors are interleaved so that the gather and scatter latencies
+  // of one overlap with the arithmetic of the other.
+  unsigned const  GROUPS = 2;
+  unsigned const  LANES  = 8*GROUPS;
+  unsigned const  DEPTH  = Kernel::MAX_N-4;
+
+  // The slots saved on the stack carry their column in the top bits.
+  unsigned const  COL = 58;
+
+  // State of the lanes while they are refilled
+  struct Spill {
+    V  h[GROUPS];  // blocked rows (bh)
+    V  u[GROUPS];  // blocked up diagonals (bu) of the current column
+    V  g[GROUPS];  // blocked down diagonals (bd) of the current column
+    V  s[GROUPS];  // open slots of the current column
+    V  c[GROUPS];  // current column (bit in bv)
+    V  d[GROUPS];  // current depth
+    V  r[GROUPS];  // queens left to place including the current column
+    V  k[GROUPS];  // completions found
+    V  v[GROUPS];  // columns covered by the pre-placement (bv)
+  };
+
+} // anonymous namespace
+
+/**
+ * Lane-parallel Completion Search
+ *
+ * Each lane runs the depth-first search of the recursive kernel for its
+ * own pre-placement. All lanes advance in lock-step by one placement per
+ * step: a lane with open slots in its column places a queen on the lowest
+ * one and descends or, when only the last queen remains, checks it for a
+ * free slot. A lane without open slots backtracks or, at the root,
+ * delivers its count and is refilled with the next pre-placement of the
+ * batch.
+ *
+ * Backtracking requires no saved frame of blocking vectors: clearing the
+ * queen and shifting the diagonals back restores them except for the bits
+ * shifted out, which all further placements in that column shift out as
+ * well. Hence, only the slots of each depth are pushed, with the queen
+ * placed from them still as the lowest bit and their column in the top
+ * bits above the rows. As the lanes sit at different depths, the stack is
+ * laid out as [depth][lane] and accessed by scatters and gathers.
+ */
+__attribute__((target("avx512f,avx512cd")))
+void Kernel::avx512(Blocking const *const  probs, size_t const  n, uint64_t *const  cnts, uint64_t &nodes) {
+  Spill     sp;
+  uint64_t  stack[DEPTH][LANES];
+  size_t    idx[LANES];
+  size_t    next   = 0;
+  uint64_t  leaves = 0;  // nodes found outside of the lanes
+  uint32_t  active = 0;
+
+  // Loads the next pre-placement with at least two queens to place into
+  // lane l and returns whether there was one. Others are counted directly.
+  auto const  refill = [&](unsigned const  l) -> bool {
+    unsigned const  j = l / 8;
+    unsigned const  i = l % 8;
+    while(next < n) {
+      Blocking const &b = probs[next];
+      unsigned const  D = __builtin_popcountll(~b.bh);
+      unsigned const  c = __builtin_ctzll(~b.bv);
+      uint64_t const  h = b.bh;
+      uint64_t const  u = b.bu << c;
+      uint64_t const  g = b.bd >> c;
+      if(D < 2) {
+	uint64_t const  cnt = D == 0? 1 : ~(h|u|g) != 0? 1 : 0;
+	leaves += D == 0? 0 : cnt;
+	cnts[next++] = cnt;
+	continue;
+      }
+      sp.h[j][i] = h;
+      sp.u[j][i] = u;
+      sp.g[j][i] = g;
+      sp.s[j][i] = ~(h|u|g);
+      sp.c[j][i] = c;
+      sp.d[j][i] = 0;
+      sp.r[j][i] = D;
+      sp.k[j][i] = 0;
+      sp.v[j][i] = b.bv;
+      idx[l] = next++;
+      return  true;
+    }
+    // Batch exhausted: park the Lane
+    sp.h[j][i] = ~UINT64_C(0);
+    sp.s[j][i] = 0;
+    sp.d[j][i] = 0;
+    sp.r[j][i] = 0;
+    return  false;
+  };
+  for(unsigned  l = 0; l < LANES; l++) {
+    if(refill(l))  active |= UINT32_C(1) << l;
+  }
+
+  V  H[GROUPS], U[GROUPS], G[GROUPS], S[GROUPS], C[GROUPS];
+  V  D[GROUPS], R[GROUPS], K[GROUPS], B[GROUPS], NDS[GROUPS];
+  auto const  load = [&]() {
+    for(unsigned  j = 0; j < GROUPS; j++) {
+      H[j] = sp.h[j]; U[j] = sp.u[j]; G[j] = sp.g[j]; S[j] = sp.s[j]; C[j] = sp.c[j];
+      D[j] = sp.d[j]; R[j] = sp.r[j]; K[j] = sp.k[j]; B[j] = sp.v[j];
+    }
+  };
+  load();
+  for(unsigned  j = 0; j < GROUPS; j++)  NDS[j] = V{};
+
+  V const  ZERO = {};
+  V const  TOP  = ~ZERO >> (64-COL);
+  while(active != 0) {
+    uint32_t  done = 0;
+    for(unsigned  j = 0; j < GROUPS; j++) {
+      __mmask8 const  act  = active >> 8*j;
+      M const         has  = S[j] != ZERO;
+      M const         last = R[j] == ZERO+2;
+      M const         root = D[j] == ZERO;
+      M const         leaf = has &  last;
+      M const         desc = has & ~last;
+      M const         up   = ~has & ~root;  // never true for parked lanes
+      M const         fin  = ~has &  root;
+      __mmask8 const  push = _mm512_test_epi64_mask((__m512i)desc, (__m512i)desc);
+      __mmask8 const  back = _mm512_test_epi64_mask((__m512i)up,   (__m512i)up);
+      done |= uint32_t(_mm512_test_epi64_mask((__m512i)fin, (__m512i)fin) & act) << 8*j;
+
+      // Place on the lowest open Slot: the next free column lies 1+ctz
+      // columns ahead of the current one.
+      V const  slot = S[j] & -S[j];
+      V const  free = ~(B[j] >> (C[j]+1));
+      V const  sh   = 64 - (V)_mm512_lzcnt_epi64((__m512i)(free & -free));
+      V const  nh   =  H[j]|slot;
+      V const  nu   = (U[j]|slot) << sh;
+      V const  ng   = (G[j]|slot) >> sh;
+      V const  ns   = ~(nh|nu|ng);
+
+      // Count Nodes and Completions
+      M const  hit = leaf & (ns != ZERO);
+      K  [j] -= (V)hit;
+      NDS[j] -= (V)has + (V)hit;
+
+      // Descend after pushing the Slots with the Column
+      __m512i const  at = (__m512i)(D[j]*LANES + j*8 + (V){ 0, 1, 2, 3, 4, 5, 6, 7 });
+      _mm512_mask_i64scatter_epi64(stack, push, at, (__m512i)(S[j] | (C[j] << COL)), 8);
+      __m512i const  prev = _mm512_sub_epi64(at, _mm512_set1_epi64(LANES));
+      V const  popped = (V)_mm512_mask_i64gather_epi64(_mm512_setzero_si512(), back, prev, stack, 8);
+
+      S[j] = leaf? S[j]^slot : S[j];
+      H[j] = desc? nh : H[j];
+      U[j] = desc? nu : U[j];
+      G[j] = desc? ng : G[j];
+      S[j] = desc? ns : S[j];
+      C[j] = desc? C[j]+sh : C[j];
+      D[j] += (V)desc & 1;
+      R[j] -= (V)desc & 1;
+
+      // Backtrack by undoing the Placement from the popped Slots
+      V const  ps = popped & TOP;
+      V const  pq = ps & -ps;
+      V const  pc = popped >> COL;
+      V const  bs = C[j] - pc;
+      H[j] = up? H[j]^pq : H[j];
+      U[j] = up? (U[j] >> bs)^pq : U[j];
+      G[j] = up? (G[j] << bs)^pq : G[j];
+      S[j] = up? ps^pq : S[j];
+      C[j] = up? pc : C[j];
+      D[j] -= (V)up & 1;
+      R[j] += (V)up & 1;
+    }
+
+    // Deliver and refill finished Lanes
+    if(done != 0) {
+      for(unsigned  j = 0; j < GROUPS; j++) {
+	sp.h[j] = H[j]; sp.u[j] = U[j]; sp.g[j] = G[j]; sp.s[j] = S[j]; sp.c[j] = C[j];
+	sp.d[j] = D[j]; sp.r[j] = R[j]; sp.k[j] = K[j]; sp.v[j] = B[j];
+      }
+      for(unsigned  l = 0; l < LANES; l++) {
+	if(done & (UINT32_C(1) << l)) {
+	  cnts[idx[l]] = sp.k[l/8][l%8];
+	  if(!refill(l))  active &= ~(UINT32_C(1) << l);
+	}
+      }
+      load();
+    }
+  }
+  for(unsigned  j = 0; j < GROUPS; j++) {
+    for(unsigned  i = 0; i < 8; i++)  leaves += NDS[j][i];
+  }
+  nodes += leaves;
+
+} // avx512()
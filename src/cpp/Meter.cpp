@@ -0,0 +1,103 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Meter.hpp"
+
+#include <cstdint>
+#include <iomanip>
+
+#include <errno.h>
+#include <unistd.h>
+
+using namespace queens;
+
+//- Meter::Event -------------------------------------------------------------
+Meter::Event::Event(char const *const  type) {
+  m_out << "{\"event\":\"" << type << '"';
+}
+
+Meter::Event& Meter::Event::operator()(char const *const  key, char const *const  val) {
+  m_out << ",\"" << key << "\":\"";
+  for(char const *p = val; *p; p++) {
+    if((*p == '"') || (*p == '\\'))  m_out << '\\';
+    m_out << *p;
+  }
+  m_out << '"';
+  return *this;
+}
+
+Meter::Event& Meter::Event::operator()(char const *const  key, double const  val) {
+  m_out << ",\"" << key << "\":" << std::fixed << std::setprecision(3) << val;
+  return *this;
+}
+
+//- Meter --------------------------------------------------------------------
+Meter::Meter(int const  fd)
+  : m_fd(fd), m_start(clock::now()), m_last(m_start), m_total(0.0), m_done(0.0) {}
+
+double Meter::elapsed() const {
+  return  std::chrono::duration<double>(clock::now() - m_start).count();
+}
+
+bool Meter::due() {
+  clock::time_point const  now = clock::now();
+  if(now - m_last < std::chrono::seconds(1))  return  false;
+  m_last = now;
+  return  true;
+}
+
+double Meter::eta() const {
+  if(m_done <= 0.0)  return -1.0;
+  return  elapsed() * (m_total-m_done) / m_done;
+}
+
+void Meter::emit(Event const &ev) const {
+  if(m_fd < 0)  return;
+  std::string const  line = ev.str() + '\n';
+  std::lock_guard<std::mutex>  lk(m_lock);
+  size_t  ofs = 0;
+  while(ofs < line.size()) {
+    ssize_t const  k = ::write(m_fd, line.data()+ofs, line.size()-ofs);
+    if(k > 0)  ofs += k;
+    else if((k == 0) || (errno != EINTR))  break;  // the stream is optional
+  }
+}
+
+std::string Meter::duration(double const  sec) {
+  if(sec < 0.0)  return  "--:--:--";
+  uint64_t const  s = (uint64_t)(sec + 0.5);
+  std::ostringstream  out;
+  out << (s/3600) << ':' << std::setfill('0') << std::setw(2) << (s/60%60)
+      << ':' << std::setw(2) << (s%60);
+  return  out.str();
+}
+
+std::string Meter::rate(double  val) {
+  static char const  SUFFIX[] = " kMGTPE";
+  unsigned  i = 0;
+  while((val >= 1000.0) && (i < sizeof(SUFFIX)-2)) {
+    val /= 1000.0;
+    i++;
+  }
+  std::ostringstream  out;
+  out << std::fixed << std::setprecision(i > 0? 1 : 0) << val;
+  if(i > 0)  out << SUFFIX[i];
+  return  out.str();
+}
@@ -0,0 +1,118 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef QUEENS_METER_HPP
+#define QUEENS_METER_HPP
+
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+namespace queens {
+
+ /**
+  * Live statistics of a run partitioned into pieces of unequal cost.
+  *
+  * The Meter paces the progress reports and estimates the remaining time
+  * from the cost weights of the planned and of the completed partitions.
+  * Its Events are optionally emitted as JSON lines to a file descriptor
+  * so that runs on different machines or with different kernels can be
+  * compared by scripts:
+  *
+  *   {"event":"progress","time":12.003,"seeds":123456,...}
+  *
+  * The counters themselves are kept by the callers where they are cheap
+  * to maintain, i.e. per thread and per batch.
+  */
+  class Meter {
+  public:
+    typedef std::chrono::steady_clock  clock;
+
+    // A JSON Object of Numbers and Strings
+    class Event {
+      std::ostringstream  m_out;
+
+    public:
+      Event(char const *type);
+      ~Event() {}
+
+    public:
+      Event& operator()(char const *key, char const *val);
+      Event& operator()(char const *key, std::string const &val) {
+	return  operator()(key, val.c_str());
+      }
+      Event& operator()(char const *key, double  val);
+      Event& operator()(char const *key, bool  val) {
+	m_out << ",\"" << key << "\":" << (val? "true" : "false");
+	return *this;
+      }
+      template<typename T>
+      Event& operator()(char const *key, T const  val) {
+	m_out << ",\"" << key << "\":" << val;
+	return *this;
+      }
+      std::string str() const { return  m_out.str() + '}'; }
+    }; // class Event
+
+  private:
+    int                const  m_fd;     // JSON stream or -1
+    std::mutex        mutable m_lock;   // of the stream
+    clock::time_point  const  m_start;
+    clock::time_point         m_last;   // last report
+    double                    m_total;  // weight of the run
+    double                    m_done;   // weight of completed partitions
+
+  public:
+    Meter(int  fd = -1);
+    ~Meter() {}
+
+  public:
+    // Seconds since the start of the run
+    double elapsed() const;
+
+    // Whether a report is due, at most once a second.
+    bool due();
+
+    // Sets the total weight of the partitions of the run.
+    void plan(double  total) { m_total = total; m_done = 0.0; }
+
+    // Accounts completed weight or sets the total weight completed.
+    void complete(double  weight) { m_done += weight; }
+    void reach   (double  weight) { m_done  = weight; }
+
+    // Completed share of the planned weight and the estimated remaining
+    // seconds, or a negative value if there is no estimate yet.
+    double share() const { return  m_total > 0.0? m_done/m_total : 0.0; }
+    double eta() const;
+
+    // Writes the event to the JSON stream if there is one. Thread-safe.
+    void emit(Event const &ev) const;
+
+  public:
+    // Human-readable durations (h:mm:ss) and rates (12.3k).
+    static std::string duration(double  sec);
+    static std::string rate(double  val);
+
+  }; // class Meter
+
+} // namespace queens
+
+#endif
@@ -0,0 +1,76 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef QUEENS_PROTOCOL_HPP
+#define QUEENS_PROTOCOL_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace queens {
+
+ /**
+  * The client protocol of the work distribution as spoken by the Java
+  * Server and RemoteDatabase (me.preusser.q27.Constants). All numbers are
+  * big endian as by java.io.DataOutput:
+  *
+  *  FETCH_CASES     <n:int32>                  -> n x <spec:int64>, 0 if none left
+  *  ANNOUNCE_SOLVER <id:int32> <name:UTF>
+  *  REPORT_RESULT   <id:int32> <spec:int64> <res:int64>
+  *  DENOUNCE_SOLVER <id:int32>
+  *
+  * A spec is the DBEntry::spec() of a pre-placement of two rings. A result
+  * holds the count with its residues as in the solution word of a DBEntry:
+  * mod 13 in bits 51-48, mod 15 in bits 47-44 and the count in bits 43-0.
+  */
+  namespace protocol {
+
+    uint8_t const  FETCH_CASES     = 0x01;
+    uint8_t const  ANNOUNCE_SOLVER = 0x02;
+    uint8_t const  REPORT_RESULT   = 0x03;
+    uint8_t const  DENOUNCE_SOLVER = 0x04;
+
+    inline uint32_t get32(uint8_t const *p) {
+      return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+    }
+    inline uint64_t get64(uint8_t const *p) {
+      return (uint64_t(get32(p)) << 32) | get32(p+4);
+    }
+    inline void put32(std::string &out, uint32_t  v) {
+      for(int  s = 24; s >= 0; s -= 8)  out.push_back(char(v >> s));
+    }
+    inline void put64(std::string &out, uint64_t  v) {
+      put32(out, uint32_t(v >> 32));
+      put32(out, uint32_t(v));
+    }
+
+    // The result word of a count and its decoding.
+    inline uint64_t result(uint64_t  cnt) {
+      return (uint64_t(cnt%13) << 48) | (uint64_t(cnt%15) << 44) | (cnt & UINT64_C(0xFFFFFFFFFFF));
+    }
+    inline uint64_t count(uint64_t  res) { return  res & UINT64_C(0xFFFFFFFFFFF); }
+    inline unsigned mod13(uint64_t  res) { return  unsigned(res >> 48) & 15; }
+    inline unsigned mod15(uint64_t  res) { return  unsigned(res >> 44) & 15; }
+
+  } // namespace protocol
+
+} // namespace queens
+
+#endif
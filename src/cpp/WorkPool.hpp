@@ -0,0 +1,194 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef QUEENS_WORKPOOL_HPP
+#define QUEENS_WORKPOOL_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace queens {
+
+ /**
+  * A pool of worker threads processing work items of type T.
+  *
+  * Submitted items are dealt round-robin into per-worker deques. A worker
+  * consumes its own deque from the back and steals from the front of its
+  * peers' deques once it runs dry. This keeps all threads busy even if the
+  * computational cost of the individual items varies by orders of
+  * magnitude. The number of outstanding items is limited: submit() blocks
+  * the producer while this limit is exceeded.
+  *
+  * The processing function is invoked as fct(tid, item) with tid being the
+  * index of the executing worker in [0, size()). This allows to maintain
+  * per-thread accumulators without any synchronization.
+  */
+  template<typename T>
+  class WorkPool {
+    struct Queue {
+      std::mutex     lock;
+      std::deque<T>  items;
+    };
+
+    std::function<void(unsigned, T&)> const  m_fct;
+    uint64_t                                const  m_limit;
+
+    std::vector<std::unique_ptr<Queue>>  m_queues;
+    std::vector<std::thread>             m_threads;
+    unsigned                             m_next;   // round-robin target
+
+    std::mutex               m_lock;
+    std::condition_variable  m_avail;  // items queued or pool closed
+    std::condition_variable  m_space;  // items completed
+    std::atomic<long>        m_queued;
+    std::atomic<uint64_t>    m_submitted;
+    std::atomic<uint64_t>    m_completed;
+    bool                     m_closed;
+
+    //- Construction / Destruction -------------------------------------------
+  public:
+    template<typename F>
+    WorkPool(unsigned  threads, F  fct, uint64_t  limit = 0)
+      : m_fct(fct), m_limit(limit != 0? limit : UINT64_C(64)*threads),
+	m_next(0), m_queued(0), m_submitted(0), m_completed(0), m_closed(false) {
+      if(threads == 0)  threads = 1;
+      for(unsigned  i = 0; i < threads; i++) {
+	m_queues.emplace_back(new Queue());
+      }
+      for(unsigned  i = 0; i < threads; i++) {
+	m_threads.emplace_back(&WorkPool::run, this, i);
+      }
+    }
+    ~WorkPool() {
+      close();
+    }
+
+  private:
+    WorkPool(WorkPool const&) = delete;
+    WorkPool& operator=(WorkPool const&) = delete;
+
+    //- Usage Interface ------------------------------------------------------
+  public:
+    unsigned size()      const { return  m_queues.size(); }
+    uint64_t submitted() const { return  m_submitted.load(); }
+    uint64_t completed() const { return  m_completed.load(); }
+
+    void submit(T  item) {
+      { // Throttle the Producer
+	std::unique_lock<std::mutex>  lk(m_lock);
+	while(m_submitted.load() - m_completed.load() >= m_limit)  m_space.wait(lk);
+      }
+      {
+	Queue &q = *m_queues[m_next];
+	if(++m_next == m_queues.size())  m_next = 0;
+	std::lock_guard<std::mutex>  lk(q.lock);
+	q.items.push_back(std::move(item));
+      }
+      {
+	std::lock_guard<std::mutex>  lk(m_lock);
+	m_queued++;
+	m_submitted++;
+      }
+      m_avail.notify_one();
+    }
+
+    /**
+     * Waits for all submitted items to be completed but at most for the
+     * specified timeout. Returns whether the pool has become idle.
+     */
+    template<typename Rep, typename Period>
+    bool await(std::chrono::duration<Rep, Period> const &timeout) {
+      std::unique_lock<std::mutex>  lk(m_lock);
+      return  m_space.wait_for(lk, timeout, [this]() {
+	  return  m_completed.load() == m_submitted.load();
+	});
+    }
+
+    // Completes all submitted items and terminates the worker threads.
+    void close() {
+      {
+	std::lock_guard<std::mutex>  lk(m_lock);
+	m_closed = true;
+      }
+      m_avail.notify_all();
+      for(std::thread &t : m_threads) {
+	if(t.joinable())  t.join();
+      }
+    }
+
+    //- Worker Implementation ------------------------------------------------
+  private:
+    bool fetch(unsigned  tid, T &item) {
+      unsigned const  n = m_queues.size();
+      { // Own Queue: LIFO
+	Queue &q = *m_queues[tid];
+	std::lock_guard<std::mutex>  lk(q.lock);
+	if(!q.items.empty()) {
+	  item = std::move(q.items.back());
+	  q.items.pop_back();
+	  return  true;
+	}
+      }
+      for(unsigned  i = 1; i < n; i++) { // Steal: FIFO
+	Queue &q = *m_queues[(tid+i)%n];
+	std::lock_guard<std::mutex>  lk(q.lock);
+	if(!q.items.empty()) {
+	  item = std::move(q.items.front());
+	  q.items.pop_front();
+	  return  true;
+	}
+      }
+      return  false;
+    }
+
+    void run(unsigned const  tid) {
+      T  item;
+      while(true) {
+	if(fetch(tid, item)) {
+	  m_queued--;
+	  m_fct(tid, item);
+	  {
+	    std::lock_guard<std::mutex>  lk(m_lock);
+	    m_completed++;
+	  }
+	  m_space.notify_all();
+	  continue;
+	}
+	std::unique_lock<std::mutex>  lk(m_lock);
+	while(m_queued.load() <= 0) {
+	  if(m_closed)  return;
+	  m_avail.wait(lk);
+	}
+      }
+    } // run()
+
+  }; // class WorkPool
+
+} // namespace queens
+
+#endif
@@ -0,0 +1,227 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "ZoneMap.hpp"
+
+#include <atomic>
+#include <thread>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace queens;
+
+namespace {
+
+  uint32_t const  MAGIC   = 0x51325A4D;  // "Q2ZM"
+  uint32_t const  VERSION = 2;
+
+  struct Header {
+    uint32be_t  magic;
+    uint32be_t  version;
+    uint32be_t  block;
+    uint32be_t  rings;
+    uint64be_t  entries;
+    uint64be_t  inode;     // identity of the indexed database file
+    uint64be_t  size;
+    uint64be_t  mtime;     // ns
+  };
+
+  bool readFully(int const  fd, void *const  buf, size_t const  len) {
+    size_t  ofs = 0;
+    while(ofs < len) {
+      ssize_t const  k = ::read(fd, static_cast<char*>(buf)+ofs, len-ofs);
+      if(k > 0)  ofs += k;
+      else if((k == 0) || (errno != EINTR))  return  false;
+    }
+    return  true;
+  }
+
+  bool writeFully(int const  fd, void const *const  buf, size_t const  len) {
+    size_t  ofs = 0;
+    while(ofs < len) {
+      ssize_t const  k = ::write(fd, static_cast<char const*>(buf)+ofs, len-ofs);
+      if(k > 0)  ofs += k;
+      else if((k < 0) && (errno != EINTR))  return  false;
+    }
+    return  true;
+  }
+
+} // anonymous namespace
+
+//- Construction / Destruction -----------------------------------------------
+ZoneMap::ZoneMap(char const *const  dbFile, DBConstRange const &db)
+  : m_file(std::string(dbFile) + ".zmap"), m_db(db),
+    m_zones((db.size() + BLOCK-1) / BLOCK), m_verified(m_zones.size(), 0),
+    m_inode(0), m_size(0), m_mtime(0), m_loaded(false) {
+
+  // Identify the File before any Scan so that later Writes tell.
+  struct stat  st;
+  if(::stat(dbFile, &st) != 0)  return;
+  m_inode = st.st_ino;
+  m_size  = st.st_size;
+  m_mtime = uint64_t(st.st_mtim.tv_sec)*1000000000 + st.st_mtim.tv_nsec;
+
+  // A missing or mismatching sidecar leaves all zones untrusted.
+  int const  fd = ::open(m_file.c_str(), O_RDONLY);
+  if(fd < 0)  return;
+  Header  hdr;
+  if(readFully(fd, &hdr, sizeof(hdr)) &&
+     (hdr.magic == MAGIC) && (hdr.version == VERSION) && (hdr.block == BLOCK) &&
+     (hdr.rings == db.rings()) && (hdr.entries == db.size()) &&
+     (hdr.inode == m_inode) && (hdr.size == m_size)) {
+    m_loaded = readFully(fd, m_zones.data(), m_zones.size()*sizeof(Zone));
+    if(!m_loaded)  m_zones.assign(m_zones.size(), Zone());
+    else if(hdr.mtime == m_mtime)  m_verified.assign(m_zones.size(), 1);
+  }
+  ::close(fd);
+}
+
+//- Lookup -------------------------------------------------------------------
+ZoneMap::Zone const *ZoneMap::trusted(size_t const  z) const {
+  return  m_verified[z]? bounded(z) : nullptr;
+}
+
+ZoneMap::Zone const *ZoneMap::bounded(size_t const  z) const {
+  unsigned const L  = m_db.rings();
+  Zone const    &zn = m_zones[z];
+  DBEntry const *b  = begin(z);
+  DBEntry const *e  = end(z);
+  if((zn.solved != uint32_t(e - b)) || !b->solved(L) || !e[-1].solved(L))  return  nullptr;
+  if((b->spec(L) != zn.minSpec) || (e[-1].spec(L) != zn.maxSpec))  return  nullptr;
+  return &zn;
+}
+
+uint64_t ZoneMap::hash(size_t const  z) const {
+  // FNV-1a over the Words of the Entries
+  uint64be_t const *p = reinterpret_cast<uint64be_t const*>(begin(z));
+  uint64be_t const *e = reinterpret_cast<uint64be_t const*>(end(z));
+  uint64_t  h = 0xCBF29CE484222325;
+  while(p < e)  h = (h ^ uint64_t(*p++)) * 0x100000001B3;
+  return  h;
+}
+
+//- Maintenance --------------------------------------------------------------
+DBStats ZoneMap::refresh(unsigned  threads, size_t &rescanned) {
+  std::vector<size_t>  dirty;
+  for(size_t  z = 0; z < m_zones.size(); z++) {
+    if(!trusted(z))  dirty.push_back(z);
+  }
+
+  if(threads == 0)  threads = std::thread::hardware_concurrency();
+  if(threads > dirty.size())  threads = dirty.size();
+
+  std::atomic<size_t>  next(0);
+  std::atomic<size_t>  scans(0);
+  auto const  work = [&]() {
+    for(size_t  i; (i = next++) < dirty.size();) {
+      size_t  const  z  = dirty[i];
+      Zone          &zn = m_zones[z];
+      uint64_t const  h = hash(z);
+      m_verified[z] = 1;
+
+      // A solved Zone of a modified File must only prove its Contents.
+      if(bounded(z) && (zn.hash == h))  continue;
+
+      DBEntry const *b  = begin(z);
+      DBEntry const *e  = end(z);
+      DBStats const  st = DBStats::chunk(b, e, m_db.rings());
+      scans++;
+      zn.minSpec  = b->spec(m_db.rings());
+      zn.maxSpec  = e[-1].spec(m_db.rings());
+      zn.hash     = h;
+      zn.count    = st.count;
+      zn.countAll = st.countAll;
+      zn.solved   = st.solved;
+      zn.taken    = st.taken;
+      zn.invalid  = st.invalid;
+      zn.wrapped  = st.wrapped;
+      zn.tail     = st.m_tail;
+      zn.mod13    = st.mod13;
+      zn.mod15    = st.mod15;
+      zn.mod13All = st.mod13All;
+      zn.mod15All = st.mod15All;
+    }
+  };
+  std::vector<std::thread>  pool;
+  for(unsigned  t = 1; t < threads; t++)  pool.emplace_back(work);
+  work();
+  for(std::thread &t : pool)  t.join();
+  rescanned = scans;
+
+  // Aggregate the Summaries in Order
+  DBStats  res;
+  for(size_t  z = 0; z < m_zones.size(); z++) {
+    Zone const &zn = m_zones[z];
+    DBStats  st;
+    st.entries  = end(z) - begin(z);
+    st.invalid  = zn.invalid;
+    st.taken    = zn.taken;
+    st.solved   = zn.solved;
+    st.wrapped  = zn.wrapped;
+    st.m_tail   = zn.tail;
+    st.gapped   = (st.entries - st.solved) - st.m_tail;
+    st.count    = zn.count;
+    st.mod13    = zn.mod13;
+    st.mod15    = zn.mod15;
+    st.countAll = zn.countAll;
+    st.mod13All = zn.mod13All;
+    st.mod15All = zn.mod15All;
+    res += st;
+  }
+  return  res;
+
+} // refresh()
+
+bool ZoneMap::save() const {
+  // Replace atomically so that readers never see a torn sidecar.
+  std::string const  tmp = m_file + ".tmp";
+  int const  fd = ::open(tmp.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0666);
+  if(fd < 0)  return  false;
+
+  Header  hdr;
+  hdr.magic   = MAGIC;
+  hdr.version = VERSION;
+  hdr.block   = BLOCK;
+  hdr.rings   = m_db.rings();
+  hdr.entries = m_db.size();
+  hdr.inode   = m_inode;
+  hdr.size    = m_size;
+  hdr.mtime   = m_mtime;
+  bool const  ok =
+    writeFully(fd, &hdr, sizeof(hdr)) &&
+    writeFully(fd, m_zones.data(), m_zones.size()*sizeof(Zone)) &&
+    (fsync(fd) == 0);
+  if((::close(fd) != 0) || !ok || (::rename(tmp.c_str(), m_file.c_str()) != 0)) {
+    ::unlink(tmp.c_str());
+    return  false;
+  }
+  return  true;
+}
+
+void ZoneMap::discard() {
+  ::unlink(m_file.c_str());
+  m_zones.assign(m_zones.size(), Zone());
+  m_verified.assign(m_zones.size(), 0);
+  m_loaded = false;
+}
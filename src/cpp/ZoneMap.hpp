@@ -0,0 +1,139 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef QUEENS_ZONEMAP_HPP
+#define QUEENS_ZONEMAP_HPP
+
+#include "Database.hpp"
+#include "DBStats.hpp"
+#include "endian.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace queens {
+
+ /**
+  * Block summary index (zone map) of a database kept in the sidecar file
+  * <queens.db>.zmap. Each zone summarizes BLOCK consecutive entries by the
+  * specs bounding it and by its DBStats.
+  *
+  * Entries only ever progress from unsolved over taken to solved. The
+  * summary of a completely solved zone thus stays valid for good as long
+  * as its bounding specs still match, which is checked on use. All other
+  * zones are rescanned whenever they are needed. On a nearly finished
+  * database, refreshing the statistics and searching for the first or
+  * last entry of some kind only touch the few open zones. Operations that
+  * withdraw solutions must discard() the index. Range searches use the
+  * index of the database they resolve against when it is passed to their
+  * RangeParser.
+  *
+  * The sidecar records the inode, size and modification time of the
+  * database file. It is ignored for any other file. If the file has been
+  * modified since, the contents of each solved zone must match the hash
+  * recorded with its summary before refresh() trusts it again. Until then,
+  * trusted() does not vouch for any zone.
+  *
+  * The sidecar is written in big endian like the database itself.
+  */
+  class ZoneMap {
+  public:
+    static size_t const  BLOCK = 4096;  // entries, 64 KiB
+
+    struct Zone {
+      uint64be_t  minSpec;   // spec() of the first entry
+      uint64be_t  maxSpec;   // spec() of the last entry
+      uint64be_t  count;
+      uint64be_t  countAll;
+      uint64be_t  hash;      // of the contents, see hash()
+      uint32be_t  solved;
+      uint32be_t  taken;
+      uint32be_t  invalid;
+      uint32be_t  wrapped;
+      uint32be_t  tail;      // unsolved entries after the last solved one
+      uint8_t     mod13;
+      uint8_t     mod15;
+      uint8_t     mod13All;
+      uint8_t     mod15All;
+    };
+
+  private:
+    std::string        const  m_file;
+    DBConstRange       const  m_db;
+    std::vector<Zone>         m_zones;
+    std::vector<uint8_t>      m_verified; // summary matches the contents
+    uint64_t                  m_inode;    // identity of the database file
+    uint64_t                  m_size;
+    uint64_t                  m_mtime;    // ns
+    bool                      m_loaded;   // from a matching sidecar
+
+    //- Construction / Destruction -------------------------------------------
+  public:
+    // Loads the sidecar of the given database file if it exists and fits.
+    ZoneMap(char const *dbFile, DBConstRange const &db);
+    ~ZoneMap() {}
+
+  private:
+    ZoneMap(ZoneMap const&) = delete;
+    ZoneMap& operator=(ZoneMap const&) = delete;
+
+    //- Lookup ---------------------------------------------------------------
+  public:
+    bool   loaded() const { return  m_loaded; }
+    size_t zones()  const { return  m_zones.size(); }
+    DBEntry const *begin(size_t  z) const { return  m_db.begin() + z*BLOCK; }
+    DBEntry const *end  (size_t  z) const {
+      return  z+1 < m_zones.size()? begin(z+1) : m_db.end();
+    }
+    size_t zone(DBEntry const *e) const { return (e - m_db.begin()) / BLOCK; }
+
+    /**
+     * Returns the summary of the given zone if it is verified, completely
+     * solved and still bounded by the recorded specs, nullptr otherwise.
+     */
+    Zone const *trusted(size_t  z) const;
+
+  private:
+    Zone const *bounded(size_t  z) const;
+    uint64_t    hash   (size_t  z) const;
+
+    //- Maintenance ----------------------------------------------------------
+  public:
+    /**
+     * Rescans all zones but the trusted ones on the given number of threads
+     * (0: all cores) and returns the statistics of the whole database.
+     * Solved zones of a modified file whose contents still match their hash
+     * are verified rather than rescanned. The number of rescanned zones is
+     * returned through rescanned.
+     */
+    DBStats refresh(unsigned  threads, size_t &rescanned);
+
+    // Writes the sidecar. Returns false on failure.
+    bool save() const;
+
+    // Removes the sidecar so that no stale summary is ever trusted.
+    void discard();
+
+  }; // class ZoneMap
+
+} // namespace queens
+
+#endif
@@ -28,63 +28,762 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
 
+#include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "Board.hpp"
 #include "DBEntry.hpp"
+#include "DBWriter.hpp"
+#include "Journal.hpp"
+#include "Kernel.hpp"
+#include "Meter.hpp"
+#include "WorkPool.hpp"
 
 using namespace queens;
 
 
 namespace {
 
+  /**
+   * Enumerator of the canonical pre-placements of the two outer rings of
+   * an NxN board. The enumeration is partitioned by the index w of the
+   * pre-placement of the first (west) side. Each partition can be
+   * enumerated independently, and the concatenation of all partitions in
+   * the order of w yields all pre-placements sorted by their spec.
+   *
+   * With three rings, each pre-placement of the two outer rings is refined
+   * by all placements of the third ring in the order of (wc, nc, ec, sc).
+   * Only the rotations leaving the two outer rings unchanged remain to be
+   * considered for the canonical minimum so that the refinements of a
+   * pre-placement directly follow it in the order of the spec.
+   */
+  template<unsigned N>
+  class Enumerator {
+   /**
+    * The number of valid pre-placements in two adjacent columns (rows) is
+    * 2*(N-2) + (N-2)*(N-3) for the outmost and inner positions in the the
+    * first column, respectively. Thus, the total is (N-2)*(N-1).
+    */
+    static unsigned const  P = (N-2)*(N-1);
+    struct pres_t {
+      char unsigned  a;
+      char unsigned  b;
+    };
+    pres_t  pres[P];
+
+   /**
+    * Compatibility of the side pre-placements as bitsets over their
+    * indices: bit j of row i of
+    *
+    *  NEXT - west i with north j,
+    *  PREV - west i with south j,
+    *  OPP  - west i with east j.
+    *
+    * As the side encodings are rotations of each other, NEXT also relates
+    * north with east and east with south while OPP relates north with
+    * south. Two pre-placements are compatible if their queens either
+    * coincide in a corner or do not attack each other. As attacks are
+    * pairwise, a full pre-placement is valid iff all its sides are
+    * pairwise compatible.
+    */
+    static unsigned const  WORDS = (P+63)/64;
+    enum { NEXT, PREV, OPP };
+    std::vector<uint64_t>  compat;
+
+  public:
+    // Number of Partitions: w = 0, ..., W-1
+    static unsigned const  W = (N/2)*(N-3)+1;
+
+    // Number of pre-placed Rings: 2 or 3
+    unsigned const  rings;
+
+  public:
+    Enumerator(unsigned const  _rings = 2) : compat(3*P*WORDS, 0), rings(_rings) {
+      // Compute all valid two-column pre-placements in order:
+      // (a0, b0) < (a1, b1) if a0<a1 || (a0==a1 && b0<b1)
+      unsigned  idx = 0;
+      for(unsigned  a = 0; a < N; a++) {
+	for(unsigned  b = 0; b < N; b++) {
+	  if(abs(a-b) <= 1)  continue;
+	  pres[idx].a = a;
+	  pres[idx].b = b;
+	  idx++;
+	}
+      }
+      assert(idx == P); // Wrong number of pre-placements
+
+      // Compatibility Tables
+      for(unsigned  i = 0; i < P; i++) {
+	unsigned  xi[2], yi[2];
+	side(0, i, xi, yi);
+	for(unsigned  t = NEXT; t <= OPP; t++) {
+	  uint64_t *const  r = &compat[(t*P + i)*WORDS];
+	  for(unsigned  j = 0; j < P; j++) {
+	    unsigned  xj[2], yj[2];
+	    side(t == NEXT? 1 : t == PREV? 3 : 2, j, xj, yj);
+
+	    bool  ok = true;
+	    for(unsigned  k = 0; k < 4; k++) {
+	      int const  x0 = xi[k>>1], y0 = yi[k>>1];
+	      int const  x1 = xj[k&1],  y1 = yj[k&1];
+	      if((x0 == x1) && (y0 == y1))  continue;
+	      if((x0 == x1) || (y0 == y1) || (x0-y0 == x1-y1) || (x0+y0 == x1+y1))  ok = false;
+	    }
+	    if(ok)  r[j/64] |= UINT64_C(1) << (j%64);
+	  }
+	}
+      }
+    }
+    ~Enumerator() {}
+
+  private:
+    // Coordinates of the queens of pre-placement i on side r:
+    // 0 - west, 1 - north, 2 - east, 3 - south
+    void side(unsigned const  r, unsigned const  i, unsigned  x[2], unsigned  y[2]) const {
+      unsigned const  a = pres[i].a;
+      unsigned const  b = pres[i].b;
+      switch(r) {
+      case 0: x[0] = 0;     y[0] = a;     x[1] = 1;     y[1] = b;     break;
+      case 1: x[0] = a;     y[0] = N-1;   x[1] = b;     y[1] = N-2;   break;
+      case 2: x[0] = N-1;   y[0] = N-1-a; x[1] = N-2;   y[1] = N-1-b; break;
+      case 3: x[0] = N-1-a; y[0] = 0;     x[1] = N-1-b; y[1] = 1;     break;
+      }
+    }
+
+    // Refines the canonical pre-placement of the two outer rings on brd by
+    // all placements of the third ring invoking f(board, sym) for the
+    // canonical ones.
+    template<typename F>
+    void refine(Board<N> const &brd, Symmetry const  sym, F &f) const {
+      // Rows of Column x, Columns of Row y of placed Queens
+      auto const  rowOf = [](Board<N> const &b, unsigned const  x) -> unsigned {
+	for(unsigned  y = 0; y < N; y++)  if(b(x, y))  return  y;
+	return  N;
+      };
+      auto const  colOf = [](Board<N> const &b, unsigned const  y) -> unsigned {
+	for(unsigned  x = 0; x < N; x++)  if(b(x, y))  return  x;
+	return  N;
+      };
+      auto const  free = [](Board<N> const &b, unsigned const  x, unsigned const  y) -> bool {
+	return !(((b.getBV() >> x) | (b.getBH() >> y) |
+		  (b.getBU() >> (N-1-x+y)) | (b.getBD() >> (x+y))) & 1);
+      };
+
+      // Every side of the third ring either already holds a queen of the
+      // outer rings or takes a new one inside of them. The candidates are
+      // visited in ascending order of their coronal position.
+      unsigned const  I = N-3;
+      auto const  west = [&](Board<N> const &b, std::function<void(Board<N> const&, unsigned)> const &g) {
+	if(b.getBV() & (UINT64_C(1) << 2))  g(b, rowOf(b, 2));
+	else {
+	  for(unsigned  y = 2; y <= I; y++) {
+	    if(free(b, 2, y)) { Board<N>  c(b); c.add(2, y); g(c, y); }
+	  }
+	}
+      };
+      auto const  north = [&](Board<N> const &b, std::function<void(Board<N> const&, unsigned)> const &g) {
+	if(b.getBH() & (UINT64_C(1) << I))  g(b, colOf(b, I));
+	else {
+	  for(unsigned  x = 2; x <= I; x++) {
+	    if(free(b, x, I)) { Board<N>  c(b); c.add(x, I); g(c, x); }
+	  }
+	}
+      };
+      auto const  east = [&](Board<N> const &b, std::function<void(Board<N> const&, unsigned)> const &g) {
+	if(b.getBV() & (UINT64_C(1) << I))  g(b, N-1-rowOf(b, I));
+	else {
+	  for(unsigned  y = I+1; y-- > 2;) {
+	    if(free(b, I, y)) { Board<N>  c(b); c.add(I, y); g(c, N-1-y); }
+	  }
+	}
+      };
+      auto const  south = [&](Board<N> const &b, std::function<void(Board<N> const&, unsigned)> const &g) {
+	if(b.getBH() & (UINT64_C(1) << 2))  g(b, N-1-colOf(b, 2));
+	else {
+	  for(unsigned  x = I+1; x-- > 2;) {
+	    if(free(b, x, 2)) { Board<N>  c(b); c.add(x, 2); g(c, N-1-x); }
+	  }
+	}
+      };
+
+      west(brd, [&](Board<N> const &bw, unsigned const  wc) {
+	north(bw, [&](Board<N> const &bn, unsigned const  nc) {
+	  east(bn, [&](Board<N> const &be, unsigned const  ec) {
+	    south(be, [&](Board<N> const &bs, unsigned const  sc) {
+	      // The rotations leaving the outer rings unchanged permute the
+	      // sides of the third ring cyclically.
+	      unsigned const  t[4] = { wc, nc, ec, sc };
+	      auto const  cmp = [&t](unsigned const  r) -> int {
+		for(unsigned  i = 0; i < 4; i++) {
+		  unsigned const  a = t[i];
+		  unsigned const  b = t[(i+r)%4];
+		  if(a != b)  return  a < b? -1 : 1;
+		}
+		return  0;
+	      };
+	      Symmetry  s(Symmetry::NONE);
+	      if(sym == Symmetry::POINT) {
+		int const  c2 = cmp(2);
+		if(c2 > 0)  return;
+		if(c2 == 0)  s = Symmetry::POINT;
+	      }
+	      else if(sym == Symmetry::ROTATE) {
+		int const  c1 = cmp(1);
+		int const  c2 = cmp(2);
+		int const  c3 = cmp(3);
+		if((c1 > 0) || (c2 > 0) || (c3 > 0))  return;
+		if(c1 == 0)       s = Symmetry::ROTATE;
+		else if(c2 == 0)  s = Symmetry::POINT;
+	      }
+	      f(bs, s);
+	    });
+	  });
+	});
+      });
+
+    } // refine()
+
+    uint64_t const* row(unsigned const  t, unsigned const  i) const {
+      return &compat[(t*P + i)*WORDS];
+    }
+
+    // Invokes f(i) for all set bits i of the bitset in ascending order.
+    template<typename F>
+    static void each(uint64_t const *const  set, F &&f) {
+      for(unsigned  k = 0; k < WORDS; k++) {
+	for(uint64_t  m = set[k]; m != 0; m &= m-1) {
+	  f(64*k + __builtin_ctzll(m));
+	}
+      }
+    }
+
+    // Candidates of all other sides: w <= n, e, s < (N-2)*(N-1)-w
+    void candidates(unsigned const  w, uint64_t *cn, uint64_t *ce, uint64_t *cs) const {
+      for(unsigned  k = 0; k < WORDS; k++) {
+	uint64_t  m = 0;
+	for(unsigned  j = 64*k; (j < 64*k+64) && (j < P); j++) {
+	  if((w <= j) && (j < P-w))  m |= UINT64_C(1) << (j%64);
+	}
+	cn[k] = m & row(NEXT, w)[k];
+	ce[k] = m & row(OPP,  w)[k];
+	cs[k] = m & row(PREV, w)[k];
+      }
+    }
+
+  public:
+   /**
+    * Estimated cost of partition w: the number of its valid (n, e, s)
+    * triples before the canonical checks, which closely bounds its
+    * pre-placements. It is obtained by population counts of the candidate
+    * bitsets without visiting the individual triples.
+    */
+    double weight(unsigned const  w) const {
+      uint64_t  cn[WORDS], ce[WORDS], cs[WORDS];
+      candidates(w, cn, ce, cs);
+
+      uint64_t  res = 0;
+      each(cn, [&](unsigned const  n) {
+	  uint64_t  cne[WORDS], cns[WORDS];
+	  for(unsigned  k = 0; k < WORDS; k++) {
+	    cne[k] = ce[k] & row(NEXT, n)[k];
+	    cns[k] = cs[k] & row(OPP,  n)[k];
+	  }
+	  each(cne, [&](unsigned const  e) {
+	      for(unsigned  k = 0; k < WORDS; k++) {
+		res += __builtin_popcountll(cns[k] & row(NEXT, e)[k]);
+	      }
+	    });
+	});
+      return  res;
+    }
+
+    friend std::ostream& operator<<(std::ostream &out, Enumerator const &en) {
+      pres_t const *const  pres = en.pres;
+      return  out << "First side bound: ("
+		  << (unsigned)pres[(N/2)*(N-3)  ].a << ", " << (unsigned)pres[(N/2)*(N-3)  ].b << ") / ("
+		  << (unsigned)pres[(N/2)*(N-3)+1].a << ", " << (unsigned)pres[(N/2)*(N-3)+1].b << ')';
+    }
+
+    /**
+     * Enumerates partition w invoking f(board, sym) for each canonical
+     * pre-placement on the board with the symmetry sym.
+     */
+    template<typename F>
+    void operator()(unsigned const  w, F &&f) const {
+      unsigned const  wa = pres[w].a;
+      unsigned const  wb = pres[w].b;
+#ifdef TRACE
+      std::cerr << '(' << wa << ", " << wb << ')' << std::endl;
+#endif
+
+      // The compatibility of all sides is established by the bitsets so
+      // that the queens are simply added to copies of the Board.
+      Board<N>  bw;
+      bw.add(0, wa);
+      bw.add(1, wb);
+
+      uint64_t  cn[WORDS], ce[WORDS], cs[WORDS];
+      candidates(w, cn, ce, cs);
+
+      each(cn, [&](unsigned const  n) {
+	unsigned const  na = pres[n].a;
+	unsigned const  nb = pres[n].b;
+#ifdef TRACE
+	std::cerr << '(' << wa << ", " << wb << ')'
+		  << '(' << na << ", " << nb << ')' << std::endl;
+#endif
+
+	Board<N>  bn(bw);
+	bn.add(na, N-1);
+	bn.add(nb, N-2);
+
+	uint64_t  cne[WORDS], cns[WORDS];
+	for(unsigned  k = 0; k < WORDS; k++) {
+	  cne[k] = ce[k] & row(NEXT, n)[k];
+	  cns[k] = cs[k] & row(OPP,  n)[k];
+	}
+	each(cne, [&](unsigned const  e) {
+	  unsigned const  ea = pres[e].a;
+	  unsigned const  eb = pres[e].b;
+#ifdef TRACE
+	  std::cerr << '(' << wa << ", " << wb << ')'
+		    << '(' << na << ", " << nb << ')'
+		    << '(' << ea << ", " << eb << ')' << std::endl;
+#endif
+
+	  Board<N>  be(bn);
+	  be.add(N-1, N-1-ea);
+	  be.add(N-2, N-1-eb);
+
+	  uint64_t  cnes[WORDS];
+	  for(unsigned  k = 0; k < WORDS; k++)  cnes[k] = cns[k] & row(NEXT, e)[k];
+	  each(cnes, [&](unsigned const  s) {
+	    unsigned const  sa = pres[s].a;
+	    unsigned const  sb = pres[s].b;
+#ifdef TRACE
+	    std::cerr << '(' << wa << ", " << wb << ')'
+		      << '(' << na << ", " << nb << ')'
+		      << '(' << ea << ", " << eb << ')'
+		      << '(' << sa << ", " << sb << ')' << std::endl;
+#endif
+
+	    // We have a successful complete pre-placement with
+	    //   w <= n, e, s < (N-2)*(N-1)-w
+	    //
+	    // Thus, the placement is definitely a canonical minimum unless
+	    // one or more of n, e, s are equal to w or (N-2)*(N-1)-1-w.
+	    Symmetry  sym(Symmetry::NONE);
+
+	    { // Check for minimum if n, e, s = (N-2)*(N-1)-1-w
+	      unsigned const  ww = (N-2)*(N-1)-1-w;
+	      if(s == ww) {
+		// check if flip about the up diagonal is smaller
+		if(n < (N-2)*(N-1)-1-e) {
+		  //print('S', wa, wb, na, nb, ea, eb, sa, sb);
+		  return;
+		}
+	      }
+	      if(e == ww) {
+		// check if flip about the vertical center is smaller
+		if(n > (N-2)*(N-1)-1-n) {
+		  //print('E', wa, wb, na, nb, ea, eb, sa, sb);
+		  return;
+		}
+	      }
+	      if(n == ww) {
+		// check if flip about the down diagonal is smaller
+		if(e > (N-2)*(N-1)-1-s) {
+		  //print('N', wa, wb, na, nb, ea, eb, sa, sb);
+		  return;
+		}
+	      }
+	    }
+
+	    // Check for minimum if n, e, s = w
+	    if(s == w) {
+	      // right rotation is smaller unless  w = n = e = s
+	      if((n != w) || (e != w)) {
+		//print('s', wa, wb, na, nb, ea, eb, sa, sb);
+		return;
+	      }
+	      sym = Symmetry::ROTATE;
+	    }
+	    else if(e == w) {
+	      // check if 180°-rotation is smaller
+	      if(n >= s) {
+		if(n > s) {
+		  //print('e', wa, wb, na, nb, ea, eb, sa, sb);
+		  return;
+		}
+		sym = Symmetry::POINT;
+	      }
+	    }
+	    // n = w is okay
+
+	    // The Board is only completed for canonical Pre-Placements.
+	    Board<N>  bs(be);
+	    bs.add(N-1-sa, 0);
+	    bs.add(N-1-sb, 1);
+
+	    //print('o', wa, wb, na, nb, ea, eb, sa, sb);
+	    if(rings == 2)  f(bs, sym);
+	    else            refine(bs, sym, f);
+
+	  }); // s
+	}); // e
+      }); // n
+
+    } // operator()
+
+  }; // class Enumerator
+
+  template<unsigned N>
   class Action {
   protected:
-    Action() {}
+    // Number of Partitions
+    static unsigned const  W = Enumerator<N>::W;
+
+    Journal  *const  journal;  // checkpoints or nullptr
+    Meter          &meter;
+    unsigned  const  first;    // range of partitions to enumerate
+    unsigned  const  last;
+
+  protected:
+    Action(Journal *const  _journal, Meter &_meter, unsigned const  _first, unsigned const  _last)
+      : journal(_journal), meter(_meter), first(_first), last(_last < W? _last : W-1) {}
   public:
     virtual ~Action() {}
 
   public:
-    void operator()(Board const &brd, Symmetry  sym) {
+    void operator()(Board<N> const &brd, Symmetry  sym) {
       this->process(brd, sym);
     }
 
+    /**
+     * Processes all pre-placements. By default, the selected partitions
+     * not yet recorded in the journal are enumerated sequentially and
+     * their pre-placements are handed to process() one by one.
+     */
+    virtual void generate(Enumerator<N> const &en) {
+      for(unsigned  w = first; w <= last; w++) {
+	if(journal && journal->done(w))  continue;
+#ifndef TRACE
+	std::cout << "\rProgress: " << w << '/' << (en.W-1);
+	progress(std::cout);
+	std::cout << std::flush;
+#endif
+	enter(w);
+	en(w, [this](Board<N> const &brd, Symmetry  sym) { this->process(brd, sym); });
+	leave(w);
+      }
+    }
+
+    // Reports the progress beyond the pre-placement enumeration.
+    virtual void progress(std::ostream &out) const {}
+
+    // Completes all pending processing after the enumeration.
+    virtual void finish() {}
+
   protected:
-    virtual void process(Board const &brd, Symmetry  sym) = 0;
+    // Brackets the enumeration of partition w in the default generate().
+    virtual void enter(unsigned  w) {}
+    virtual void leave(unsigned  w) {}
+
+    // Processes a single pre-placement in the default generate().
+    virtual void process(Board<N> const &brd, Symmetry  sym) {}
     virtual void dump(std::ostream &out) const = 0;
-    friend std::ostream& operator<<(std::ostream &out, Action const &act);
+
+    friend std::ostream& operator<<(std::ostream &out, Action const &act) {
+      act.dump(out);
+      return  out;
+    }
   };
 
-  class Explorer : public Action {
-    uint64_t         pre[4];
-    uint64_t *const  cnt;
+  template<unsigned N>
+  class Explorer : public Action<N> {
+    using Action<N>::W;
+    using Action<N>::journal;
+    using Action<N>::meter;
+    using Action<N>::first;
+    using Action<N>::last;
+
+    // Batch of Pre-Placements of a single Partition handed to the
+    // Completion Workers. Work is handed out in batches to amortize the
+    // pool synchronization and to let the avx512 kernel refill its lanes.
+    struct Batch {
+      unsigned               part;
+      std::vector<Blocking>  blk;
+      std::vector<unsigned>  sym;
+    };
+    static unsigned const  BATCH_SIZE = 256;
+
+   /**
+    * Results of a Partition, which is complete once it has been enumerated
+    * and all its batches have been solved. The journal records
+    *
+    *   pre[ROTATE] pre[POINT] pre[NONE] cnt[ROTATE] cnt[POINT] cnt[NONE] nodes
+    */
+    struct Part {
+      uint64_t               pre[4];
+      std::atomic<uint64_t>  cnt[4];
+      std::atomic<uint64_t>  nodes;
+      std::atomic<uint64_t>  pending;   // batches in flight
+      bool                   closed;    // enumeration complete
+      bool                   recorded;  // completed and reported
+      bool                   resumed;   // from the journal
+      double                 weight;    // estimated cost
+      double                 wall;      // seconds from enter to completion
+      Meter::clock::time_point  begun;
+      Part() : pre{0, 0, 0, 0}, nodes(0), pending(0), closed(false), recorded(false), resumed(false),
+	       weight(0.0), wall(0.0) {
+	for(auto &c : cnt)  c.store(0);
+      }
+    };
+
+    // Per-Thread Progress padded apart to separate Cache Lines. Each is
+    // only updated by its own worker once per batch.
+    struct Counts {
+      std::atomic<uint64_t>  done;
+      std::atomic<uint64_t>  nodes;
+      uint64_t               pad[14];
+      Counts() : done(0), nodes(0) {}
+    };
+
+    Kernel const                    &kernel;
+    Kernel::solve_t const            solve;
+    std::unique_ptr<Part[]>          parts;
+    unsigned                         cur;
+    uint64_t                         pre[4];
+    uint64_t                         cnt[4];
+    uint64_t                         nodes;
+    uint64_t                         seeds;  // enumerated by this run
+    unsigned                         resumed;
+    unsigned                         slowest;
+    Batch                            batch;
+    uint64_t                         submitted;
+    std::unique_ptr<Counts[]>        counts;
+    std::unique_ptr<WorkPool<Batch>> pool;
+    double                           elapsed;
 
   public:
-    Explorer(bool const &full) : cnt(full? new uint64_t[4] : 0) {
-      for(Symmetry  s : Symmetry::RANGE)  pre[s] = 0;
+    Explorer(unsigned const  threads, Kernel const &_kernel,
+	     Journal *const  _journal, Meter &_meter, unsigned const  _first, unsigned const  _last)
+      : Action<N>(_journal, _meter, _first, _last),
+	kernel(_kernel), solve(_kernel.specialize(N)), parts(new Part[W]), cur(0),
+	pre{0, 0, 0, 0}, cnt{0, 0, 0, 0}, nodes(0), seeds(0), resumed(0), slowest(W), submitted(0),
+	elapsed(0.0) {
+
+      // Resume Partitions from the Journal
+      if(journal) {
+	for(auto const &r : journal->records()) {
+	  Journal::Record const &rec = r.second;
+	  if((r.first >= W) || (rec.size() != 7)) {
+	    throw  std::runtime_error(std::string("Invalid record in journal ") + journal->name() + '.');
+	  }
+	  Part &p = parts[r.first];
+	  for(unsigned  s = 1; s < 4; s++) {
+	    p.pre[s] = rec[s-1];
+	    p.cnt[s] = rec[s+2];
+	  }
+	  p.nodes  = rec[6];
+	  p.closed = p.recorded = p.resumed = true;
+	  resumed++;
+	}
+      }
+
+      if(threads > 0) {
+	reserve();
+	counts.reset(new Counts[threads]);
+	pool.reset(new WorkPool<Batch>(threads, [this](unsigned  tid, Batch &b) {
+	      size_t const  n = b.blk.size();
+	      uint64_t      res[BATCH_SIZE];
+	      uint64_t      c[4] = { 0, 0, 0, 0 };
+	      uint64_t      nds = 0;
+	      solve(b.blk.data(), n, res, nds);
+	      for(size_t  i = 0; i < n; i++)  c[b.sym[i]] += res[i];
+
+	      Part &p = parts[b.part];
+	      for(unsigned  s = 1; s < 4; s++)  p.cnt[s].fetch_add(c[s], std::memory_order_relaxed);
+	      p.nodes.fetch_add(nds, std::memory_order_relaxed);
+	      p.pending.fetch_sub(1, std::memory_order_release);
+
+	      Counts &cs = counts[tid];
+	      cs.nodes.store(cs.nodes.load(std::memory_order_relaxed) + nds, std::memory_order_relaxed);
+	      cs.done .store(cs.done .load(std::memory_order_relaxed) + n,   std::memory_order_relaxed);
+	    }));
+      }
     }
     ~Explorer() {}
 
+  public:
+    void generate(Enumerator<N> const &en) {
+      // Plan the ETA by the estimated Cost of the pending Partitions.
+      double  total = 0.0;
+      for(unsigned  w = first; w <= last; w++) {
+	if(!parts[w].resumed)  total += parts[w].weight = en.weight(w);
+      }
+      meter.plan(total);
+      meter.emit(Meter::Event("start")
+		 ("N", N)("mode", "x")("kernel", kernel.name)
+		 ("threads", pool? pool->size() : 0)
+		 ("partitions", W)("first", first)("last", last)
+		 ("resumed", resumed)("weight", total));
+      Action<N>::generate(en);
+    }
+
+    void progress(std::ostream &out) const {
+      uint64_t  done  = 0;
+      uint64_t  nds   = 0;
+      double const  t = meter.elapsed();
+      if(pool) {
+	for(unsigned  i = pool->size(); i-- > 0;) {
+	  done += counts[i].done .load(std::memory_order_relaxed);
+	  nds  += counts[i].nodes.load(std::memory_order_relaxed);
+	}
+	out << " [" << done << '/' << submitted << ']';
+      }
+      out << ' ' << Meter::rate(seeds/t) << " seeds/s";
+      if(pool)  out << ", " << Meter::rate(nds/t) << " nodes/s";
+      out << ", " << std::fixed << std::setprecision(1) << (100.0*meter.share()) << "%"
+	  << ", ETA " << Meter::duration(meter.eta()) << "   ";
+    }
+
+    void finish() {
+      if(pool) {
+	while(!pool->await(std::chrono::seconds(1)))  report();
+	pool->close();
+      }
+      collect();
+
+      // Totals of all Partitions including the resumed ones
+      for(unsigned  w = 0; w < W; w++) {
+	Part const &p = parts[w];
+	for(unsigned  s = 1; s < 4; s++) {
+	  pre[s] += p.pre[s];
+	  cnt[s] += p.cnt[s].load();
+	}
+	if(!p.resumed)  nodes += p.nodes.load();
+      }
+      elapsed = meter.elapsed();
+      meter.emit(Meter::Event("finish")
+		 ("time", elapsed)("seeds", seeds)("nodes", nodes)
+		 ("seeds_per_s", seeds/elapsed)("nodes_per_s", nodes/elapsed)
+		 ("solutions", total()));
+    }
+
   protected:
-    void process(Board const &brd, Symmetry  sym) {
-      pre[sym]++;
-      if(cnt) {
-	unsigned const  N = brd.N;
-	cnt[sym] += countCompletions(brd.getBV() >> 2,
-				     ((((brd.getBH()>>2)|(~0<<(N-4)))+1)<<(brd.N-5))-1,
-				     brd.getBU()>>4,
-				     (brd.getBD()>>4)<<(N-5));
+    void enter(unsigned const  w) {
+      cur = w;
+      parts[w].begun = Meter::clock::now();
+    }
+    void leave(unsigned const  w) {
+      if(pool)  flush();
+      parts[w].closed = true;
+      collect();
+    }
+
+    void process(Board<N> const &brd, Symmetry  sym) {
+      parts[cur].pre[sym]++;
+      if((++seeds & 0xFFF) == 0) {
+	if(meter.due())  report();
+      }
+      if(pool) {
+	batch.blk.push_back(Blocking::fromBoard(N, brd.getBV(), brd.getBH(), brd.getBU(), brd.getBD()));
+	batch.sym.push_back(sym);
+	if(batch.blk.size() == BATCH_SIZE)  flush();
       }
     } // process()
 
+  private:
+    void reserve() {
+      batch.blk.reserve(BATCH_SIZE);
+      batch.sym.reserve(BATCH_SIZE);
+    }
+    void flush() {
+      if(!batch.blk.empty()) {
+	submitted += batch.blk.size();
+	batch.part = cur;
+	parts[cur].pending.fetch_add(1, std::memory_order_relaxed);
+	pool->submit(std::move(batch));
+	batch = Batch();
+	reserve();
+      }
+    }
+
+    // Accounts and records all newly completed Partitions.
+    void collect() {
+      for(unsigned  w = first; w <= last; w++) {
+	Part &p = parts[w];
+	if(p.closed && !p.recorded && (p.pending.load(std::memory_order_acquire) == 0)) {
+	  p.wall = std::chrono::duration<double>(Meter::clock::now() - p.begun).count();
+	  if((slowest == W) || (p.wall > parts[slowest].wall))  slowest = w;
+	  meter.complete(p.weight);
+	  meter.emit(Meter::Event("partition")
+		     ("time", meter.elapsed())("partition", w)("wall", p.wall)
+		     ("seeds", p.pre[1] + p.pre[2] + p.pre[3])("nodes", p.nodes.load())
+		     ("weight", p.weight));
+	  if(journal) {
+	    journal->record(w, {
+		p.pre[1], p.pre[2], p.pre[3],
+		p.cnt[1].load(), p.cnt[2].load(), p.cnt[3].load(),
+		p.nodes.load()
+	      });
+	  }
+	  p.recorded = true;
+	}
+      }
+    }
+
+    // Updates the Progress Line and the Stats Stream.
+    void report() {
+      collect();
+      std::cout << "\rProgress: " << cur << '/' << (W-1);
+      progress(std::cout);
+      std::cout << std::flush;
+
+      uint64_t  done = 0;
+      uint64_t  nds  = 0;
+      if(pool) {
+	for(unsigned  i = pool->size(); i-- > 0;) {
+	  done += counts[i].done .load(std::memory_order_relaxed);
+	  nds  += counts[i].nodes.load(std::memory_order_relaxed);
+	}
+      }
+      double const  t = meter.elapsed();
+      meter.emit(Meter::Event("progress")
+		 ("time", t)("partition", cur)("seeds", seeds)
+		 ("solved", done)("nodes", nds)
+		 ("seeds_per_s", seeds/t)("nodes_per_s", nds/t)
+		 ("share", meter.share())("eta", meter.eta()));
+    }
+
+    // Total Number of Solutions
+    uint64_t total() const {
+      uint64_t  res = 0;
+      for(Symmetry  s : Symmetry::RANGE)  res += s.weight()*cnt[s];
+      return  res;
+    }
+
+  protected:
     void dump(std::ostream &out) const {
       uint64_t  total_pre;
       uint64_t  total_cnt;
 
       out << "Symmetry     Seeds";
       total_pre = 0;
-      if(cnt) {
+      if(pool) {
 	out << "          Boards";
 	total_cnt = 0;
       }
@@ -93,7 +792,7 @@ namespace {
       for(Symmetry  s : Symmetry::RANGE) {
 	out << (char const*)s << '\t' << std::right << std::setw(10) << pre[s];
 	total_pre += pre[s];
-	if(cnt) {
+	if(pool) {
 	  unsigned const  w = s.weight();
 	  out << '\t' << std::right << std::setw(10) << cnt[s] << '*' << w;
 	  total_cnt += w*cnt[s];
@@ -101,233 +800,463 @@ namespace {
 	out << '\n';
       }
       out << "-----\nTOTAL\t" << std::right << std::setw(10) << total_pre;
-      if(cnt)  out << '\t' << std::right << std::setw(12) << total_cnt;
+      if(pool)  out << '\t' << std::right << std::setw(12) << total_cnt;
       out << '\n';
+
+      if(journal || (first > 0) || (last < W-1)) {
+	unsigned  done = 0;
+	for(unsigned  w = 0; w < W; w++) {
+	  if(parts[w].closed)  done++;
+	}
+	out << "\nPartitions: " << done << '/' << W << " (" << resumed << " resumed)\n";
+      }
+      if(pool && (slowest < W)) {
+	out << "\nSlowest partition: " << slowest << " ("
+	    << std::fixed << std::setprecision(3) << parts[slowest].wall << " s)\n";
+      }
+      if(pool) {
+	out << "\nKernel: " << kernel.name << " on " << pool->size() << " thread(s)"
+	    << "\nTime:   " << std::fixed << std::setprecision(3) << elapsed << " s"
+	    << "\nSeeds:  " << std::setprecision(0) << (seeds/elapsed) << "/s"
+	    << "\nNodes:  " << nodes << " (" << (nodes/elapsed) << "/s)"
+	    << '\n';
+      }
     }
+  }; // class Explorer
 
-  private:
-    static uint64_t countCompletions(uint64_t  bv,
-				     uint64_t  bh,
-				     uint64_t  bu,
-				     uint64_t  bd) {
+  template<unsigned N>
+  class DBCreator : public Action<N> {
+    using Action<N>::W;
+    using Action<N>::journal;
+    using Action<N>::meter;
 
-      // Placement Complete?
-      if(bh+1 == 0)  return  1;
+    char     const *const  filename;
+    DBWriter::Mode  const  mode;
+    unsigned        const  threads;
+    uint64_t               cnt;
+    unsigned               resumed;
+    double                 elapsed;
 
-      // -> at least one more queen to place
-      while((bv&1) != 0) { // Column is covered by pre-placement
-	bv >>= 1;
-	bu <<= 1;
-	bd >>= 1;
-      }
-      bv >>= 1;
+  public:
+    DBCreator(char const *const  _filename, DBWriter::Mode const  _mode, unsigned const  _threads,
+	      Journal *const  _journal, Meter &_meter)
+      : Action<N>(_journal, _meter, 0, W-1),
+	filename(_filename), mode(_mode), threads(_threads), cnt(0), resumed(0), elapsed(0.0) {}
+    ~DBCreator() {}
 
-      // Column needs to be placed
-      uint64_t  cnt = 0;
-      for(uint64_t  slots = ~(bh|bu|bd); slots != 0;) {
-	uint64_t const  slot = slots & -slots;
-	cnt   += countCompletions(bv, bh|slot, (bu|slot) << 1, (bd|slot) >> 1);
-	slots ^= slot;
+  public:
+   /**
+    * The database is generated by two passes over the partitions of the
+    * enumeration, which are distributed over all threads:
+    *
+    *  1. The pre-placements are counted per partition so as to obtain the
+    *     offset of its first entry within the sorted database.
+    *  2. Each partition is written directly to its own region of the
+    *     preallocated output file.
+    *
+    * The output is identical to the one of a sequential enumeration. With
+    * a single thread, the partitions are simply written one after another.
+    *
+    * With a journal, each completed partition is synced to disk and
+    * recorded by the offset of its first entry, its entry count and the
+    * spec of its last entry:
+    *
+    *   first count spec
+    *
+    * A resumed run checks the recorded partitions against the file and
+    * only generates the missing ones.
+    */
+    void generate(Enumerator<N> const &en) {
+      unsigned const     L = en.rings;
+      std::vector<bool>  done(W, false);
+      unsigned           prefix = 0;  // leading done Partitions
+      if(journal) {
+	for(auto const &r : journal->records()) {
+	  if((r.first >= W) || (r.second.size() != 3)) {
+	    throw  std::runtime_error(std::string("Invalid record in journal ") + journal->name() + '.');
+	  }
+	  done[r.first] = true;
+	  resumed++;
+	}
+	while((prefix < W) && done[prefix])  prefix++;
+	if(resumed > 0)  verify(L);
       }
-      return  cnt;
+      meter.emit(Meter::Event("start")
+		 ("N", N)("mode", "db")("io", DBWriter::modeName(mode))
+		 ("threads", threads)("partitions", W)("resumed", resumed));
 
-    } // countCompletions()
-  };
+      DBWriter  out(filename, mode, resumed > 0);
+      if((threads == 1) && (prefix == resumed)) {
+	// Sequential Output continuing after the resumed Partitions
+	uint64_t  pos = 0;
+	if(prefix > 0) {
+	  Journal::Record const &rec = *journal->find(prefix-1);
+	  pos = rec[0] + rec[1];
+	  out.preallocate(pos);
+	}
+	std::vector<double>  weight(W, 0.0);
+	double               total = 0.0;
+	for(unsigned  w = prefix; w < W; w++)  total += weight[w] = en.weight(w);
+	meter.plan(total);
+
+	uint64_t const    base = pos;
+	DBWriter::Stream  s(out, pos);
+	for(unsigned  w = prefix; w < W; w++) {
+	  auto const  report = [this, w, &pos, base]() {
+	    std::cout << "\rProgress: " << w << '/' << (W-1);
+	    this->progress(std::cout, pos-base);
+	    std::cout << std::flush;
+	  };
+	  report();
 
-  class DBCreator : public Action {
+	  auto const      begun = Meter::clock::now();
+	  uint64_t const  beg   = pos;
+	  DBEntry         last;
+	  en(w, [this, L, &s, &pos, &last, &report](Board<N> const &brd, Symmetry  sym) {
+	      int8_t  pre[12];
+	      brd.coronal(pre, L == 3? 3 : 2);
+	      last = DBEntry(L, pre, sym);
+	      s.write(last);
+	      if((++pos & 0xFFFF) == 0) {
+		if(meter.due())  report();
+	      }
+	    });
+	  if(journal) {
+	    s.sync();
+	    journal->record(w, { beg, pos-beg, last.spec(L) });
+	  }
+	  meter.complete(weight[w]);
+	  completed(w, begun, pos-beg);
+	}
+	s.close();
+	cnt = pos;
+      }
+      else {
+	// Pass 1: Count the Entries per Partition unless recorded
+	std::unique_ptr<uint64_t[]>  ofs(new uint64_t[W+1]);
+	ofs[0] = 0;
+	parallel(W, "Counting", [this, &en, &ofs, &done](unsigned  w) {
+	    if(done[w]) {
+	      ofs[w+1] = (*journal->find(w))[1];
+	      return;
+	    }
+	    uint64_t  c = 0;
+	    en(w, [&c](Board<N> const&, Symmetry) { c++; });
+	    ofs[w+1] = c;
+	  }, [](std::ostream&) {});
+	for(unsigned  w = 0; w < W; w++) {
+	  ofs[w+1] += ofs[w];
+	  if(done[w] && ((*journal->find(w))[0] != ofs[w])) {
+	    throw  std::runtime_error(std::string("Journal ") + journal->name() + " does not match the enumeration.");
+	  }
+	}
+	cnt = ofs[W];
 
-    std::fstream  out;
-    uint64_t      cnt;
+	// Pass 2: Write the missing Partitions to their Regions weighted
+	//         by their exact Sizes
+	uint64_t  total = 0;
+	for(unsigned  w = 0; w < W; w++) {
+	  if(!done[w])  total += ofs[w+1]-ofs[w];
+	}
+	meter.plan(total);
+	out.preallocate(cnt);
 
-  public:
-    DBCreator(char const *const  filename) : out(filename, std::ofstream::out), cnt(0) {}
-    ~DBCreator() {
+	std::atomic<uint64_t>  written(0);
+	parallel(W, "Writing", [this, L, &out, &en, &ofs, &done, &written](unsigned  w) {
+	    if(done[w])  return;
+	    auto const        begun = Meter::clock::now();
+	    DBWriter::Stream  s(out, ofs[w]);
+	    DBEntry           last;
+	    en(w, [L, &s, &last](Board<N> const &brd, Symmetry  sym) {
+		int8_t  pre[12];
+		brd.coronal(pre, L == 3? 3 : 2);
+		last = DBEntry(L, pre, sym);
+		s.write(last);
+	      });
+	    s.close();
+	    if(journal) {
+	      out.sync();
+	      journal->record(w, { ofs[w], ofs[w+1]-ofs[w], last.spec(L) });
+	    }
+	    written += ofs[w+1]-ofs[w];
+	    completed(w, begun, ofs[w+1]-ofs[w]);
+	  }, [this, &written](std::ostream &out) {
+	    uint64_t const  n = written.load();
+	    meter.reach(n);
+	    progress(out, n);
+	  });
+      }
       out.close();
+      elapsed = meter.elapsed();
+      meter.emit(Meter::Event("finish")
+		 ("time", elapsed)("entries", cnt)("entries_per_s", cnt/elapsed));
+
+    } // generate()
+
+  private:
+    // Checks the last entries of the recorded Partitions against the file
+    // of entries of the given number of rings.
+    void verify(unsigned const  L) const {
+      int const  fd = ::open(filename, O_RDONLY);
+      if(fd < 0)  throw  std::system_error(errno, std::system_category(), std::string("Cannot resume ") + filename);
+      for(auto const &r : journal->records()) {
+	Journal::Record const &rec = r.second;
+	if(rec[1] == 0)  continue;
+
+	DBEntry  e;
+	if(pread(fd, &e, sizeof(e), (rec[0]+rec[1]-1)*sizeof(DBEntry)) != sizeof(e) || (e.spec(L) != rec[2])) {
+	  ::close(fd);
+	  throw  std::runtime_error(std::string("Partition ") + std::to_string(r.first) + " recorded in journal " +
+				    journal->name() + " is missing from " + filename + '.');
+	}
+      }
+      ::close(fd);
     }
 
-  protected:
-    void process(Board const &brd, Symmetry  sym) {
-      int8_t  PRE2[8];
-      brd.coronal(PRE2, 2);
-      DBEntry const  entry(PRE2, sym);
-      out.write((char const*)&entry, sizeof(entry));
-      cnt++;
-    } // process()
+    // Reports the Progress of this run having written the given Entries.
+    void progress(std::ostream &out, uint64_t const  entries) const {
+      double const  t = meter.elapsed();
+      out << ' ' << Meter::rate(entries/t) << " entries/s, "
+	  << std::fixed << std::setprecision(1) << (100.0*meter.share()) << "%"
+	  << ", ETA " << Meter::duration(meter.eta()) << "   ";
+      meter.emit(Meter::Event("progress")
+		 ("time", t)("entries", entries)("entries_per_s", entries/t)
+		 ("share", meter.share())("eta", meter.eta()));
+    }
+
+    // Reports the Completion of partition w begun at the given time.
+    void completed(unsigned const  w, Meter::clock::time_point const  begun, uint64_t const  entries) const {
+      meter.emit(Meter::Event("partition")
+		 ("time", meter.elapsed())("partition", w)
+		 ("wall", std::chrono::duration<double>(Meter::clock::now() - begun).count())
+		 ("entries", entries));
+    }
+
+    // Runs fct(w) for all partitions w on all threads reporting the progress
+    // once a second, extended by report(out). The first exception raised by
+    // fct is rethrown.
+    template<typename F, typename R>
+    void parallel(unsigned const  W, char const *const  what, F  fct, R  report) const {
+      std::atomic<unsigned>  done(0);
+      std::exception_ptr     err;
+      std::mutex             lock;
+      {
+	WorkPool<unsigned>  pool(threads, [&](unsigned, unsigned &w) {
+	    try {
+	      fct(w);
+	    }
+	    catch(...) {
+	      std::lock_guard<std::mutex>  lk(lock);
+	      if(!err)  err = std::current_exception();
+	    }
+	    done++;
+	  }, W);
+	for(unsigned  w = 0; w < W; w++)  pool.submit(w);
+	do {
+	  std::cout << '\r' << what << ": " << done.load() << '/' << W;
+	  report(std::cout);
+	  std::cout << std::flush;
+	}
+	while(!pool.await(std::chrono::seconds(1)));
+      }
+      std::cout << '\r' << what << ": " << W << '/' << W << std::endl;
+      if(err)  std::rethrow_exception(err);
+    }
 
+  protected:
     void dump(std::ostream &out) const {
-      out << "Wrote " << cnt << " Entries." << std::endl;
+      out << "Wrote " << cnt << " Entries ("
+	  << DBWriter::modeName(mode) << ", " << threads << " thread(s)) in "
+	  << std::fixed << std::setprecision(3) << elapsed << " s.";
+      if(resumed > 0)  out << "\nResumed " << resumed << '/' << W << " partitions.";
+      out << std::endl;
     }
   }; // class DBCreator
 
-  std::ostream& operator<<(std::ostream &out, Action const &act) {
-    act.dump(out);
-    return  out;
-  }
+  // Command Line Options
+  struct Options {
+    char const     *mode;
+    Kernel const   *kernel;
+    unsigned        threads;  // generating the database
+    DBWriter::Mode  io;
+    char const     *journal;  // checkpoint journal or nullptr
+    unsigned        first;    // range of partitions to enumerate
+    unsigned        last;
+    int             stats;    // descriptor of the JSON stats stream or -1
+    unsigned        rings;    // pre-placed rings: 2 or 3
+  };
 
-  Action* parseAction(char const *const  arg) {
+  template<unsigned N>
+  Action<N>* parseAction(Options const &opt, Journal *const  journal, Meter &meter) {
+    char const *const  arg = opt.mode;
     if(strncmp(arg, "-db:", 4) == 0) {
-      return  new DBCreator(arg+4);
+      return  new DBCreator<N>(arg+4, opt.io, opt.threads, journal, meter);
+    }
+    if(strcmp(arg, "-x") == 0) {
+      unsigned const  threads = std::thread::hardware_concurrency();
+      return  new Explorer<N>(threads > 0? threads : 1, *opt.kernel, journal, meter, opt.first, opt.last);
+    }
+    if(strncmp(arg, "-x:", 3) == 0) {
+      unsigned const  threads = (unsigned)strtoul(arg+3, 0, 0);
+      return  new Explorer<N>(threads > 0? threads : 1, *opt.kernel, journal, meter, opt.first, opt.last);
     }
-    return  new Explorer(strcmp(arg, "-x") == 0);
+    return  new Explorer<N>(0, *opt.kernel, journal, meter, opt.first, opt.last);
   } // parseAction
-}
 
-int main(int const  argc, char const* const argv[]) {
-  unsigned const  N = argc < 2? 0 : (unsigned)strtoul(argv[argc-1], 0, 0);
-
-  // Check Arguments
-  if((N < 5) || (32 < N)) {
-    std::cerr << argv[0] <<
-      " [-x|-db:<file>] <board dimension from 5..32>\n\n"
-      "\t-x\tExplore pre-placements and count solutions.\n"
+  void usage(char const *const  prog) {
+    std::cerr << prog <<
+      " [-x[:<threads>]|-db:<file>] [-t:<threads>] [-w:<io>] [-k:<kernel>]"
+      " [-c:<journal>] [-p:<first>[-<last>]] [-s:<fd>] [-r:<rings>] <board dimension from 5..32>\n\n"
+      "\t-x\tExplore pre-placements and count solutions\n"
+      "\t\tusing the given number of threads (default: all cores).\n"
       "\t-db\tGenerate a Database of the pre-placements.\n"
-	      << std::endl;
-    return  1;
-  }
-  std::cout << N << "-Queens Puzzle\n" << std::endl;
-  std::unique_ptr<Action>  act(parseAction(argv[1]));
+      "\t-t\tNumber of threads generating the database (default: all cores).\n"
+      "\t-w\tDatabase output: buffered, direct (O_DIRECT) or mapped (default: buffered).\n"
+      "\t-c\tCheckpoint the completed partitions of the first side to the journal\n"
+      "\t\tand resume from it. Journals of explorations may be concatenated.\n"
+      "\t-p\tOnly explore the given range of partitions of the first side.\n"
+      "\t-s\tStream statistics as JSON lines to the file descriptor, e.g. -s:3 3>stats.json.\n"
+      "\t-r\tNumber of pre-placed outer rings: 2 or 3 for N >= 7 (default: 2).\n"
+      "\t-k\tSelect the completion kernel for exploration:";
+    for(unsigned  i = 0; i < Kernel::NUM_KERNELS; i++) {
+      std::cerr << ' ' << Kernel::KERNELS[i].name;
+      if(Kernel::KERNELS[i].experimental)  std::cerr << " (experimental)";
+    }
+    std::cerr << "\n\t\t(default: " << Kernel::KERNELS[0].name << ").\n" << std::endl;
+  } // usage
 
  /**
-  * The number of valid pre-placements in two adjacent columns (rows) is
-  * 2*(N-2) + (N-2)*(N-3) for the outmost and inner positions in the the
-  * first column, respectively. Thus, the total is (N-2)*(N-1).
+  * Enumerates all canonical pre-placements of the outer rings of an NxN
+  * board and hands them to the selected action.
   */
-  struct pres_t {
-    char unsigned  a;
-    char unsigned  b;
-  };
-  std::unique_ptr<pres_t[]>  pres(new pres_t[(N-2)*(N-1)]);
-
-  { // Compute all valid two-column pre-placements in order:
-    // (a0, b0) < (a1, b1) if a0<a1 || (a0==a1 && b0<b1)
-    unsigned  idx = 0;
-    for(unsigned  a = 0; a < N; a++) {
-      for(unsigned  b = 0; b < N; b++) {
-	if(abs(a-b) <= 1)  continue;
-	pres[idx].a = a;
-	pres[idx].b = b;
-	idx++;
+  template<unsigned N>
+  int run(Options const &opt) {
+    std::cout << N << "-Queens Puzzle\n" << std::endl;
+    try {
+      std::unique_ptr<Journal>  journal;
+      if(opt.journal) {
+	bool const  db = strncmp(opt.mode, "-db:", 4) == 0;
+	journal.reset(new Journal(opt.journal, "coronal2 N=" + std::to_string(N) + (db? " db" : " x") +
+				  (opt.rings == 3? " L=3" : "")));
+	std::cout << "Journal: " << opt.journal << " (" << journal->records().size() << " partitions done)\n" << std::endl;
       }
-    }
-    assert(idx == (N-2)*(N-1)); // Wrong number of pre-placements
-  }
-  std::cout << "First side bound: ("
-	    << (unsigned)pres[(N/2)*(N-3)  ].a << ", " << (unsigned)pres[(N/2)*(N-3)  ].b << ") / ("
-	    << (unsigned)pres[(N/2)*(N-3)+1].a << ", " << (unsigned)pres[(N/2)*(N-3)+1].b << ')'
-	    << std::endl;
-
-  // Generate coronal Placements
-  Board  board(N);
-  for(unsigned  w = 0; w <= (N/2)*(N-3); w++) {
-    unsigned const  wa = pres[w].a;
-    unsigned const  wb = pres[w].b;
-#ifdef TRACE
-    std::cerr << '(' << wa << ", " << wb << ')' << std::endl;
-#else
-    std::cout << "\rProgress: " << w << '/' << ((N/2)*(N-3)) << std::flush;
-#endif
-
-    Board::Placement  pwa(board.place(0, wa));
-    Board::Placement  pwb(board.place(1, wb));
-    assert(pwa && pwb);  // NO conflicts on first side possible
+      Meter                       meter(opt.stats);
+      std::unique_ptr<Action<N>>  act(parseAction<N>(opt, journal.get(), meter));
 
-    for(unsigned  n = w; n < (N-2)*(N-1)-w; n++) {
-      unsigned const  na = pres[n].a;
-      unsigned const  nb = pres[n].b;
-#ifdef TRACE
-      std::cerr << '(' << wa << ", " << wb << ')'
-		<< '(' << na << ", " << nb << ')' << std::endl;
-#endif
+      Enumerator<N> const  en(opt.rings);
+      std::cout << en << std::endl;
 
-      Board::Placement  pna(board.place(na, N-1)); if(!pna)  continue;
-      Board::Placement  pnb(board.place(nb, N-2)); if(!pnb)  continue;
+      // Generate coronal Placements
+      act->generate(en);
+      act->finish();
 
-      for(unsigned  e = w; e < (N-2)*(N-1)-w; e++) {
-	unsigned const  ea = pres[e].a;
-	unsigned const  eb = pres[e].b;
-#ifdef TRACE
-	std::cerr << '(' << wa << ", " << wb << ')'
-		  << '(' << na << ", " << nb << ')'
-		  << '(' << ea << ", " << eb << ')' << std::endl;
-#endif
+      std::cout << "\n\n" << *act << std::endl;
+    }
+    catch(std::exception const &e) {
+      std::cerr << '\n' << e.what() << std::endl;
+      return  1;
+    }
+    return  0;
 
-	Board::Placement  pea(board.place(N-1, N-1-ea)); if(!pea)  continue;
-	Board::Placement  peb(board.place(N-2, N-1-eb)); if(!peb)  continue;
+  } // run()
 
-	for(unsigned  s = w; s < (N-2)*(N-1)-w; s++) {
-	  unsigned const  sa = pres[s].a;
-	  unsigned const  sb = pres[s].b;
-#ifdef TRACE
-	  std::cerr << '(' << wa << ", " << wb << ')'
-		    << '(' << na << ", " << nb << ')'
-		    << '(' << ea << ", " << eb << ')'
-		    << '(' << sa << ", " << sb << ')' << std::endl;
-#endif
 
-	  Board::Placement  psa(board.place(N-1-sa, 0)); if(!psa)  continue;
-	  Board::Placement  psb(board.place(N-1-sb, 1)); if(!psb)  continue;
-
-	  // We have a successful complete pre-placement with
-	  //   w <= n, e, s < (N-2)*(N-1)-w
-	  //
-	  // Thus, the placement is definitely a canonical minimum unless
-	  // one or more of n, e, s are equal to w or (N-2)*(N-1)-1-w.
-
-	  { // Check for minimum if n, e, s = (N-2)*(N-1)-1-w
-	    unsigned const  ww = (N-2)*(N-1)-1-w;
-	    if(s == ww) {
-	      // check if flip about the up diagonal is smaller
-	      if(n < (N-2)*(N-1)-1-e) {
-		//print('S', wa, wb, na, nb, ea, eb, sa, sb);
-		continue;
-	      }
-	    }
-	    if(e == ww) {
-	      // check if flip about the vertical center is smaller
-	      if(n > (N-2)*(N-1)-1-n) {
-		//print('E', wa, wb, na, nb, ea, eb, sa, sb);
-		continue;
-	      }
-	    }
-	    if(n == ww) {
-	      // check if flip about the down diagonal is smaller
-	      if(e > (N-2)*(N-1)-1-s) {
-		//print('N', wa, wb, na, nb, ea, eb, sa, sb);
-		continue;
-	      }
-	    }
-	  }
-
-	  // Check for minimum if n, e, s = w
-	  if(s == w) {
-	    // right rotation is smaller unless  w = n = e = s
-	    if((n != w) || (e != w)) {
-	      //print('s', wa, wb, na, nb, ea, eb, sa, sb);
-	      continue;
-	    }
-	    (*act)(board, Symmetry::ROTATE);
-	    continue;
-	  }
-	  if(e == w) {
-	    // check if 180°-rotation is smaller
-	    if(n >= s) {
-	      if(n > s) {
-		//print('e', wa, wb, na, nb, ea, eb, sa, sb);
-		continue;
-	      }
-	      (*act)(board, Symmetry::POINT);
-	      continue;
-	    }
-	  }
-	  // n = w is okay
-
-	  //print('o', wa, wb, na, nb, ea, eb, sa, sb);
-	  (*act)(board, Symmetry::NONE);
+ /**
+  * Dispatch Table of the Enumerations specialized for the supported
+  * board dimensions, indexed by N-Kernel::MIN_N
+  */
+  int (*const  RUN[])(Options const&) = {
+    run< 5>, run< 6>, run< 7>,
+    run< 8>, run< 9>, run<10>, run<11>, run<12>, run<13>, run<14>, run<15>,
+    run<16>, run<17>, run<18>, run<19>, run<20>, run<21>, run<22>, run<23>,
+    run<24>, run<25>, run<26>, run<27>, run<28>, run<29>, run<30>, run<31>,
+    run<32>
+  };
+  static_assert(sizeof(RUN)/sizeof(RUN[0]) == Kernel::MAX_N-Kernel::MIN_N+1,
+		"Incomplete dispatch table.");
+}
 
-	} // s
-      } // e
-    } // n
-  } // w
+int main(int const  argc, char const* const argv[]) {
+  unsigned const  N = argc < 2? 0 : (unsigned)strtoul(argv[argc-1], 0, 0);
 
-  std::cout << "\n\n" << *act << std::endl;
+  // Check Arguments
+  if((N < Kernel::MIN_N) || (Kernel::MAX_N < N)) {
+    usage(argv[0]);
+    return  1;
+  }
+  Options  opt;
+  opt.mode    = "";
+  opt.kernel  = &Kernel::KERNELS[0];
+  opt.threads = std::thread::hardware_concurrency();
+  opt.io      = DBWriter::BUFFERED;
+  opt.journal = nullptr;
+  opt.first   = 0;
+  opt.last    = ~0u;
+  opt.stats   = -1;
+  opt.rings   = 2;
+  bool  partial = false;
+  for(int  i = 1; i < argc-1; i++) {
+    char const *const  arg = argv[i];
+    if(strncmp(arg, "-t:", 3) == 0) {
+      opt.threads = (unsigned)strtoul(arg+3, 0, 0);
+    }
+    else if(strncmp(arg, "-w:", 3) == 0) {
+      if(!DBWriter::parseMode(arg+3, opt.io)) {
+	std::cerr << "Unknown database output: " << (arg+3) << "\n\n";
+	usage(argv[0]);
+	return  1;
+      }
+    }
+    else if(strncmp(arg, "-s:", 3) == 0) {
+      char *end;
+      opt.stats = (int)strtol(arg+3, &end, 0);
+      if((*end != '\0') || (opt.stats < 0) || (fcntl(opt.stats, F_GETFD) < 0)) {
+	std::cerr << "Invalid stats descriptor: " << (arg+3) << "\n\n";
+	usage(argv[0]);
+	return  1;
+      }
+    }
+    else if(strncmp(arg, "-c:", 3) == 0) {
+      opt.journal = arg+3;
+    }
+    else if(strncmp(arg, "-r:", 3) == 0) {
+      opt.rings = (unsigned)strtoul(arg+3, 0, 0);
+      if((opt.rings < 2) || (3 < opt.rings) || (N < 2*opt.rings+1)) {
+	std::cerr << "Invalid number of rings for N=" << N << ": " << (arg+3) << "\n\n";
+	usage(argv[0]);
+	return  1;
+      }
+    }
+    else if(strncmp(arg, "-p:", 3) == 0) {
+      char *end;
+      opt.first = opt.last = (unsigned)strtoul(arg+3, &end, 0);
+      if(*end == '-')  opt.last = (unsigned)strtoul(end+1, &end, 0);
+      if((*end != '\0') || (opt.last < opt.first)) {
+	std::cerr << "Invalid partition range: " << (arg+3) << "\n\n";
+	usage(argv[0]);
+	return  1;
+      }
+      partial = true;
+    }
+    else if(strncmp(arg, "-k:", 3) == 0) {
+      opt.kernel = Kernel::find(arg+3);
+      if(opt.kernel == nullptr) {
+	std::cerr << "Unknown kernel: " << (arg+3) << "\n\n";
+	usage(argv[0]);
+	return  1;
+      }
+      if(!opt.kernel->supported()) {
+	std::cerr << "Kernel " << opt.kernel->name << " is not supported by this CPU." << std::endl;
+	return  1;
+      }
+    }
+    else  opt.mode = arg;
+  }
+  if(partial && (strncmp(opt.mode, "-db:", 4) == 0)) {
+    std::cerr << "A database is always generated for all partitions.\n\n";
+    usage(argv[0]);
+    return  1;
+  }
+  if(opt.threads == 0)  opt.threads = 1;
+  return  RUN[N-Kernel::MIN_N](opt);
 }
@@ -0,0 +1,915 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "Database.hpp"
+#include "DBStats.hpp"
+#include "DBWriter.hpp"
+#include "Kernel.hpp"
+#include "Meter.hpp"
+#include "Protocol.hpp"
+
+using namespace queens;
+
+namespace {
+
+  char const *prog = "q27bench";
+
+  // Usage Output
+  void usage() {
+    std::cerr << prog << " write <file> [<MiB>]\n"
+	      << prog << " explore [-n:<N>[-<N>]] [-t:<threads>[,<threads>...]] [-k:<kernel>|all] [-f:table|csv|json] [-c:<coronal2>]\n"
+	      << prog << " split [-n:<N>[-<N>]] [-d:<dir>]\n"
+	      << prog << " claim [-e:<entries>] [-t:<threads>[,<threads>...]]\n"
+	      << prog << " scan <queens.db> [-r:3] [-t:<threads>[,<threads>...]] [-p:<passes>]\n"
+	      << prog << " load -n:<N> [-h:<host>] [-p:<port>] [-c:<clients>] [-b:<batch>] [-d:<sec>]\n\n"
+      "\twrite\tDatabase output throughput of the std::fstream path\n"
+      "\t\tagainst the DBWriter modes (default: 1024 MiB).\n"
+      "\texplore\tRuns the exploration of coronal2 (default: ./coronal2) for the\n"
+      "\t\tboard dimensions (default: 8-20) with each thread count (default: 1)\n"
+      "\t\tand checks the solution counts against the known totals (OEIS A000170).\n"
+      "\t\tReports the times, node rates and speedups over the first thread count\n"
+      "\t\tas table, CSV or JSON lines and fails on a wrong count.\n"
+      "\t\tThe kernel defaults to " << Kernel::KERNELS[0].name << "; all runs all kernels supported by this CPU\n"
+      "\t\tincluding the experimental ones.\n"
+      "\tsplit\tRound trip of a database (default: N=8-12) through q27db split,\n"
+      "\t\tq27solve -r:3 of the children and q27db join by the tools in dir\n"
+      "\t\t(default: .). A quarter of the parents is solved directly beforehand.\n"
+      "\t\tFails unless all parents end up solved with the known total.\n"
+      "\tclaim\tContention of concurrent DBEntry claims (default: 4M entries) by\n"
+      "\t\tthreads with their own strided DBCursors and with a shared one\n"
+      "\t\t(default: 1, 2, 4, ... up to twice the cores).\n"
+      "\tscan\tThroughput of the q27db stats scan of a database by the plain\n"
+      "\t\taccessor loop on one thread against the vectorized chunk scans with\n"
+      "\t\teach thread count (default: 1, 2, 4, ... up to the cores), best of\n"
+      "\t\tthe passes (default: 3) over the cached mapping.\n"
+      "\tload\tDrives a q27serve (default: 127.0.0.1:27027) by the given number of\n"
+      "\t\tclients (default: 100), which fetch batches of cases (default: 16),\n"
+      "\t\tsolve them for N and report them until the work or time is up.\n"
+      "\t\tReports the result rate and the fetch latencies.\n"
+	      << std::endl;
+    exit(1);
+  }
+
+  // Fsyncs the given file so that its data is accounted to the output path.
+  bool sync(char const *const  file) {
+    int const  fd = open(file, O_WRONLY);
+    if(fd < 0)  return  false;
+    bool const  ok = fsync(fd) == 0;
+    return  (close(fd) == 0) && ok;
+  }
+
+  //- Database Output --------------------------------------------------------
+  int write(int const  argc, char const *const  argv[]) {
+    if((argc < 1) || (argc > 2))  usage();
+    char const *const  file = argv[0];
+    uint64_t   const   mib  = argc > 1? strtoull(argv[1], 0, 0) : 1024;
+    uint64_t   const   n    = (mib << 20) / sizeof(DBEntry);
+
+    // Sample Entries cycled through by all Paths
+    std::vector<DBEntry>  sample;
+    for(unsigned  i = 0; i < 4096; i++) {
+      int8_t const  pre2[8] = {
+	int8_t(i&15), int8_t(i>>4&15), int8_t(i>>8&15), 3, 4, 5, 6, 7
+      };
+      sample.push_back(DBEntry(2, pre2, Symmetry::ROTATE));
+    }
+
+    std::cout << "Writing " << n << " entries (" << mib << " MiB) to " << file
+	      << " including fsync:\n" << std::endl;
+
+    typedef std::chrono::steady_clock  clock;
+    auto const  report = [&](char const *const  name, clock::time_point const  start) {
+      double const  elapsed = std::chrono::duration<double>(clock::now() - start).count();
+      std::cout << std::left << std::setw(10) << name << std::right
+		<< std::fixed << std::setprecision(3) << std::setw(9) << elapsed << " s"
+		<< std::setprecision(1) << std::setw(10) << (n*sizeof(DBEntry)/elapsed/(1<<20)) << " MiB/s"
+		<< std::endl;
+    };
+
+    { // std::fstream: one call per Entry as in the former DBCreator
+      auto const  start = clock::now();
+      std::ofstream  out(file, std::ofstream::out|std::ofstream::binary|std::ofstream::trunc);
+      for(uint64_t  i = 0; i < n; i++) {
+	out.write((char const*)&sample[i&4095], sizeof(DBEntry));
+      }
+      out.close();
+      if(!out || !sync(file)) {
+	std::cerr << "Writing " << file << " failed." << std::endl;
+	return  1;
+      }
+      report("fstream", start);
+    }
+
+    // DBWriter: preallocated as by the parallel DBCreator
+    DBWriter::Mode const  MODES[] = { DBWriter::BUFFERED, DBWriter::DIRECT, DBWriter::MAPPED };
+    for(DBWriter::Mode const  mode : MODES) {
+      auto const  start = clock::now();
+      try {
+	DBWriter  out(file, mode);
+	out.preallocate(n);
+	{
+	  DBWriter::Stream  s(out);
+	  for(uint64_t  i = 0; i < n; i++)  s.write(sample[i&4095]);
+	  s.close();
+	}
+	out.close();
+      }
+      catch(std::system_error const &e) {
+	std::cout << std::left << std::setw(10) << DBWriter::modeName(mode) << std::right
+		  << e.what() << std::endl;
+	continue;
+      }
+      if(!sync(file)) {
+	std::cerr << "Writing " << file << " failed." << std::endl;
+	return  1;
+      }
+      report(DBWriter::modeName(mode), start);
+    }
+    unlink(file);
+    return  0;
+
+  } // write()
+
+  //- Exploration ------------------------------------------------------------
+  // Known Solution Counts Q(N) (OEIS A000170)
+  uint64_t const  SOLUTIONS[] = {
+    UINT64_C(1),
+    UINT64_C(0),
+    UINT64_C(0),
+    UINT64_C(2),
+    UINT64_C(10),
+    UINT64_C(4),
+    UINT64_C(40),
+    UINT64_C(92),
+    UINT64_C(352),
+    UINT64_C(724),
+    UINT64_C(2680),
+    UINT64_C(14200),
+    UINT64_C(73712),
+    UINT64_C(365596),
+    UINT64_C(2279184),
+    UINT64_C(14772512),
+    UINT64_C(95815104),
+    UINT64_C(666090624),
+    UINT64_C(4968057848),
+    UINT64_C(39029188884),
+    UINT64_C(314666222712),
+    UINT64_C(2691008701644),
+    UINT64_C(24233937684440),
+    UINT64_C(227514171973736),
+    UINT64_C(2207893435808352),
+    UINT64_C(22317699616364044),
+    UINT64_C(234907967154122528)
+  };
+  unsigned const  MAX_KNOWN = sizeof(SOLUTIONS)/sizeof(SOLUTIONS[0]);
+
+  // Value of the given key in a JSON line of Numbers, or 0 if it is missing.
+  double field(std::string const &line, char const *const  key) {
+    std::string const  pat = std::string("\"") + key + "\":";
+    size_t const  pos = line.find(pat);
+    return  pos == std::string::npos? 0.0 : strtod(line.c_str() + pos + pat.size(), 0);
+  }
+
+  // Result of an exploration by coronal2 as taken from its stats stream
+  struct Run {
+    double    time;     // wall time including the process startup
+    double    search;   // time reported by coronal2 for its exploration
+    uint64_t  solutions;
+    uint64_t  nodes;
+
+  public:
+    Run() : time(0.0), search(0.0), solutions(0), nodes(0) {}
+  };
+
+  // Runs coronal2 -x with the given arguments and returns false if it
+  // failed or did not report its completion.
+  bool explore(char const *const  coronal2, unsigned const  N,
+	       Kernel const &kernel, unsigned const  threads, Run &run) {
+    int  fds[2];
+    if(pipe2(fds, O_CLOEXEC) != 0)  return  false;
+
+    std::string const  x = "-x:" + std::to_string(threads);
+    std::string const  k = std::string("-k:") + kernel.name;
+    std::string const  s = "-s:" + std::to_string(fds[1]);
+    std::string const  n = std::to_string(N);
+
+    auto const  start = std::chrono::steady_clock::now();
+    pid_t const  pid = fork();
+    if(pid == 0) {
+      // Child: the stats stream is inherited, the progress output dropped.
+      int const  null = open("/dev/null", O_WRONLY);
+      if((null < 0) || (dup2(null, 1) < 0))  _exit(127);
+      fcntl(fds[1], F_SETFD, 0);
+      execl(coronal2, coronal2, x.c_str(), k.c_str(), s.c_str(), n.c_str(), (char*)nullptr);
+      _exit(127);
+    }
+    close(fds[1]);
+    if(pid < 0) {
+      close(fds[0]);
+      return  false;
+    }
+
+    // Collect the Stream and keep its Finish Event
+    std::string  text;
+    {
+      char     buf[4096];
+      ssize_t  r;
+      while((r = read(fds[0], buf, sizeof(buf))) != 0) {
+	if(r > 0)  text.append(buf, r);
+	else if(errno != EINTR)  break;
+      }
+    }
+    close(fds[0]);
+
+    int  status;
+    while(waitpid(pid, &status, 0) < 0) {
+      if(errno != EINTR)  return  false;
+    }
+    run.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(!WIFEXITED(status) || (WEXITSTATUS(status) != 0))  return  false;
+
+    size_t const  pos = text.rfind("{\"event\":\"finish\"");
+    if(pos == std::string::npos)  return  false;
+    std::string const  line = text.substr(pos, text.find('\n', pos) - pos);
+    run.search    = field(line, "time");
+    run.solutions = (uint64_t)field(line, "solutions");
+    run.nodes     = (uint64_t)field(line, "nodes");
+    return  true;
+  }
+
+  int explore(int const  argc, char const *const  argv[]) {
+    char const *coronal2 = "./coronal2";
+    unsigned    from     =  8;
+    unsigned    to       = 20;
+    std::vector<unsigned>       threads;
+    std::vector<Kernel const*>  kernels;
+    enum { TABLE, CSV, JSON }   format = TABLE;
+
+    for(int  i = 0; i < argc; i++) {
+      char const *const  arg = argv[i];
+      char *end;
+      if(strncmp(arg, "-n:", 3) == 0) {
+	from = to = (unsigned)strtoul(arg+3, &end, 0);
+	if(*end == '-')  to = (unsigned)strtoul(end+1, &end, 0);
+	if((*end != '\0') || (from < Kernel::MIN_N) || (to < from) || (MAX_KNOWN < to)) {
+	  std::cerr << "Invalid board dimensions: " << (arg+3) << "\n\n";
+	  usage();
+	}
+      }
+      else if(strncmp(arg, "-t:", 3) == 0) {
+	end = const_cast<char*>(arg+2);
+	do {
+	  unsigned const  t = (unsigned)strtoul(end+1, &end, 0);
+	  if(t == 0)  break;
+	  if(std::find(threads.begin(), threads.end(), t) == threads.end())  threads.push_back(t);
+	}
+	while(*end == ',');
+	if(*end != '\0') {
+	  std::cerr << "Invalid thread counts: " << (arg+3) << "\n\n";
+	  usage();
+	}
+      }
+      else if(strncmp(arg, "-k:", 3) == 0) {
+	if(strcmp(arg+3, "all") == 0) {
+	  for(unsigned  j = 0; j < Kernel::NUM_KERNELS; j++) {
+	    if(Kernel::KERNELS[j].supported())  kernels.push_back(&Kernel::KERNELS[j]);
+	  }
+	}
+	else {
+	  Kernel const *const  k = Kernel::find(arg+3);
+	  if(k == nullptr) {
+	    std::cerr << "Unknown kernel: " << (arg+3) << "\n\n";
+	    usage();
+	  }
+	  kernels.push_back(k);
+	}
+      }
+      else if(strcmp(arg, "-f:table") == 0)  format = TABLE;
+      else if(strcmp(arg, "-f:csv")   == 0)  format = CSV;
+      else if(strcmp(arg, "-f:json")  == 0)  format = JSON;
+      else if(strncmp(arg, "-c:", 3) == 0)  coronal2 = arg+3;
+      else  usage();
+    }
+    if(threads.empty())  threads.push_back(1);
+    if(kernels.empty())  kernels.push_back(&Kernel::KERNELS[0]);
+
+    switch(format) {
+    case TABLE:
+      std::cout << " N  kernel      threads           solutions  ok      time s         nodes     nodes/s  speedup\n"
+		   "--  ----------  -------  ------------------  --  ----------  ------------  ----------  -------"
+		<< std::endl;
+      break;
+    case CSV:
+      std::cout << "n,kernel,threads,solutions,expected,ok,time_s,nodes,nodes_per_s,speedup" << std::endl;
+      break;
+    case JSON:
+      break;
+    }
+
+    unsigned  failed = 0;
+    for(unsigned  N = from; N <= to; N++) {
+      for(Kernel const *const  kernel : kernels) {
+	double  base = 0.0;  // time with the first thread count
+	for(unsigned const  t : threads) {
+	  Run   run;
+	  bool  ok = explore(coronal2, N, *kernel, t, run);
+	  if(!ok) {
+	    std::cerr << "Running " << coronal2 << " -x:" << t << " -k:" << kernel->name
+		      << ' ' << N << " failed." << std::endl;
+	    failed++;
+	    continue;
+	  }
+	  uint64_t const  expected = SOLUTIONS[N-1];
+	  ok = run.solutions == expected;
+	  if(!ok)  failed++;
+	  if(base == 0.0)  base = run.time;
+
+	  double const  rate    = run.search > 0.0? run.nodes / run.search : 0.0;
+	  double const  speedup = base / run.time;
+	  switch(format) {
+	  case TABLE:
+	    std::cout << std::setw(2) << N << "  " << std::left << std::setw(10) << kernel->name
+		      << std::right << std::setw(9) << t << std::setw(20) << run.solutions
+		      << (ok? "  ok" : "  NO")
+		      << std::fixed << std::setprecision(3) << std::setw(12) << run.time
+		      << std::setw(14) << run.nodes << std::setw(12) << Meter::rate(rate)
+		      << std::setprecision(2) << std::setw(9) << speedup << std::endl;
+	    break;
+	  case CSV:
+	    std::cout << N << ',' << kernel->name << ',' << t << ',' << run.solutions << ','
+		      << expected << ',' << (ok? 1 : 0) << ','
+		      << std::fixed << std::setprecision(3) << run.time << ',' << run.nodes << ','
+		      << std::setprecision(0) << rate << ','
+		      << std::setprecision(3) << speedup << std::endl;
+	    break;
+	  case JSON:
+	    std::cout << Meter::Event("explore")
+	      ("N", N)("kernel", kernel->name)("threads", t)
+	      ("solutions", run.solutions)("expected", expected)("ok", ok)
+	      ("time", run.time)("nodes", run.nodes)("nodes_per_s", rate)("speedup", speedup)
+	      .str() << std::endl;
+	    break;
+	  }
+	}
+      }
+    }
+    if(failed > 0) {
+      std::cerr << failed << " run(s) failed or miscounted." << std::endl;
+      return  1;
+    }
+    return  0;
+
+  } // explore()
+
+  //- Split Round Trip -------------------------------------------------------
+  // Runs the given command line with its output dropped and returns
+  // whether it exited successfully.
+  bool run(std::vector<std::string> const &args) {
+    pid_t const  pid = fork();
+    if(pid == 0) {
+      int const  null = open("/dev/null", O_WRONLY);
+      if((null < 0) || (dup2(null, 1) < 0))  _exit(127);
+      std::vector<char*>  argv;
+      for(std::string const &a : args)  argv.push_back(const_cast<char*>(a.c_str()));
+      argv.push_back(nullptr);
+      execv(argv[0], argv.data());
+      _exit(127);
+    }
+    if(pid < 0)  return  false;
+
+    int  status;
+    while(waitpid(pid, &status, 0) < 0) {
+      if(errno != EINTR)  return  false;
+    }
+    if(WIFEXITED(status) && (WEXITSTATUS(status) == 0))  return  true;
+    std::cerr << "Failed:";
+    for(std::string const &a : args)  std::cerr << ' ' << a;
+    std::cerr << std::endl;
+    return  false;
+  }
+
+  int split(int const  argc, char const *const  argv[]) {
+    std::string  dir  = ".";
+    unsigned     from =  8;
+    unsigned     to   = 12;
+    for(int  i = 0; i < argc; i++) {
+      char const *const  arg = argv[i];
+      char *end;
+      if(strncmp(arg, "-n:", 3) == 0) {
+	from = to = (unsigned)strtoul(arg+3, &end, 0);
+	if(*end == '-')  to = (unsigned)strtoul(end+1, &end, 0);
+	if((*end != '\0') || (from < 8) || (to < from) || (MAX_KNOWN < to)) {
+	  std::cerr << "Invalid board dimensions: " << (arg+3) << "\n\n";
+	  usage();
+	}
+      }
+      else if(strncmp(arg, "-d:", 3) == 0)  dir = arg+3;
+      else  usage();
+    }
+    std::string const  coronal2 = dir + "/coronal2";
+    std::string const  q27db    = dir + "/q27db";
+    std::string const  q27solve = dir + "/q27solve";
+
+    char  tmp[] = "/tmp/q27bench.XXXXXX";
+    if(mkdtemp(tmp) == nullptr) {
+      std::cerr << "Cannot create a temporary directory." << std::endl;
+      return  1;
+    }
+    std::string const  parents  = std::string(tmp) + "/parents.db";
+    std::string const  children = std::string(tmp) + "/children.db";
+
+    std::cout << " N   parents  children           solutions  ok      time s\n"
+		 "--  --------  --------  ------------------  --  ----------" << std::endl;
+    unsigned  failed = 0;
+    for(unsigned  N = from; N <= to; N++) {
+      std::string const  n = "-n:" + std::to_string(N);
+      auto const  start = std::chrono::steady_clock::now();
+
+      // Generate, solve a Quarter directly, split the Rest and join it back.
+      bool  ok = run({ coronal2, "-db:" + parents, std::to_string(N) });
+      struct stat  st;
+      uint64_t const  np = ok && (stat(parents.c_str(), &st) == 0)? st.st_size/sizeof(DBEntry) : 0;
+      std::string const  rest = "@" + std::to_string(np/4) + ":@" + std::to_string(np-1);
+      ok = ok && (np >= 4) &&
+	run({ q27solve, n, parents, "@0:@" + std::to_string(np/4-1) }) &&
+	run({ q27db, parents, "split", children, n, rest }) &&
+	run({ q27solve, "-r:3", n, children }) &&
+	run({ q27db, parents, "join", children, n, rest });
+      uint64_t const  nc = ok && (stat(children.c_str(), &st) == 0)? st.st_size/sizeof(DBEntry) : 0;
+      double const  elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      uint64_t  solutions = 0;
+      if(ok) {
+	try {
+	  Database const  db(parents.c_str(), boost::iostreams::mapped_file::readonly);
+	  DBStats  const  stats(db.roRange());
+	  solutions = stats.countAll;
+	  ok = (stats.solved == np) && (stats.wrapped == 0) && (solutions == SOLUTIONS[N-1]);
+	}
+	catch(std::runtime_error const &e) {
+	  std::cerr << e.what() << std::endl;
+	  ok = false;
+	}
+      }
+      if(!ok)  failed++;
+      std::cout << std::setw(2) << N << std::setw(10) << np << std::setw(10) << nc
+		<< std::setw(20) << solutions << (ok? "  ok" : "  NO")
+		<< std::fixed << std::setprecision(3) << std::setw(12) << elapsed << std::endl;
+      unlink(parents.c_str());
+      unlink(children.c_str());
+    }
+    rmdir(tmp);
+    if(failed > 0) {
+      std::cerr << failed << " round trip(s) failed or miscounted." << std::endl;
+      return  1;
+    }
+    return  0;
+
+  } // split()
+
+  //- Claim Contention -------------------------------------------------------
+  int claim(int const  argc, char const *const  argv[]) {
+    uint64_t               n = 1 << 22;
+    std::vector<unsigned>  threads;
+    for(int  i = 0; i < argc; i++) {
+      char const *const  arg = argv[i];
+      if(strncmp(arg, "-e:", 3) == 0)  n = strtoull(arg+3, 0, 0);
+      else if(strncmp(arg, "-t:", 3) == 0) {
+	char *end = const_cast<char*>(arg+2);
+	do {
+	  unsigned const  t = (unsigned)strtoul(end+1, &end, 0);
+	  if(t == 0)  break;
+	  threads.push_back(t);
+	}
+	while(*end == ',');
+	if(*end != '\0')  usage();
+      }
+      else  usage();
+    }
+    if(threads.empty()) {
+      for(unsigned  t = 1; t <= 2*std::thread::hardware_concurrency(); t *= 2)  threads.push_back(t);
+    }
+
+    // Fresh Entries in Memory
+    std::unique_ptr<DBEntry[]>  fresh(new DBEntry[n]);
+    std::unique_ptr<DBEntry[]>  db   (new DBEntry[n]);
+    for(uint64_t  i = 0; i < n; i++) {
+      int8_t const  pre2[8] = {
+	int8_t(i&15), int8_t(i>>4&15), int8_t(i>>8&15), int8_t(i>>12&15), 4, 5, 6, 7
+      };
+      fresh[i] = DBEntry(2, pre2, Symmetry::ROTATE);
+    }
+    DBRange const  range(db.get(), db.get()+n, 2);
+
+    std::cout << "Claiming " << n << " entries:\n\n"
+	      << "mode     threads      time s    claims/s  speedup\n"
+	      << "-------  -------  ----------  ----------  -------" << std::endl;
+    unsigned  failed = 0;
+    for(bool const  strided : { true, false }) {
+      double  base = 0.0;
+      for(unsigned const  t : threads) {
+	std::copy(fresh.get(), fresh.get()+n, db.get());
+
+	// Strided workers each have their own cursor; shared ones all
+	// start at the same entry and contend for every claim.
+	std::vector<uint64_t>     claims(t);
+	std::vector<std::thread>  workers;
+	auto const  start = std::chrono::steady_clock::now();
+	for(unsigned  w = 0; w < t; w++) {
+	  workers.emplace_back([&, w]() {
+	      DBCursor  cursor(range, strided? w : 0, strided? t : 1);
+	      uint64_t  cnt = 0;
+	      while(cursor.claim() != nullptr)  cnt++;
+	      claims[w] = cnt;
+	    });
+	}
+	for(std::thread &w : workers)  w.join();
+	double const  elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// Every Entry exactly once
+	uint64_t  total = 0;
+	for(uint64_t const  c : claims)  total += c;
+	bool  ok = total == n;
+	for(uint64_t  i = 0; ok && (i < n); i++)  ok = db[i].taken(2);
+	if(!ok)  failed++;
+	if(base == 0.0)  base = elapsed;
+
+	std::cout << std::left << std::setw(7) << (strided? "strided" : "shared") << std::right
+		  << std::setw(9) << t << std::fixed << std::setprecision(3) << std::setw(12) << elapsed
+		  << std::setw(12) << Meter::rate(n/elapsed)
+		  << std::setprecision(2) << std::setw(9) << (base/elapsed)
+		  << (ok? "" : "  MISCLAIMED") << std::endl;
+      }
+    }
+    if(failed > 0) {
+      std::cerr << failed << " run(s) did not claim every entry exactly once." << std::endl;
+      return  1;
+    }
+    return  0;
+
+  } // claim()
+
+  //- Database Scan ----------------------------------------------------------
+  int scan(int const  argc, char const *const  argv[]) {
+    if(argc < 1)  usage();
+    std::vector<unsigned>  threads;
+    unsigned  passes = 3;
+    unsigned  rings  = 0;  // detected
+    for(int  i = 1; i < argc; i++) {
+      char const *const  arg = argv[i];
+      if(strcmp(arg, "-r:3") == 0)  rings = 3;
+      else if(strncmp(arg, "-p:", 3) == 0)  passes = (unsigned)strtoul(arg+3, 0, 0);
+      else if(strncmp(arg, "-t:", 3) == 0) {
+	char *end = const_cast<char*>(arg+2);
+	do {
+	  unsigned const  t = (unsigned)strtoul(end+1, &end, 0);
+	  if(t == 0)  break;
+	  threads.push_back(t);
+	}
+	while(*end == ',');
+	if(*end != '\0')  usage();
+      }
+      else  usage();
+    }
+    if(passes == 0)  passes = 1;
+    if(threads.empty()) {
+      for(unsigned  t = 1; t <= std::thread::hardware_concurrency(); t *= 2)  threads.push_back(t);
+    }
+
+    std::unique_ptr<Database const>  dbp;
+    try {
+      dbp.reset(new Database(argv[0], boost::iostreams::mapped_file::readonly, rings));
+    }
+    catch(std::runtime_error const &e) {
+      std::cerr << e.what() << std::endl;
+      return  1;
+    }
+    DBConstRange const  db(dbp->roRange());
+    double const  bytes = double(db.size())*sizeof(DBEntry);
+
+    // Best of the Passes, the first one also pulls the file into the cache.
+    auto const  time = [&](unsigned  t, bool  vectorize, DBStats &st) {
+      double  best = 0.0;
+      for(unsigned  p = 0; p <= passes; p++) {
+	auto const  start = std::chrono::steady_clock::now();
+	st = DBStats(db, t, vectorize);
+	double const  elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if((p > 0) && ((best == 0.0) || (elapsed < best)))  best = elapsed;
+      }
+      return  best;
+    };
+    auto const  same = [](DBStats const &a, DBStats const &b) {
+      return (a.entries == b.entries) && (a.invalid == b.invalid) && (a.taken == b.taken) &&
+	(a.solved == b.solved) && (a.wrapped == b.wrapped) && (a.gapped == b.gapped) &&
+	(a.count == b.count) && (a.mod13 == b.mod13) && (a.mod15 == b.mod15) &&
+	(a.countAll == b.countAll) && (a.mod13All == b.mod13All) && (a.mod15All == b.mod15All);
+    };
+
+    std::cout << "Scanning " << db.size() << " entries (" << std::fixed << std::setprecision(1)
+	      << bytes/(1<<20) << " MiB):\n\n"
+	      << "mode     threads      time s      GB/s  speedup\n"
+	      << "-------  -------  ----------  --------  -------" << std::endl;
+    DBStats  ref;
+    double const  base = time(1, false, ref);
+    std::cout << "entries        1" << std::setprecision(3) << std::setw(12) << base
+	      << std::setprecision(2) << std::setw(10) << (bytes/base/1e9)
+	      << std::setw(9) << 1.0 << std::endl;
+
+    unsigned  failed = 0;
+    for(unsigned const  t : threads) {
+      DBStats  st;
+      double const  elapsed = time(t, true, st);
+      bool const  ok = same(st, ref);
+      if(!ok)  failed++;
+      std::cout << "lanes  " << std::setw(9) << t << std::setprecision(3) << std::setw(12) << elapsed
+		<< std::setprecision(2) << std::setw(10) << (bytes/elapsed/1e9)
+		<< std::setw(9) << (base/elapsed) << (ok? "" : "  MISMATCH") << std::endl;
+    }
+    if(failed > 0) {
+      std::cerr << failed << " run(s) disagreed with the plain scan." << std::endl;
+      return  1;
+    }
+    return  0;
+
+  } // scan()
+
+  //- Server Load ------------------------------------------------------------
+  // Simulated Client of the Q27 Protocol
+  struct LoadClient {
+    int          fd;
+    std::string  in;
+    std::string  out;
+    bool         writing;
+    bool         done;     // received the end of the work
+    std::chrono::steady_clock::time_point  asked;  // last FETCH_CASES
+
+  public:
+    LoadClient() : fd(-1), writing(false), done(false) {}
+    ~LoadClient() { if(fd >= 0)  close(fd); }
+  };
+
+  int load(int const  argc, char const *const  argv[]) {
+    char const *host    = "127.0.0.1";
+    unsigned    port    = 27027;
+    unsigned    clients = 100;
+    unsigned    batch   = 16;
+    unsigned    N       = 0;
+    double      limit   = 0.0;
+    for(int  i = 0; i < argc; i++) {
+      char const *const  arg = argv[i];
+      if(strncmp(arg, "-h:", 3) == 0)  host = arg+3;
+      else if(strncmp(arg, "-p:", 3) == 0)  port    = (unsigned)strtoul(arg+3, 0, 0);
+      else if(strncmp(arg, "-c:", 3) == 0)  clients = (unsigned)strtoul(arg+3, 0, 0);
+      else if(strncmp(arg, "-b:", 3) == 0)  batch   = (unsigned)strtoul(arg+3, 0, 0);
+      else if(strncmp(arg, "-n:", 3) == 0)  N       = (unsigned)strtoul(arg+3, 0, 0);
+      else if(strncmp(arg, "-d:", 3) == 0)  limit   = strtod(arg+3, 0);
+      else  usage();
+    }
+    if((N < Kernel::MIN_N) || (Kernel::MAX_N < N) || (clients == 0) || (batch == 0)) {
+      std::cerr << "Need a board dimension from " << Kernel::MIN_N << ".." << Kernel::MAX_N
+		<< ", at least one client and a positive batch size.\n\n";
+      usage();
+    }
+
+    sockaddr_in  addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(port);
+    if(inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+      std::cerr << "Invalid IPv4 address: " << host << std::endl;
+      return  1;
+    }
+
+    int const  ep = epoll_create1(EPOLL_CLOEXEC);
+    if(ep < 0) {
+      std::cerr << "epoll_create1: " << strerror(errno) << std::endl;
+      return  1;
+    }
+    auto const  arm = [ep](LoadClient &c, int  op) {
+      epoll_event  ev;
+      ev.events  = EPOLLIN|(c.writing? EPOLLOUT : 0);
+      ev.data.fd = c.fd;
+      return  epoll_ctl(ep, op, c.fd, &ev) == 0;
+    };
+    auto const  fetch = [batch](LoadClient &c) {
+      c.out.push_back(char(protocol::FETCH_CASES));
+      protocol::put32(c.out, batch);
+      c.asked = std::chrono::steady_clock::now();
+    };
+
+    // Connect all Clients
+    std::map<int, std::unique_ptr<LoadClient>>  conns;
+    for(unsigned  i = 0; i < clients; i++) {
+      std::unique_ptr<LoadClient>  c(new LoadClient());
+      c->fd = socket(AF_INET, SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC, 0);
+      if((c->fd < 0) ||
+	 ((connect(c->fd, (sockaddr const*)&addr, sizeof(addr)) != 0) && (errno != EINPROGRESS))) {
+	std::cerr << "Connecting client #" << i << " failed: " << strerror(errno) << std::endl;
+	close(ep);
+	return  1;
+      }
+      int const  one = 1;
+      setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+      std::string const  name = "load #" + std::to_string(i);
+      c->out.push_back(char(protocol::ANNOUNCE_SOLVER));
+      protocol::put32(c->out, 1);
+      c->out.push_back(char(name.size() >> 8));
+      c->out.push_back(char(name.size()));
+      c->out += name;
+      fetch(*c);
+      c->writing = true;
+      arm(*c, EPOLL_CTL_ADD);
+      int const  fd = c->fd;
+      conns[fd] = std::move(c);
+    }
+    std::cout << "Connected " << clients << " clients to " << host << ':' << port
+	      << " fetching " << batch << " cases at a time for N=" << N << " ..." << std::endl;
+
+    // Serve the Clients until the Work or the Time is up
+    Kernel::solve_t const  solve = Kernel::KERNELS[0].specialize(N);
+    auto const  start = std::chrono::steady_clock::now();
+    uint64_t  results = 0;
+    uint64_t  total   = 0;  // solutions of the solved cases
+    uint64_t  fetches = 0;
+    uint64_t  nodes   = 0;
+    double    latency = 0.0;
+    double    worst   = 0.0;
+    unsigned  failed  = 0;
+    unsigned  active  = clients;
+    epoll_event  evs[256];
+    while(active > 0) {
+      auto const  now = std::chrono::steady_clock::now();
+      if((limit > 0.0) && (std::chrono::duration<double>(now - start).count() >= limit))  break;
+
+      int const  k = epoll_wait(ep, evs, sizeof(evs)/sizeof(evs[0]), 1000);
+      if((k < 0) && (errno != EINTR)) {
+	std::cerr << "epoll_wait: " << strerror(errno) << std::endl;
+	break;
+      }
+      for(int  i = 0; i < k; i++) {
+	auto const  it = conns.find(evs[i].data.fd);
+	if(it == conns.end())  continue;
+	LoadClient &c = *it->second;
+	bool  broken = (evs[i].events & (EPOLLERR|EPOLLHUP)) != 0;
+
+	// Receive Cases and report their Results
+	if(!broken && (evs[i].events & EPOLLIN)) {
+	  char  buf[1<<16];
+	  ssize_t  r;
+	  while((r = ::read(c.fd, buf, sizeof(buf))) > 0)  c.in.append(buf, r);
+	  if((r == 0) || ((r < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK)))  broken = true;
+
+	  size_t const  reply = 8*size_t(batch);
+	  while(!c.done && (c.in.size() >= reply)) {
+	    double const  lat = std::chrono::duration<double>(std::chrono::steady_clock::now() - c.asked).count();
+	    latency += lat;
+	    if(lat > worst)  worst = lat;
+	    fetches++;
+
+	    for(unsigned  j = 0; j < batch; j++) {
+	      uint64_t const  spec = protocol::get64((uint8_t const*)c.in.data() + 8*j);
+	      if(spec == 0) {
+		c.done = true;
+		continue;
+	      }
+	      uint64be_t const  raw[2] = { spec << 20, 0 };
+	      DBEntry const &e = *reinterpret_cast<DBEntry const*>(raw);
+	      uint64_t  bv, bh, bu, bd;
+	      if(!e.expand(2, N, bv, bh, bu, bd)) {
+		std::cerr << "Case " << e.format(2) << " is no valid pre-placement for N=" << N << '.' << std::endl;
+		close(ep);
+		return  1;
+	      }
+	      Blocking const  b = Blocking::fromBoard(N, bv, bh, bu, bd);
+	      uint64_t  cnt;
+	      solve(&b, 1, &cnt, nodes);
+	      total += cnt * e.sym(2).weight();
+	      results++;
+
+	      c.out.push_back(char(protocol::REPORT_RESULT));
+	      protocol::put32(c.out, 1);
+	      protocol::put64(c.out, spec);
+	      protocol::put64(c.out, protocol::result(cnt));
+	    }
+	    c.in.erase(0, reply);
+	    if(!c.done)  fetch(c);
+	  }
+	}
+
+	// Send pending Commands
+	if(!broken) {
+	  while(!c.out.empty()) {
+	    ssize_t const  w = ::send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+	    if(w > 0)  c.out.erase(0, w);
+	    else {
+	      if((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))  broken = true;
+	      break;
+	    }
+	  }
+	}
+	if(broken || (c.done && c.out.empty())) {
+	  if(broken) {
+	    std::cerr << "Client connection lost." << std::endl;
+	    failed++;
+	  }
+	  epoll_ctl(ep, EPOLL_CTL_DEL, c.fd, nullptr);
+	  conns.erase(it);
+	  active--;
+	  continue;
+	}
+	if(c.writing != !c.out.empty()) {
+	  c.writing = !c.writing;
+	  arm(c, EPOLL_CTL_MOD);
+	}
+      }
+    }
+    close(ep);
+
+    double const  elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Reported " << results << " results in " << std::fixed << std::setprecision(3)
+	      << elapsed << " s (" << Meter::rate(results/elapsed) << " results/s) with "
+	      << fetches << " fetches of " << std::setprecision(3) << (fetches? 1e3*latency/fetches : 0.0)
+	      << " ms average, " << (1e3*worst) << " ms worst latency.\n"
+	      << "Solutions of the reported cases: " << total;
+    if((active == 0) && (N <= MAX_KNOWN)) {
+      std::cout << (total == SOLUTIONS[N-1]? " (complete)" : " (partial)");
+    }
+    std::cout << std::endl;
+    if(failed > 0) {
+      std::cerr << failed << " client(s) failed." << std::endl;
+      return  1;
+    }
+    return  0;
+
+  } // load()
+
+  struct {
+    char const *cmd;
+    int(*fct)(int, char const*const*);
+  } const  COMMANDS[] = {
+    {"write",   write},
+    {"explore", explore},
+    {"split",   split},
+    {"claim",   claim},
+    {"scan",    scan},
+    {"load",    load}
+  };
+
+} // anonymous namespace
+
+int main(int const  argc, char const *const  argv[]) {
+  prog = argv[0];
+  if(argc < 2)  usage();
+
+  char const *const  cmd = argv[1];
+  for(auto const &c : COMMANDS) {
+    if(strcmp(cmd, c.cmd) == 0)  return  c.fct(argc-2, argv+2);
+  }
+  std::cerr << "Unknown command: " << cmd << "\n\n";
+  usage();
+  return  1;
+
+} // main()
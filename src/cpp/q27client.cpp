@@ -0,0 +1,429 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <errno.h>
+#include <netdb.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include "DBEntry.hpp"
+#include "Kernel.hpp"
+#include "Protocol.hpp"
+#include "WorkPool.hpp"
+
+using namespace queens;
+using namespace queens::protocol;
+
+namespace {
+
+  char const *prog = "q27client";
+
+  // Usage Output
+  void usage() {
+    std::cerr << prog <<
+      " [-x:<threads>] [-k:<kernel>] [-n:<dim>] [-b:<cases>] [-w:<sec>]"
+      " [-ca:<ca.pem> [-cert:<cert.pem> -key:<key.pem>]] <host>[:<port>]\n\n"
+      "Solves the cases served by a Q27 server (q27serve or the Java Server)\n"
+      "on the CPU until the server runs out of work.\n\n"
+      "\t-x\tNumber of worker threads (default: all cores).\n"
+      "\t-k\tCompletion kernel:";
+    for(unsigned  i = 0; i < Kernel::NUM_KERNELS; i++) {
+      std::cerr << ' ' << Kernel::KERNELS[i].name;
+      if(Kernel::KERNELS[i].experimental)  std::cerr << " (experimental)";
+    }
+    std::cerr << "\n\t\t(default: " << Kernel::KERNELS[0].name << ").\n"
+      "\t-n\tBoard dimension of the served database (default: 27).\n"
+      "\t-b\tCases per fetch (default: 16 per thread). The next fetch is\n"
+      "\t\tprefetched while the current one is being solved.\n"
+      "\t-w\tDelay before reconnecting a broken connection (default: 30s).\n"
+      "\t-ca\tConnect by TLS trusting the given certificates; -cert and -key\n"
+      "\t\tauthenticate the client as required by the Java Server.\n"
+      "\nThe port defaults to 27027.\n"
+	      << std::endl;
+    exit(1);
+  }
+
+  // Termination Request by Signal
+  volatile sig_atomic_t  stopped = 0;
+  void stop(int) { stopped = 1; }
+
+  std::string sslError() {
+    char  buf[256];
+    unsigned long const  err = ERR_get_error();
+    if(err == 0)  return  strerror(errno);
+    ERR_error_string_n(err, buf, sizeof(buf));
+    return  buf;
+  }
+
+ /**
+  * Blocking connection to the server, plain or by TLS. Failures are
+  * reported by a std::runtime_error.
+  */
+  class Channel {
+    int       m_fd;
+    SSL_CTX  *m_ctx;
+    SSL      *m_ssl;
+
+  public:
+    Channel(std::string const &host, std::string const &port, SSL_CTX *ctx);
+    ~Channel();
+
+  private:
+    Channel(Channel const&) = delete;
+    Channel& operator=(Channel const&) = delete;
+
+  public:
+    void read (void *buf, size_t  len);
+    void write(std::string const &buf);
+  }; // class Channel
+
+  Channel::Channel(std::string const &host, std::string const &port, SSL_CTX *const  ctx)
+    : m_fd(-1), m_ctx(ctx), m_ssl(nullptr) {
+
+    addrinfo  hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *res;
+    int const  rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &res);
+    if(rc != 0)  throw  std::runtime_error(host + ": " + gai_strerror(rc));
+    for(addrinfo *a = res; a != nullptr; a = a->ai_next) {
+      m_fd = socket(a->ai_family, a->ai_socktype|SOCK_CLOEXEC, a->ai_protocol);
+      if(m_fd < 0)  continue;
+      if(connect(m_fd, a->ai_addr, a->ai_addrlen) == 0)  break;
+      close(m_fd);
+      m_fd = -1;
+    }
+    freeaddrinfo(res);
+    if(m_fd < 0)  throw  std::runtime_error("Cannot connect to " + host + ':' + port + ": " + strerror(errno));
+    int const  one = 1;
+    setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if(ctx != nullptr) {
+      m_ssl = SSL_new(ctx);
+      if((m_ssl == nullptr) ||
+	 (SSL_set_fd(m_ssl, m_fd) != 1) ||
+	 (SSL_set_tlsext_host_name(m_ssl, host.c_str()) != 1) ||
+	 (SSL_connect(m_ssl) != 1)) {
+	std::string const  msg = "TLS handshake with " + host + " failed: " + sslError();
+	if(m_ssl != nullptr)  SSL_free(m_ssl);
+	close(m_fd);
+	throw  std::runtime_error(msg);
+      }
+    }
+  }
+
+  Channel::~Channel() {
+    if(m_ssl != nullptr) {
+      SSL_shutdown(m_ssl);
+      SSL_free(m_ssl);
+    }
+    close(m_fd);
+  }
+
+  void Channel::read(void *const  buf, size_t const  len) {
+    char  *p = static_cast<char*>(buf);
+    size_t ofs = 0;
+    while(ofs < len) {
+      int const  k = m_ssl != nullptr? SSL_read(m_ssl, p+ofs, int(len-ofs)) : int(::read(m_fd, p+ofs, len-ofs));
+      if(k > 0) {
+	ofs += k;
+	continue;
+      }
+      if((k < 0) && (m_ssl == nullptr) && (errno == EINTR))  continue;
+      throw  std::runtime_error(k == 0? std::string("Connection closed by the server") : "Receiving failed: " + sslError());
+    }
+  }
+
+  void Channel::write(std::string const &buf) {
+    size_t  ofs = 0;
+    while(ofs < buf.size()) {
+      int const  k = m_ssl != nullptr? SSL_write(m_ssl, buf.data()+ofs, int(buf.size()-ofs))
+	                             : int(::send(m_fd, buf.data()+ofs, buf.size()-ofs, MSG_NOSIGNAL));
+      if(k > 0) {
+	ofs += k;
+	continue;
+      }
+      if((k < 0) && (m_ssl == nullptr) && (errno == EINTR))  continue;
+      throw  std::runtime_error("Sending failed: " + sslError());
+    }
+  }
+
+  // Cases handed to the Workers: spec and count
+  typedef std::vector<std::pair<uint64_t, uint64_t>>  Batch;
+  unsigned const  BATCH_SIZE = 16;
+
+} // anonymous namespace
+
+int main(int const  argc, char const *const  argv[]) {
+  prog = *argv;
+
+  // Parse Options
+  unsigned      threads = std::thread::hardware_concurrency();
+  Kernel const *kernel  = &Kernel::KERNELS[0];
+  unsigned      N       = 27;
+  unsigned      cases   = 0;
+  unsigned      wait    = 30;
+  char const   *ca      = nullptr;
+  char const   *cert    = nullptr;
+  char const   *key     = nullptr;
+
+  int  i = 1;
+  for(; (i < argc) && (argv[i][0] == '-'); i++) {
+    char const *const  arg = argv[i];
+    if(strncmp(arg, "-x:", 3) == 0)  threads = (unsigned)strtoul(arg+3, 0, 0);
+    else if(strncmp(arg, "-n:", 3) == 0)  N     = (unsigned)strtoul(arg+3, 0, 0);
+    else if(strncmp(arg, "-b:", 3) == 0)  cases = (unsigned)strtoul(arg+3, 0, 0);
+    else if(strncmp(arg, "-w:", 3) == 0)  wait  = (unsigned)strtoul(arg+3, 0, 0);
+    else if(strncmp(arg, "-ca:",   4) == 0)  ca   = arg+4;
+    else if(strncmp(arg, "-cert:", 6) == 0)  cert = arg+6;
+    else if(strncmp(arg, "-key:",  5) == 0)  key  = arg+5;
+    else if(strncmp(arg, "-k:", 3) == 0) {
+      kernel = Kernel::find(arg+3);
+      if(kernel == nullptr) {
+	std::cerr << "Unknown kernel: " << (arg+3) << "\n\n";
+	usage();
+      }
+      if(!kernel->supported()) {
+	std::cerr << "Kernel " << kernel->name << " is not supported by this CPU." << std::endl;
+	return  1;
+      }
+    }
+    else {
+      std::cerr << "Unknown option: " << arg << "\n\n";
+      usage();
+    }
+  }
+  if(argc-i != 1)  usage();
+  if((N < Kernel::MIN_N) || (Kernel::MAX_N < N)) {
+    std::cerr << "Board dimension must be from " << Kernel::MIN_N << ".." << Kernel::MAX_N << ".\n\n";
+    usage();
+  }
+  if((cert == nullptr) != (key == nullptr) || ((cert != nullptr) && (ca == nullptr))) {
+    std::cerr << "A client certificate needs its key and -ca.\n\n";
+    usage();
+  }
+  if(threads == 0)  threads = 1;
+  if(cases   == 0)  cases   = BATCH_SIZE*threads;
+
+  std::string  host = argv[i];
+  std::string  port = "27027";
+  {
+    size_t const  colon = host.rfind(':');
+    if((colon != std::string::npos) && (host.find(':') == colon)) {
+      port = host.substr(colon+1);
+      host.resize(colon);
+    }
+  }
+
+  // TLS Context
+  std::unique_ptr<SSL_CTX, void(*)(SSL_CTX*)>  ctx(nullptr, SSL_CTX_free);
+  if(ca != nullptr) {
+    ctx.reset(SSL_CTX_new(TLS_client_method()));
+    if(!ctx ||
+       (SSL_CTX_load_verify_locations(ctx.get(), ca, nullptr) != 1) ||
+       ((cert != nullptr) && (SSL_CTX_use_certificate_chain_file(ctx.get(), cert) != 1)) ||
+       ((key  != nullptr) && (SSL_CTX_use_PrivateKey_file(ctx.get(), key, SSL_FILETYPE_PEM) != 1))) {
+      std::cerr << "Setting up TLS failed: " << sslError() << std::endl;
+      return  1;
+    }
+    SSL_CTX_set_verify(ctx.get(), SSL_VERIFY_PEER, nullptr);
+  }
+
+  std::string  name = "q27client ";
+  {
+    char  buf[256];
+    if(gethostname(buf, sizeof(buf)) == 0) {
+      buf[sizeof(buf)-1] = '\0';
+      name += buf;
+      name += ' ';
+    }
+    name += kernel->name;
+    name += " x" + std::to_string(threads);
+  }
+
+  // Completion Workers: solved Batches are collected for the next report.
+  Kernel::solve_t const   solve = kernel->specialize(N);
+  std::mutex               lock;
+  std::condition_variable  solved;
+  Batch                    results;
+  std::atomic<uint64_t>    nodes(0);
+  bool                     invalid = false;
+  WorkPool<Batch>  pool(threads, [&](unsigned, Batch &b) {
+      Blocking  blk[BATCH_SIZE];
+      uint64_t  cnt[BATCH_SIZE];
+      unsigned const  n = b.size();
+      bool  ok = true;
+      for(unsigned  j = 0; j < n; j++) {
+	// The server hands out the specs of two rings.
+	uint64be_t const  raw[2] = { b[j].first << 20, 0 };
+	uint64_t  bv, bh, bu, bd;
+	if(!reinterpret_cast<DBEntry const*>(raw)->expand(2, N, bv, bh, bu, bd))  ok = false;
+	else  blk[j] = Blocking::fromBoard(N, bv, bh, bu, bd);
+      }
+      uint64_t  nds = 0;
+      if(ok)  solve(blk, n, cnt, nds);
+      nodes += nds;
+      {
+	std::lock_guard<std::mutex>  lk(lock);
+	if(!ok)  invalid = true;
+	else {
+	  for(unsigned  j = 0; j < n; j++)  results.push_back(std::make_pair(b[j].first, cnt[j]));
+	}
+      }
+      solved.notify_one();
+    });
+
+  signal(SIGINT,  stop);
+  signal(SIGTERM, stop);
+  signal(SIGPIPE, SIG_IGN);
+  std::cout << "Solving for N=" << N << " from " << host << ':' << port << (ctx? " (TLS)" : "")
+	    << " using kernel " << kernel->name << " on " << threads << " thread(s) ..." << std::endl;
+
+  // Network Loop: keep a fetch ahead of the workers and report all results
+  // completed in the meantime in a single write.
+  auto const  start = std::chrono::steady_clock::now();
+  auto        last  = start;
+  std::unique_ptr<Channel>  chan;
+  Batch     unsent;            // solved but not reported
+  uint64_t  outstanding = 0;   // fetched but not solved
+  uint64_t  reported    = 0;
+  bool      exhausted   = false;
+  while(!exhausted || (outstanding > 0) || !unsent.empty()) {
+    try {
+      if(!chan) {
+	chan.reset(new Channel(host, port, ctx.get()));
+	std::string  msg;
+	msg.push_back(char(ANNOUNCE_SOLVER));
+	put32(msg, 1);
+	msg.push_back(char(name.size() >> 8));
+	msg.push_back(char(name.size()));
+	msg += name;
+	chan->write(msg);
+      }
+
+      // Prefetch
+      if(stopped)  exhausted = true;
+      while(!exhausted && (outstanding < 2*uint64_t(cases))) {
+	std::string  msg;
+	msg.push_back(char(FETCH_CASES));
+	put32(msg, cases);
+	chan->write(msg);
+
+	std::vector<uint8_t>  buf(8*size_t(cases));
+	chan->read(buf.data(), buf.size());
+	Batch  b;
+	for(unsigned  j = 0; j < cases; j++) {
+	  uint64_t const  spec = get64(&buf[8*j]);
+	  if(spec == 0) {
+	    exhausted = true;
+	    continue;
+	  }
+	  b.push_back(std::make_pair(spec, 0));
+	  if(b.size() == BATCH_SIZE) {
+	    pool.submit(std::move(b));
+	    b = Batch();
+	  }
+	  outstanding++;
+	}
+	if(!b.empty())  pool.submit(std::move(b));
+      }
+
+      // Collect and report Results
+      {
+	std::unique_lock<std::mutex>  lk(lock);
+	solved.wait_for(lk, std::chrono::seconds(1), [&]() { return  !results.empty() || invalid; });
+	if(invalid) {
+	  std::cerr << "\nThe server handed out a case that is no valid pre-placement for N=" << N << '.' << std::endl;
+	  return  1;
+	}
+	outstanding -= results.size();
+	unsent.insert(unsent.end(), results.begin(), results.end());
+	results.clear();
+      }
+      if(!unsent.empty()) {
+	std::string  msg;
+	for(auto const &r : unsent) {
+	  msg.push_back(char(REPORT_RESULT));
+	  put32(msg, 1);
+	  put64(msg, r.first);
+	  put64(msg, result(r.second));
+	}
+	chan->write(msg);
+	reported += unsent.size();
+	unsent.clear();
+      }
+    }
+    catch(std::runtime_error const &e) {
+      // Cases lost with the connection are handed out again by the server
+      // after their lease expires. Solved ones are reported on reconnect.
+      chan.reset();
+      std::cerr << '\n' << e.what() << "\nReconnecting in " << wait << "s ..." << std::endl;
+      for(unsigned  s = 0; (s < wait) && !stopped; s++)  sleep(1);
+      if(stopped)  break;
+      continue;
+    }
+
+    auto const  now = std::chrono::steady_clock::now();
+    if(now - last >= std::chrono::seconds(1)) {
+      std::cout << "\rReported: " << reported << std::flush;
+      last = now;
+    }
+  }
+  pool.close();
+  if(chan) {
+    std::string  msg;
+    msg.push_back(char(DENOUNCE_SOLVER));
+    put32(msg, 1);
+    try { chan->write(msg); }
+    catch(std::runtime_error const&) {}
+    chan.reset();
+  }
+
+  double const  elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "\rReported: " << reported << " cases"
+	    << "\nTime:     " << std::fixed << std::setprecision(3) << elapsed << " s"
+	    << "\nRate:     " << std::setprecision(1) << (reported/elapsed) << " cases/s"
+	    << "\nNodes:    " << nodes.load() << " (" << (uint64_t)(nodes.load()/elapsed) << "/s)"
+	    << std::endl;
+  return  unsent.empty()? 0 : 1;
+
+} // main()
@@ -22,11 +22,29 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <algorithm>
+#include <functional>
+#include <atomic>
+#include <chrono>
 #include <map>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <vector>
 
+#include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/sendfile.h>
 
 #include "Database.hpp"
+#include "DBArchive.hpp"
+#include "DBColumns.hpp"
+#include "DBStats.hpp"
+#include "DBWriter.hpp"
+#include "Kernel.hpp"
+#include "ZoneMap.hpp"
 #include "range/RangeParser.hpp"
 #include "range/IR.hpp"
 
@@ -39,104 +57,267 @@ namespace {
 
   // Usage Output
   void usage() {
-    std::cout << prog << " <queens.db>\tstats\n"
+    std::cout << prog << " [-r:3] <queens.db>\tstats [-x:<threads>]\n"
+      "\t\t\tindex [-x:<threads>]\n"
       "\t\t\tfreq\n"
-      "\t\t\tslice <output.db> [taken|stale <timeout_min>]\n"
+      "\t\t\tslice <output.db> [<range> ...] [[!]taken|solved|wrapped|valid|stale <timeout_min>]\n"
       "\t\t\tuntake\n"
-      "\t\t\tmerge <contrib.db> <secondary.db>\n"
+      "\t\t\tmerge <contrib.db> ... <secondary.db>\n"
       "\t\t\tprint <range> ...\n"
+      "\t\t\texpand <output.bin> vhdl|soa [-n:<dim>] [<range> ...]\n"
+      "\t\t\tsplit <children.db> [-n:<dim>] [<range> ...]\n"
+      "\t\t\tjoin <children.db> [-n:<dim>] [-s:<solver>] [<range> ...]\n"
+      "\t\t\tcost <costs.bin> [-n:<dim>] [-p:<probes>] [-x:<threads>]\n"
+      "\t\t\tschedule <costs.bin> [-c] [<range> ...]\n"
+      "\t\t\tcompress <archive.db>\n"
+      "\t\t\tcolumns <base>\n"
+      "\t\t\tsolvers\n"
+      "\t<archive.db>\tstats [-x:<threads>] | freq | print <range> ... | queens | solvers\n"
+      "\t\t\tdecompress <output.db>\n"
+      "\t<base>\t\tstats [-x:<threads>] | freq | queens | solvers\n"
+      "\t\t\trows <output.db>\n\n"
+      "\tindex\tBuilds or refreshes the block summaries in <queens.db>.zmap,\n"
+      "\t\twhich let stats and range searches skip completely solved blocks.\n"
+      "\tslice\tCopies the range, optionally only its entries of the given kind.\n"
+      "\tmerge\tMerges the solved entries of all contributions in one sweep,\n"
+      "\t\tappending other solutions of solved entries to <secondary.db>.\n"
+      "\tcompress Writes a block-compressed, read-only archive of the database,\n"
+      "\t\twhich the commands listed for <archive.db> work on directly.\n"
+      "\tcolumns\tSplits the database into the spec column <base>.spec and the\n"
+      "\t\tsolution column <base>.sol, which the commands listed for <base>\n"
+      "\t\twork on directly. Those needing a single column read only that.\n"
+      "\tsolvers\tCounts the solved entries and their solutions by solver.\n"
+      "\tsplit\tSplits the unsolved entries into one child for each placement of\n"
+      "\t\tthe third ring, which can be solved by q27solve -r:3.\n"
+      "\tjoin\tSolves the entries all of whose children are solved as solver\n"
+      "\t\t-s from 1..4095 (default: 1). Pass the range of the split to\n"
+      "\t\talso cover its entries without children.\n"
+      "\tcost\tEstimates the search cost of each entry by random probes\n"
+      "\t\t(default: 32) into a file of one big-endian float per entry.\n"
+      "\tschedule Prints the indices of the unsolved entries by descending cost,\n"
+      "\t\twith -c followed by their costs.\n"
+      "\t-r:3\tInsists on pre-placements of three rings as generated by\n"
+      "\t\tcoronal2 -r:3 rather than detecting the layout of the entries.\n"
+      "\t\tRanges address the two outer rings of either layout.\n"
 	      << std::endl;
     exit(1);
   }
 
-  int stats(Database &dbx, int const  argc, char const *const  argv[]) {
-    DBConstRange const  db(dbx.roRange());
-    unsigned     const  total = db.size();
+  // Restricts the range successively by the given range specifications,
+  // searching by the given block index of its database if any.
+  template<typename Range>
+  bool restrict(Range &range, int const  argc, char const *const  argv[], ZoneMap const *const  zones = nullptr) {
+    RangeParser  parser(zones);
+    for(int  i = 0; i < argc; i++) {
+      try {
+	range = parser.parse(argv[i])->resolve(range);
+      }
+      catch(ParseException const &e) {
+	std::cerr << "Exception parsing the range specification:\n"
+		  << "\t'" << argv[i] << "' @" << e.position() << ": " << e.message()
+		  << std::endl;
+	return  false;
+      }
+    }
+    return  true;
+  }
 
-    std::cout << "Scanning " << total << " entries ..." << std::endl;
+  // Restricts a range of the given plain database, searching by its block
+  // index.
+  bool restrict(Database const &dbx, DBConstRange &range, int const  argc, char const *const  argv[]) {
+    if(argc == 0)  return  true;
+    ZoneMap const  zones(dbx.name(), dbx.roRange());
+    return  restrict(range, argc, argv, &zones);
+  }
 
-    // Entry Statistics
-    unsigned  invalid = 0;
-    unsigned  taken   = 0;
-    unsigned  solved  = 0;
-    unsigned  wrapped = 0;
-    unsigned  gapped  = 0;
-    DBEntry const *gapStart = nullptr;
+  // Visits the entries of a plain or archived range in order.
+  template<typename F>
+  void visit(DBConstRange const &db, F &&f) {
+    for(DBEntry const &e : db)  f(e);
+  }
+  template<typename F>
+  void visit(DBArchive::Range const &db, F &&f) {
+    for(size_t  i = db.begin(); i < db.end(); i++)  f(db[i]);
+  }
+  // A single column yields entries with only its own fields populated.
+  template<typename F>
+  void visit(DBColumns::Column const &col, F &&f) {
+    for(DBEntry const  e : col)  f(e);
+  }
+  template<typename F>
+  void visit(DBColumns const &cols, F &&f) {
+    for(size_t  i = 0; i < cols.size(); i++)  f(cols.entry(i));
+  }
 
-    // Solution Count Totals
-    uint64_t  count    = 0L; // fundamental solutions
-    unsigned  mod13    = 0;
-    unsigned  mod15    = 0;
-    uint64_t  countAll = 0L; // all solutions
-    unsigned  mod13All = 0;
-    unsigned  mod15All = 0;
+  // Parses the [-x:<threads>] option of stats and index.
+  bool threadsOption(int const  argc, char const *const  argv[], unsigned &threads) {
+    threads = 0;
+    for(int  i = 0; i < argc; i++) {
+      if(strncmp(argv[i], "-x:", 3) == 0)  threads = (unsigned)strtoul(argv[i]+3, 0, 0);
+      else  return  false;
+    }
+    return  true;
+  }
 
-    for(DBEntry const&  e : db) {
-      // Statistics
-      if(!e.valid())  invalid++;
+  int report(DBStats const &st, uint64_t const  total) {
+    if(st.invalid)  std::cout << "! INVALID: " << st.invalid << '\n';
+    if(st.wrapped)  std::cout << "! WRAPPED: " << st.wrapped << '\n';
+    if(st.gapped)   std::cout << "Entries in unsolved gaps: " << st.gapped << '\n';
+    std::cout << "\nTaken:\t" << std::setw(9) << st.taken
+	      << "\nSolved:\t"  << std::setw(9)<< st.solved << " / " << total
+	      << " (" << std::setprecision(3) << (100.0*st.solved/total) << "%)"
+                 "\nFundamental Solutions: " << std::setw(16) << st.count
+	      << " [" << std::setw(2) << st.mod13 << ':' << std::setw(2) << st.mod15 << "] O"
+	      << ((st.count%13 == st.mod13) && (st.count%15 == st.mod15)? "K" : "VERFLOW")
+              << "\nTotal       Solutions: " << std::setw(16) << st.countAll
+	      << " [" << std::setw(2) << st.mod13All << ':' << std::setw(2) << st.mod15All << "] O"
+	      << ((st.countAll%13 == st.mod13All) && (st.countAll%15 == st.mod15All)? "K" : "VERFLOW")
+	      << std::endl;
 
-      if(!e.solved()) {
-	if(e.taken())  taken++;
+    return  st.invalid||st.wrapped;
 
-	if(gapStart == nullptr)  gapStart = &e;
-      }
-      else {
-	solved++;
-	if(e.wrapped())  wrapped++;
-	uint64_t const  cnt = e.count();
-	unsigned const  m13 = e.mod13();
-	unsigned const  m15 = e.mod15();
-	count += cnt;
-	mod13  = (mod13 + m13)%13;
-	mod15  = (mod15 + m15)%15;
-
-	unsigned const  w = e.sym().weight();
-	countAll += w*cnt;
-	mod13All  = (mod13All + w*m13)%13;
-	mod15All  = (mod15All + w*m15)%15;
-
-	if(gapStart != nullptr) {
-	  gapped  += &e - gapStart;
-	  gapStart = nullptr;
-	}
+  } // report()
+
+  // Scans blocks of up to DBArchive::BLOCK entries of the given layout, as
+  // filled into the given buffer by fill(b, buf), concurrently and merges
+  // them in order.
+  template<typename F>
+  DBStats scan(size_t const  blocks, unsigned const  rings, unsigned  threads, F &&fill) {
+    if(threads == 0)  threads = std::thread::hardware_concurrency();
+    if(threads > blocks)  threads = blocks;
+
+    std::vector<DBStats>  parts(blocks);
+    std::atomic<size_t>   next(0);
+    auto const  work = [&]() {
+      std::unique_ptr<DBEntry[]>  buf(new DBEntry[DBArchive::BLOCK]);
+      for(size_t  b; (b = next++) < parts.size();) {
+	size_t const  n = fill(b, buf.get());
+	parts[b] = DBStats::chunk(buf.get(), buf.get()+n, rings);
       }
+    };
+    std::vector<std::thread>  pool;
+    for(unsigned  t = 1; t < threads; t++)  pool.emplace_back(work);
+    work();
+    for(std::thread &t : pool)  t.join();
+
+    DBStats  st;
+    for(DBStats const &p : parts)  st += p;
+    return  st;
+
+  } // scan()
+
+  int stats(Database &dbx, int const  argc, char const *const  argv[]) {
+    DBConstRange const  db(dbx.roRange());
+    uint64_t     const  total = db.size();
+
+    unsigned  threads;
+    if(!threadsOption(argc, argv, threads)) {
+      usage();
+      return  1;
     }
 
-    if(invalid)  std::cout << "! INVALID: " << invalid << '\n';
-    if(wrapped)  std::cout << "! WRAPPED: " << wrapped << '\n';
-    if(gapped)   std::cout << "Entries in unsolved gaps: " << gapped << '\n';
-    std::cout << "\nTaken:\t" << std::setw(9) << taken
-	      << "\nSolved:\t"  << std::setw(9)<< solved << " / " << total
-	      << " (" << std::setprecision(3) << (100.0*solved/total) << "%)"
-                 "\nFundamental Solutions: " << std::setw(16) << count
-	      << " [" << std::setw(2) << mod13 << ':' << std::setw(2) << mod15 << "] O"
-	      << ((count%13 == mod13) && (count%15 == mod15)? "K" : "VERFLOW")
-              << "\nTotal       Solutions: " << std::setw(16) << countAll
-	      << " [" << std::setw(2) << mod13All << ':' << std::setw(2) << mod15All << "] O"
-	      << ((countAll%13 == mod13All) && (countAll%15 == mod15All)? "K" : "VERFLOW")
-	      << std::endl;
+    // Only rescan the open blocks of an indexed database.
+    DBStats  st;
+    ZoneMap  zones(dbx.name(), db);
+    if(zones.loaded()) {
+      size_t  rescanned;
+      st = zones.refresh(threads, rescanned);
+      std::cout << "Rescanned " << rescanned << " of " << zones.zones() << " blocks." << std::endl;
+      if(!zones.save())  std::cerr << "Cannot update the block index." << std::endl;
+    }
+    else {
+      std::cout << "Scanning " << total << " entries ..." << std::endl;
+      st = DBStats(db, threads);
+    }
+    return  report(st, total);
 
-    return  invalid||wrapped;
+  } // stats()
+
+  int stats(DBArchive &arc, int const  argc, char const *const  argv[]) {
+    unsigned  threads;
+    if(!threadsOption(argc, argv, threads)) {
+      usage();
+      return  1;
+    }
+    std::cout << "Scanning " << arc.size() << " archived entries ..." << std::endl;
+    DBStats const  st = scan(arc.blocks(), arc.rings(), threads, [&](size_t  b, DBEntry *buf) {
+	return  arc.decode(b, buf);
+      });
+    return  report(st, arc.size());
 
   } // stats()
 
-  int freq(Database &dbx, int const  argc, char const *const  argv[]) {
-    DBConstRange const  db(dbx.roRange());
-    std::map<unsigned, unsigned>  hist;
-    for(DBEntry const &e : db) {
-      if(e.solved())  hist[e.time()]++;
+  int stats(DBColumns &cols, int const  argc, char const *const  argv[]) {
+    unsigned  threads;
+    if(!threadsOption(argc, argv, threads)) {
+      usage();
+      return  1;
+    }
+
+    // The summaries need both columns, reassembled block by block.
+    size_t const  n = cols.size();
+    std::cout << "Scanning " << n << " entries in columns ..." << std::endl;
+    DBStats const  st = scan((n + DBArchive::BLOCK-1) / DBArchive::BLOCK, cols.rings(), threads, [&](size_t  b, DBEntry *buf) {
+	size_t const  beg = b * DBArchive::BLOCK;
+	size_t const  end = std::min(beg + DBArchive::BLOCK, n);
+	for(size_t  i = beg; i < end; i++)  *buf++ = cols.entry(i);
+	return  end - beg;
+      });
+    return  report(st, n);
+
+  } // stats()
+
+  int index(Database &dbx, int const  argc, char const *const  argv[]) {
+    unsigned  threads;
+    if(!threadsOption(argc, argv, threads)) {
+      usage();
+      return  1;
+    }
+
+    if(dbx.size() == 0) {
+      std::cerr << "Cannot index an empty database." << std::endl;
+      return  1;
     }
-    unsigned  cumm = 0;
-    unsigned  date = 0;
+    ZoneMap  zones(dbx.name(), dbx.roRange());
+    size_t   rescanned;
+    zones.refresh(threads, rescanned);
+    if(!zones.save()) {
+      std::cerr << "Cannot write the block index." << std::endl;
+      return  1;
+    }
+    std::cout << "Indexed " << rescanned << " of " << zones.zones() << " blocks." << std::endl;
+    return  0;
+
+  } // index()
+
+  template<typename Range>
+  int freq(Range const &db, unsigned const  L) {
+    std::map<unsigned, unsigned>  hist;
+    visit(db, [&](DBEntry const &e) {
+	if(e.solved(L))  hist[e.time(L)]++;
+      });
+    time_t const  now  = ::time(NULL);
+    unsigned      cumm = 0;
+    unsigned      date = 0;
     std::cout << std::setfill('0');
     for(auto const &e : hist) {
       unsigned const  k = e.first;
       unsigned const  v = e.second;
       cumm += v;
       std::cout << k << '\t' << v << '\t' << cumm;
-      if((k>>9) != date) {
+      if(L == 3) {
+	// Stamped by day of month only
+	if((k>>7) != date) {
+	  date = k >> 7;
+	  std::cout << "\tday " << std::setw(2) << date;
+	}
+      }
+      else if((k>>9) != date) {
+	// The stamps only keep the year modulo 4.
+	time_t const  t = DBEntry::stamped(L, k, now);
+	struct tm  ptm;
 	date = k >> 9;
-	std::cout << '\t' << 2015+(date>>9) << '-'
+	std::cout << '\t' << (t == 0? 0 : gmtime_r(&t, &ptm)->tm_year + 1900) << '-'
 		  << std::setw(2) << (0xF&(date>>5)) << '-'
 		  << std::setw(2) << (date & 0x1F);
       }
@@ -146,52 +327,265 @@ namespace {
     return  0;
 
   } // freq()
+  int freq(Database &dbx, int const  argc, char const *const  argv[]) {
+    return  freq(dbx.roRange(), dbx.rings());
+  }
+  int freq(DBArchive &arc, int const  argc, char const *const  argv[]) {
+    return  freq(arc.range(), arc.rings());
+  }
+  int freq(DBColumns &cols, int const  argc, char const *const  argv[]) {
+    // Three rings keep the time stamp in the solution word.
+    if(cols.rings() == 3)  return  freq(cols.sols(), 3);
+    return  freq(cols, cols.rings());
+  }
 
-  int slice(Database &dbx, int const  argc, char const *const  argv[]) {
-    DBConstRange const  db(dbx.roRange());
-    if(argc >= 2) {
-      std::ofstream   out(argv[0]);
-      char const *cmd = argv[1];
-
-      // Slice out taken Entries
-      if(strcmp(cmd, "taken") == 0) {
-	for(DBEntry const &e : db) {
-	  if(e.taken() && !e.solved()) {
-	    out.write((char const*)&e, sizeof(DBEntry));
+  // Solved entries and their fundamental solutions by solver.
+  template<typename Range>
+  int solvers(Range const &db, unsigned const  L) {
+    std::map<unsigned, std::pair<uint64_t, uint64_t>>  hist;
+    visit(db, [&](DBEntry const &e) {
+	if(e.solved(L)) {
+	  auto &h = hist[e.solver()];
+	  h.first++;
+	  h.second += e.count(L);
+	}
+      });
+    std::cout << "Solver\tEntries\tSolutions\n";
+    for(auto const &h : hist) {
+      std::cout << h.first << '\t' << h.second.first << '\t' << h.second.second << '\n';
+    }
+    std::cout << std::flush;
+    return  0;
+
+  } // solvers()
+  int solvers(Database &dbx, int const  argc, char const *const  argv[]) {
+    return  solvers(dbx.roRange(), dbx.rings());
+  }
+  int solvers(DBArchive &arc, int const  argc, char const *const  argv[]) {
+    return  solvers(arc.range(), arc.rings());
+  }
+  int solvers(DBColumns &cols, int const  argc, char const *const  argv[]) {
+    return  solvers(cols.sols(), cols.rings());
+  }
+
+  /**
+   * Sequential writer of a slice of a database file. Runs of at least COPY
+   * bytes are copied in-kernel from the source file by copy_file_range(),
+   * or by sendfile() where the former is not supported across the file
+   * systems involved. Shorter runs are gathered into large writes. I/O
+   * errors raise a std::system_error.
+   */
+  class SliceWriter {
+    static size_t const  COPY   = 64 << 10;
+    static size_t const  BUFFER =  4 << 20;
+
+    enum class Copy { RANGE, SEND, NONE };
+
+    std::string    const     m_name;
+    DBEntry const *const     m_base;  // mapping of the source file
+    int                      m_src;
+    int                      m_dst;
+    Copy                     m_copy;
+    std::unique_ptr<char[]>  m_buf;
+    size_t                   m_fill;
+
+  public:
+    SliceWriter(Database const &src, char const *const  dst)
+      : m_name(dst), m_base(src.roRange().begin()), m_src(-1), m_dst(-1),
+	m_copy(Copy::RANGE), m_buf(new char[BUFFER]), m_fill(0) {
+      m_src = ::open(src.name(), O_RDONLY);
+      if(m_src < 0)  fail("Cannot open source of");
+      m_dst = ::open(dst, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+      if(m_dst < 0)  fail("Cannot open");
+    }
+    ~SliceWriter() {
+      if(m_src >= 0)  ::close(m_src);
+      if(m_dst >= 0)  ::close(m_dst);
+    }
+
+  public:
+    void append(DBEntry const *const  beg, DBEntry const *const  end) {
+      size_t const  len = (end-beg) * sizeof(DBEntry);
+      if(len >= COPY) {
+	flush();
+	transfer((beg-m_base) * sizeof(DBEntry), len);
+      }
+      else {
+	if(m_fill + len > BUFFER)  flush();
+	memcpy(m_buf.get() + m_fill, beg, len);
+	m_fill += len;
+      }
+    }
+    void close() {
+      flush();
+      int const  fd = m_dst;
+      m_dst = -1;
+      if(::close(fd) != 0)  fail("Cannot close");
+    }
+
+  private:
+    void flush() {
+      for(size_t  ofs = 0; ofs < m_fill;) {
+	ssize_t const  k = ::write(m_dst, m_buf.get()+ofs, m_fill-ofs);
+	if(k > 0)  ofs += k;
+	else if((k < 0) && (errno != EINTR))  fail("Cannot write");
+      }
+      m_fill = 0;
+    }
+
+    void transfer(off_t  pos, size_t  len) {
+      while(len > 0) {
+	ssize_t  k = 0;
+	switch(m_copy) {
+	case Copy::RANGE:
+	  k = copy_file_range(m_src, &pos, m_dst, nullptr, len, 0);
+	  if((k < 0) && ((errno == ENOSYS) || (errno == EXDEV) || (errno == EINVAL) || (errno == EOPNOTSUPP))) {
+	    m_copy = Copy::SEND;
+	    continue;
+	  }
+	  break;
+	case Copy::SEND:
+	  k = sendfile(m_dst, m_src, &pos, len);
+	  if((k < 0) && ((errno == ENOSYS) || (errno == EINVAL))) {
+	    m_copy = Copy::NONE;
+	    continue;
 	  }
+	  break;
+	case Copy::NONE:
+	  k = ::write(m_dst, reinterpret_cast<char const*>(m_base) + pos, len);
+	  if(k > 0)  pos += k;
+	  break;
 	}
-	return  0;
+	if(k > 0)  len -= k;
+	else if(k == 0) {  // the source was truncated underneath
+	  errno = EIO;
+	  fail("Cannot copy to");
+	}
+	else if(errno != EINTR)  fail("Cannot copy to");
       }
+    }
+
+    void fail(char const *const  what) const {
+      throw  std::system_error(errno, std::system_category(), std::string(what) + ' ' + m_name);
+    }
+
+  }; // class SliceWriter
 
-      // Slice out stale Entries
-      if((strcmp(cmd, "stale") == 0) && (argc == 3)) {
+  // Unsolved entries taken before the cutoff time.
+  class StalePredicate : public SPredicate {
+    time_t const  m_cutoff;
+
+  public:
+    StalePredicate(time_t const  cutoff) : m_cutoff(cutoff) {}
+    ~StalePredicate() {}
+
+  public:
+    bool  operator()(DBEntry const &e, unsigned  rings) const { return  e.stale(rings, m_cutoff); }
+    Match operator()(ZoneMap::Zone const &z) const { return  Match::NONE; }
+  };
+
+  int slice(Database &dbx, int const  argc, char const *const  argv[]) {
+    if(argc < 1) {
+      usage();
+      return  1;
+    }
+
+    // Restrict the Range and select the Entries to slice out
+    ZoneMap const                zones(dbx.name(), dbx.roRange());
+    DBConstRange                 range(dbx.roRange());
+    std::shared_ptr<SPredicate>  pred;
+    int  i = 1;
+    for(; (i < argc) && !pred; i++) {
+      char const *arg = argv[i];
+      bool  inv = false;
+      while(*arg == '!') {
+	inv = !inv;
+	arg++;
+      }
+      if     (strcmp(arg, "taken")   == 0)  pred = SPredicate::TAKEN;
+      else if(strcmp(arg, "solved")  == 0)  pred = SPredicate::SOLVED;
+      else if(strcmp(arg, "wrapped") == 0)  pred = SPredicate::WRAPPED;
+      else if(strcmp(arg, "valid")   == 0)  pred = SPredicate::VALID;
+      else if(strcmp(arg, "stale")   == 0) {
 	unsigned  timeout;
-	if(sscanf(argv[2], "%u", &timeout) == 1) {
-	  unsigned  cutoff; {
-	    struct tm  ptm;
-	    time_t  rawtime = time(NULL) - 60*timeout;
-	    gmtime_r(&rawtime, &ptm);
-	    cutoff = ((((((((ptm.tm_year-115)&3 << 4) | (ptm.tm_mon+1)) << 5) | ptm.tm_mday) << 5) |  ptm.tm_hour) << 4) | (ptm.tm_min/4);
+	if((++i == argc) || (sscanf(argv[i], "%u", &timeout) != 1)) {
+	  usage();
+	  return  1;
+	}
+	pred = std::make_shared<StalePredicate>(time(NULL) - 60*time_t(timeout));
+      }
+      else {
+	if(!restrict(range, 1, argv+i, &zones))  return  1;
+	continue;
+      }
+      if(inv)  pred = SPredicate::createInverted(pred);
+    }
+    if(i < argc) {
+      usage();
+      return  1;
+    }
+
+    uint64_t  entries = 0;
+    uint64_t  runs    = 0;
+    try {
+      SliceWriter  out(dbx, argv[0]);
+      if(!pred) {
+	out.append(range.begin(), range.end());
+	entries = range.size();
+	runs    = entries != 0;
+      }
+      else {
+	// Coalesce the matching Entries into Runs, taking or skipping
+	// trusted zones of the block index as a whole.
+	DBEntry const *run = nullptr;
+	auto const  cut = [&](DBEntry const *const  end) {
+	  if(run) {
+	    out.append(run, end);
+	    entries += end - run;
+	    runs++;
+	    run = nullptr;
+	  }
+	};
+	for(DBEntry const *ptr = range.begin(); ptr < range.end();) {
+	  size_t  const  z   = zones.zone(ptr);
+	  DBEntry const *end = std::min(range.end(), zones.end(z));
+	  ZoneMap::Zone const *const  zn = zones.trusted(z);
+	  if(zn && (ptr == zones.begin(z)) && (end == zones.end(z))) {
+	    SPredicate::Match const  m = (*pred)(*zn);
+	    if(m != SPredicate::Match::SOME) {
+	      if(m == SPredicate::Match::NONE)  cut(ptr);
+	      else if(!run)  run = ptr;
+	      ptr = end;
+	      continue;
+	    }
 	  }
-	  for(DBEntry const &e : db) {
-	    if(e.taken() && !e.solved() && (e.time() < cutoff)) {
-	      out.write((char const*)&e, sizeof(DBEntry));
+	  for(; ptr < end; ptr++) {
+	    if((*pred)(*ptr, range.rings())) {
+	      if(!run)  run = ptr;
 	    }
+	    else  cut(ptr);
 	  }
-	  return  0;
 	}
+	cut(range.end());
       }
+      out.close();
     }
-    usage();
-    return  1;
-  }
+    catch(std::system_error const &e) {
+      std::cerr << e.what() << std::endl;
+      return  1;
+    }
+    std::cout << entries << " entries sliced in " << runs << " runs." << std::endl;
+    return  0;
+
+  } // slice()
 
   int untake(Database &dbx, int const  argc, char const *const  argv[]) {
     DBRange  db(dbx.rwRange());
+    unsigned const  L = db.rings();
     uint64_t  cnt = 0L;
     for(DBEntry &e : db) {
-      if(e.taken() && !e.solved()) {
-	e.untake();
+      if(e.taken(L) && !e.solved(L)) {
+	e.untake(L);
 	cnt++;
       }
     }
@@ -207,9 +601,13 @@ namespace {
     }
     DBRange  db(dbx.rwRange());
     uint64_t  cnt = 0L;
+
+    // Withdrawn solutions invalidate the block summaries.
+    ZoneMap(dbx.name(), dbx.roRange()).discard();
+    unsigned const  L = db.rings();
     for(DBEntry &e : db) {
-      if(e.taken() || e.solved()) {
-        e.unsolve();
+      if(e.taken(L) || e.solved(L)) {
+        e.unsolve(L);
         cnt++;
       }
     }
@@ -218,12 +616,68 @@ namespace {
 
   }  // unsolve()
 
+  /**
+   * Returns the first entry of [beg, end) whose spec(L) exceeds key. The
+   * search gallops forward from beg so that a sweep of ascending keys only
+   * touches the neighborhood of its matches.
+   */
+  DBEntry *upperBound(unsigned const  L, DBEntry *beg, DBEntry *const  end, uint64_t const  key) {
+    if((beg == end) || (beg->spec(L) > key))  return  beg;
+
+    // Invariant: beg->spec(L) <= key < hi->spec(L) or hi == end
+    size_t  step = 1;
+    DBEntry *hi;
+    while(true) {
+      if(size_t(end-beg) <= step) {
+	hi = end;
+	break;
+      }
+      hi = beg + step;
+      if(hi->spec(L) > key)  break;
+      beg   = hi;
+      step *= 2;
+    }
+    while(hi-beg > 1) {
+      DBEntry *const  mid = beg + (hi-beg)/2;
+      if(mid->spec(L) > key)  hi  = mid;
+      else                   beg = mid;
+    }
+    return  hi;
+
+  } // upperBound()
+
   int merge(Database &dbx, int const  argc, char const *const  argv[]) {
     DBRange  db(dbx.rwRange());
-    if(argc == 2) {
-      Database     const  mergex(argv[0], boost::iostreams::mapped_file::readonly);
-      DBConstRange const  merge (mergex.roRange());
-      std::ofstream       dups  (argv[1], std::ofstream::out|std::ofstream::app);
+    unsigned const  L = db.rings();
+    if(argc >= 2) {
+      // Solved Entries of each Contribution in Spec Order
+      struct Source {
+	DBEntry const *ptr;
+	DBEntry const *end;
+	int            idx;
+	unsigned       L;
+
+	bool next() {
+	  while((ptr != end) && !ptr->solved(L))  ptr++;
+	  return  ptr != end;
+	}
+	bool operator>(Source const &o) const {
+	  uint64_t const  a = ptr->spec(L);
+	  uint64_t const  b = o.ptr->spec(L);
+	  return (a > b) || ((a == b) && (idx > o.idx));
+	}
+      };
+      std::vector<std::unique_ptr<Database>>  contribs;
+      std::vector<Source>                     heap;
+      for(int  i = 0; i < argc-1; i++) {
+	contribs.emplace_back(new Database(argv[i], boost::iostreams::mapped_file::readonly, L));
+	DBConstRange const  merge(contribs.back()->roRange());
+	Source  src { merge.begin(), merge.end(), i, L };
+	if(src.next())  heap.push_back(src);
+      }
+      std::greater<Source> const  later;
+      std::make_heap(heap.begin(), heap.end(), later);
+      std::ofstream  dups(argv[argc-1], std::ofstream::out|std::ofstream::app);
 
       unsigned  merged    = 0;
       unsigned  identical = 0;
@@ -231,30 +685,46 @@ namespace {
       unsigned  conflicts = 0;
       unsigned  notfound  = 0;
 
-      for(DBEntry const &e : merge) {
-	if(e.solved()) {
-	  DBEntry *const  target = db.glb(e.spec());
-	  if((target == nullptr) || (target->spec() != e.spec()))  notfound++;
-	  else { // We have the exact corresponding entry
+      // Merge-join all contributions with the target in a single sweep.
+      // Ties are taken in the order of the contributions as if they were
+      // merged one after the other.
+      DBEntry  *hi   = db.begin();  // first target entry beyond the last key
+      uint64_t  last = 0;
+      while(!heap.empty()) {
+	std::pop_heap(heap.begin(), heap.end(), later);
+	Source        &src = heap.back();
+	DBEntry const &e   = *src.ptr++;
 
-	    if(!target->solved()) {             // New contribution: merge
-	      *target = e;
-	      merged++;
-	    }
-	    else if(*target == e) {             // Identical entries
-	      identical++;
-	    }
-	    else {                              // Secondary solution: check
-	      if(target->count() == e.count())  confirmed++;
-	      else {
-		std::cerr << "Conflict:\n\t" << *target << "\n\t" << e << std::endl;
-		conflicts++;
-	      }
-	      dups.write((char const*)&e, sizeof(DBEntry));
-	    }
+	// Unsorted contributions restart the search from the front.
+	uint64_t const  key = e.spec(L) | UINT64_C(0x1F); // ignore symmetry and CRC
+	if(key < last)  hi = db.begin();
+	last = key;
+	hi   = upperBound(L, hi, db.end(), key);
 
+	DBEntry *const  target = hi == db.begin()? nullptr : hi-1;
+	if((target == nullptr) || (target->spec(L) != e.spec(L)))  notfound++;
+	else { // We have the exact corresponding entry
+
+	  if(!target->solved(L)) {             // New contribution: merge
+	    *target = e;
+	    merged++;
+	  }
+	  else if(*target == e) {             // Identical entries
+	    identical++;
 	  }
+	  else {                              // Secondary solution: check
+	    if(target->count(L) == e.count(L))  confirmed++;
+	    else {
+	      std::cerr << "Conflict:\n\t" << target->format(L) << "\n\t" << e.format(L) << std::endl;
+	      conflicts++;
+	    }
+	    dups.write((char const*)&e, sizeof(DBEntry));
+	  }
+
 	}
+
+	if(src.next())  std::push_heap(heap.begin(), heap.end(), later);
+	else            heap.pop_back();
       }
       if(notfound||identical) {
 	std::cout << "Ignored Entries:\n";
@@ -283,27 +753,14 @@ namespace {
       DBConstRange         range(dbx.roRange());
       DBEntry const *const beg = range.begin();
 
-      { // Parse range restrictions
-	RangeParser  parser;
-	for(int  i = 0; i < argc; i++) {
-	  try {
-	    range = parser.parse(argv[i])->resolve(range);
-	  }
-	  catch(ParseException const &e) {
-	    std::cerr << "Exception parsing the range specification:\n"
-		      << "\t'" << argv[0] << "' @" << e.position() << ": " << e.message()
-		      << std::endl;
-	    return  1;
-	  }
-	}
-      }
+      if(!restrict(dbx, range, argc, argv))  return  1;
       { // Output Count
 	unsigned const  n = range.size();
 	std::cout << n << " Entr" << (n==1? "y" : "ies") << std::endl;
       }
       // Output Entries
       for(DBEntry const &e : range) {
-	std::cout << '@' << std::setw(10) << (&e-beg) << ": " << e << std::endl;
+	std::cout << '@' << std::setw(10) << (&e-beg) << ": " << e.format(range.rings()) << std::endl;
       }
       return  0;
     }
@@ -311,24 +768,752 @@ namespace {
     return  1;
 
   } // print()
+  int print(DBArchive &arc, int const  argc, char const *const  argv[]) {
+    if(argc > 0) {
+      DBArchive::Range  range(arc.range());
 
-  int queens(Database &dbx, int const  argc, char const *const  argv[]) {
-    unsigned  len = 0;
-    unsigned  prv = 0;
-    for(DBEntry const &e : dbx.roRange()) {
-      unsigned const  q = e.queens();
-      if(q == prv)  len++;
-      else {
-	if(len > 1)  std::cout << ' ' << len;
-	std::cout << std::endl << q;
-	len = 1;
-	prv = q;
+      if(!restrict(range, argc, argv))  return  1;
+      { // Output Count
+	unsigned const  n = range.size();
+	std::cout << n << " Entr" << (n==1? "y" : "ies") << std::endl;
       }
+      // Output Entries
+      for(size_t  i = range.begin(); i < range.end(); i++) {
+	std::cout << '@' << std::setw(10) << i << ": " << range[i].format(arc.rings()) << std::endl;
+      }
+      return  0;
     }
+    usage();
+    return  1;
+
+  } // print()
+
+  /**
+   * Writes the blocking vectors of the entries of a range to a binary file
+   * so that solvers can be fed without re-deriving the board geometry:
+   *
+   *  vhdl - One record of four big-endian 64-bit words per entry holding
+   *         the BH_l, BV_l, BU_l and BD_l inputs of queens_slice (L=2) as
+   *         connected from a descending host word: right-aligned with
+   *         vector element 0 in the most significant bit.
+   *  soa  - The kernel view (Blocking) as the four consecutive host-order
+   *         arrays bv[n], bh[n], bu[n] and bd[n].
+   */
+  int expand(Database &dbx, int const  argc, char const *const  argv[]) {
+    if(argc < 2)  usage();
+    char const *const  file = argv[0];
+    bool        const  soa  = strcmp(argv[1], "soa") == 0;
+    if(!soa && (strcmp(argv[1], "vhdl") != 0))  usage();
+
+    unsigned  N = 27;
+    int       i = 2;
+    if((i < argc) && (strncmp(argv[i], "-n:", 3) == 0)) {
+      N = (unsigned)strtoul(argv[i++]+3, 0, 0);
+      if((N < 5) || (32 < N)) {
+	std::cerr << "Board dimension must be from 5..32." << std::endl;
+	return  1;
+      }
+    }
+    DBConstRange  range(dbx.roRange());
+    if(!restrict(dbx, range, argc-i, argv+i))  return  1;
+
+    size_t const  n = range.size();
+    std::ofstream  out(file, std::ofstream::out|std::ofstream::binary|std::ofstream::trunc);
+    if(!out) {
+      std::cerr << "Cannot open output file " << file << std::endl;
+      return  1;
+    }
+
+    // Slice Window (L=2) of a Board Vector as a right-aligned Word with
+    // the Window Start in the most significant Bit
+    unsigned const  L  = 2;
+    unsigned const  WL = N-2*L;
+    unsigned const  WD = 2*N-4*L-1;
+    auto const  window = [](uint64_t  v, unsigned  lo, unsigned  width) {
+      v >>= lo;  // reverse the bit order
+      v = ((v >>  1) & UINT64_C(0x5555555555555555)) | ((v & UINT64_C(0x5555555555555555)) <<  1);
+      v = ((v >>  2) & UINT64_C(0x3333333333333333)) | ((v & UINT64_C(0x3333333333333333)) <<  2);
+      v = ((v >>  4) & UINT64_C(0x0F0F0F0F0F0F0F0F)) | ((v & UINT64_C(0x0F0F0F0F0F0F0F0F)) <<  4);
+      v = __builtin_bswap64(v);
+      return  v >> (64-width);
+    };
+
+    size_t const  CHUNK = 1 << 16;
+    std::unique_ptr<uint64_t[]>  buf(new uint64_t[4*CHUNK]);
+    auto const  start = std::chrono::steady_clock::now();
+
+    DBEntry const *e = range.begin();
+    for(size_t  ofs = 0; ofs < n; ofs += CHUNK) {
+      size_t const  m = std::min(CHUNK, n-ofs);
+      for(size_t  j = 0; j < m; j++, e++) {
+	uint64_t  bv, bh, bu, bd;
+	if(!e->expand(range.rings(), N, bv, bh, bu, bd)) {
+	  std::cerr << "Entry @" << (e-dbx.roRange().begin()) << " is no valid pre-placement for N=" << N << ":\n\t"
+		    << e->format(range.rings()) << std::endl;
+	  return  1;
+	}
+	if(soa) {
+	  Blocking const  b = Blocking::fromBoard(N, bv, bh, bu, bd);
+	  buf[        j] = b.bv;
+	  buf[  CHUNK+j] = b.bh;
+	  buf[2*CHUNK+j] = b.bu;
+	  buf[3*CHUNK+j] = b.bd;
+	}
+	else {
+	  uint64be_t *const  rec = reinterpret_cast<uint64be_t*>(&buf[4*j]);
+	  rec[0] = window(bh,   L, WL);
+	  rec[1] = window(bv,   L, WL);
+	  rec[2] = window(bu, 2*L, WD);
+	  rec[3] = window(bd, 2*L, WD);
+	}
+      }
+      if(soa) {
+	for(unsigned  k = 0; k < 4; k++) {
+	  out.seekp((k*n + ofs)*sizeof(uint64_t));
+	  out.write((char const*)&buf[k*CHUNK], m*sizeof(uint64_t));
+	}
+      }
+      else  out.write((char const*)buf.get(), 4*m*sizeof(uint64_t));
+    }
+    out.close();
+    if(!out) {
+      std::cerr << "Writing " << file << " failed." << std::endl;
+      return  1;
+    }
+
+    double const  elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Expanded " << n << " entries for N=" << N << " in "
+	      << std::fixed << std::setprecision(3) << elapsed << " s ("
+	      << std::setprecision(1) << (n/elapsed/1e6) << "M entries/s, "
+	      << (4*sizeof(uint64_t)*n/elapsed/(1<<20)) << " MiB/s)" << std::endl;
+    return  0;
+
+  } // expand()
+
+  /**
+   * Partial placement of the rings of an NxN board as the positions of its
+   * queens and its blocking vectors.
+   */
+  class Rings {
+    unsigned  N;
+    unsigned  n;
+    unsigned  x[12];
+    unsigned  y[12];
+    uint64_t  bv, bh, bu, bd;
+
+  public:
+    Rings(unsigned const  _N) : N(_N), n(0), bv(0), bh(0), bu(0), bd(0) {}
+    ~Rings() {}
+
+  public:
+    bool free(unsigned const  qx, unsigned const  qy) const {
+      return !(((bv >> qx) | (bh >> qy) | (bu >> (N-1-qx+qy)) | (bd >> (qx+qy))) & 1);
+    }
+    // Adds a queen unless it is already placed and returns false if it
+    // conflicts with the placed ones.
+    bool add(unsigned const  qx, unsigned const  qy) {
+      if((qx >= N) || (qy >= N))  return  false;
+      if(rowOf(qx) == qy)  return  true;
+      if(!free(qx, qy))    return  false;
+      x[n] = qx;
+      y[n] = qy;
+      n++;
+      bv |= UINT64_C(1) << qx;
+      bh |= UINT64_C(1) << qy;
+      bu |= UINT64_C(1) << (N-1-qx+qy);
+      bd |= UINT64_C(1) << (qx+qy);
+      return  true;
+    }
+    // Row of the queen in column qx, column of the queen in row qy, or N
+    unsigned rowOf(unsigned const  qx) const {
+      for(unsigned  i = 0; i < n; i++)  if(x[i] == qx)  return  y[i];
+      return  N;
+    }
+    unsigned colOf(unsigned const  qy) const {
+      for(unsigned  i = 0; i < n; i++)  if(y[i] == qy)  return  x[i];
+      return  N;
+    }
+
+   /**
+    * Invokes f(r, val) for all placements r extending this one by side
+    * (0 - west, 1 - north, 2 - east, 3 - south) of the third ring with val
+    * as its coronal position in ascending order. A side already occupied
+    * by a queen of the outer rings or of an adjacent side is passed on as
+    * is.
+    */
+    template<typename F>
+    void third(unsigned const  side, F &&f) const {
+      unsigned const  I = N-3;
+      unsigned  q;
+      switch(side) {
+      case 0:
+	if((q = rowOf(2)) < N)  f(*this, q);
+	else {
+	  for(unsigned  v = 2; v <= I; v++)  extend(2, v, v, f);
+	}
+	break;
+      case 1:
+	if((q = colOf(I)) < N)  f(*this, q);
+	else {
+	  for(unsigned  v = 2; v <= I; v++)  extend(v, I, v, f);
+	}
+	break;
+      case 2:
+	if((q = rowOf(I)) < N)  f(*this, N-1-q);
+	else {
+	  for(unsigned  v = 2; v <= I; v++)  extend(I, N-1-v, v, f);
+	}
+	break;
+      case 3:
+	if((q = colOf(2)) < N)  f(*this, N-1-q);
+	else {
+	  for(unsigned  v = 2; v <= I; v++)  extend(N-1-v, 2, v, f);
+	}
+	break;
+      }
+    }
+
+  private:
+    template<typename F>
+    void extend(unsigned const  qx, unsigned const  qy, unsigned const  val, F &f) const {
+      if(free(qx, qy)) {
+	Rings  r(*this);
+	r.add(qx, qy);
+	f(r, val);
+      }
+    }
+  }; // class Rings
+
+  /**
+   * Enumerates all placements of the third ring completing the pre-placement
+   * pre of the two outer rings (Board::coronal(pre, 2)) on an NxN board in
+   * ascending order. Each is passed to f in the format of Board::coronal(pre, 3).
+   * Returns false if the pre-placement is invalid on such a board.
+   */
+  template<typename F>
+  bool refine(unsigned const  N, int8_t const *const  pre, F &&f) {
+    Rings  r0(N);
+    for(unsigned  k = 0; k < 2; k++) {
+      if(!r0.add(k,              pre[k])     ||
+	 !r0.add(pre[2+k],       N-1-k)      ||
+	 !r0.add(N-1-k,          N-1-pre[4+k]) ||
+	 !r0.add(N-1-pre[6+k],   k))  return  false;
+    }
+
+    int8_t  pre3[12] = {
+      pre[0], pre[1], 0, pre[2], pre[3], 0, pre[4], pre[5], 0, pre[6], pre[7], 0
+    };
+    r0.third(0, [&](Rings const &r1, unsigned const  wc) {
+      pre3[2] = wc;
+      r1.third(1, [&](Rings const &r2, unsigned const  nc) {
+	pre3[5] = nc;
+	r2.third(2, [&](Rings const &r3, unsigned const  ec) {
+	  pre3[8] = ec;
+	  r3.third(3, [&](Rings const&, unsigned const  sc) {
+	    pre3[11] = sc;
+	    f(pre3);
+	  });
+	});
+      });
+    });
+    return  true;
+
+  } // refine()
+
+  /**
+   * Splits the entries of a range into child work units, one for each
+   * placement of the third ring, written as a database of three rings.
+   * The children keep the outer rings and the symmetry of their parent so
+   * that the counts of all children of a parent add up to its count, and
+   * the parent is found again by the leading outer rings of their specs.
+   */
+  int split(Database &dbx, int const  argc, char const *const  argv[]) {
+    if(argc < 1)  usage();
+    if(dbx.rings() != 2) {
+      std::cerr << "Only databases of two rings can be split." << std::endl;
+      return  1;
+    }
+    char const *const  file = argv[0];
+
+    unsigned  N = 27;
+    int       i = 1;
+    if((i < argc) && (strncmp(argv[i], "-n:", 3) == 0)) {
+      N = (unsigned)strtoul(argv[i++]+3, 0, 0);
+      if((N < 7) || (32 < N)) {
+	std::cerr << "Board dimension must be from 7..32." << std::endl;
+	return  1;
+      }
+    }
+    DBConstRange  range(dbx.roRange());
+    if(!restrict(dbx, range, argc-i, argv+i))  return  1;
+
+    // Unsolved Parents in the Layout of two Rings
+    struct Parent {
+      int8_t    pre[8];
+      unsigned  sym;
+    };
+    std::vector<Parent>  parents;
+    unsigned  skipped = 0;
+    for(DBEntry const &e : range) {
+      if(e.solved(2)) {
+	skipped++;
+	continue;
+      }
+      Parent  p;
+      e.coronal(2, p.pre);
+      p.sym = e.sym(2);
+      parents.push_back(p);
+    }
+
+    // Children in the Layout of three Rings
+    uint64_t  children = 0;
+    uint64_t  most     = 0;
+    try {
+      DBWriter  out(file);
+      {
+	DBWriter::Stream  s(out);
+	for(Parent const &p : parents) {
+	  uint64_t  cnt = 0;
+	  if(!refine(N, p.pre, [&](int8_t const *const  pre3) {
+		s.write(DBEntry(3, pre3, p.sym));
+		cnt++;
+	      })) {
+	    std::cerr << "Entry " << DBEntry(2, p.pre, p.sym).format(2) << " is no valid pre-placement for N=" << N << '.' << std::endl;
+	    return  1;
+	  }
+	  children += cnt;
+	  if(cnt > most)  most = cnt;
+	}
+	s.close();
+      }
+      out.close();
+    }
+    catch(std::system_error const &e) {
+      std::cerr << e.what() << std::endl;
+      return  1;
+    }
+
+    std::cout << "Split " << parents.size() << " entries into " << children << " children";
+    if(!parents.empty()) {
+      std::cout << " (" << std::fixed << std::setprecision(1) << (double)children/parents.size()
+		<< " on average, at most " << most << ')';
+    }
+    std::cout << '.' << std::endl;
+    if(skipped)  std::cout << "Skipped " << skipped << " solved entries." << std::endl;
+    return  0;
+
+  } // split()
+
+  /**
+   * Folds the solved children of a split database back into their parents.
+   * A parent is solved once all of its children are: its count and
+   * residues are the sums of theirs. Counts of children wrapped beyond
+   * their 32 bits are restored from their residues.
+   */
+  int join(Database &dbx, int const  argc, char const *const  argv[]) {
+    if(argc < 1)  usage();
+    if(dbx.rings() != 2) {
+      std::cerr << "Only databases of two rings can be joined into." << std::endl;
+      return  1;
+    }
+    unsigned  N      = 27;
+    unsigned  solver = 1;
+    int       i = 1;
+    for(; i < argc; i++) {
+      if(strncmp(argv[i], "-n:", 3) == 0)  N = (unsigned)strtoul(argv[i]+3, 0, 0);
+      else if(strncmp(argv[i], "-s:", 3) == 0)  solver = (unsigned)strtoul(argv[i]+3, 0, 0);
+      else  break;
+    }
+    if((N < 7) || (32 < N) || (solver == 0) || (solver > 4095)) {
+      std::cerr << "Board dimension must be from 7..32, the solver ID from 1..4095." << std::endl;
+      return  1;
+    }
+
+    // Children grouped by their Parents
+    struct Group {
+      uint64_t  prefix;  // outer rings
+      uint64_t  total;
+      uint64_t  solved;
+      uint64_t  count;
+      unsigned  mod13;
+      unsigned  mod15;
+    };
+    std::vector<Group>  groups;
+    try {
+      // The children are checked against the Layout of three Rings.
+      Database const  childx(argv[0], boost::iostreams::mapped_file::readonly, 3);
+      for(DBEntry const &e : childx.roRange()) {
+	uint64_t const  prefix = e.spec(3) >> 25;
+	if(groups.empty() || (groups.back().prefix != prefix)) {
+	  groups.push_back(Group{ prefix, 0, 0, 0, 0, 0 });
+	}
+	Group &g = groups.back();
+	g.total++;
+	if(e.solved(3)) {
+	  unsigned const  m13 = e.mod13();
+	  unsigned const  m15 = e.mod15();
+	  uint64_t  cnt = e.count(3);
+	  while((cnt%13 != m13) || (cnt%15 != m15))  cnt += UINT64_C(1) << 32;
+	  g.solved++;
+	  g.count += cnt;
+	  g.mod13  = (g.mod13 + m13)%13;
+	  g.mod15  = (g.mod15 + m15)%15;
+	}
+      }
+    }
+    catch(std::runtime_error const &e) {
+      std::cerr << e.what() << std::endl;
+      return  1;
+    }
+
+    // Walk the parents of the split range, by default those spanned by the
+    // children, along with their groups. Parents without any placement of
+    // the third ring have no children and are solved right away.
+    DBRange       db(dbx.rwRange());
+    DBConstRange  range(db);
+    if(!restrict(dbx, range, argc-i, argv+i))  return  1;
+    bool const  spanned = i == argc;
+    unsigned  joined    = 0;
+    unsigned  empty     = 0;
+    unsigned  pending   = 0;
+    unsigned  confirmed = 0;
+    unsigned  conflicts = 0;
+    unsigned  notfound  = 0;
+    auto  g = groups.cbegin();
+    DBEntry *const  beg = spanned? (groups.empty()? db.end() : db.lub(g->prefix << 5))
+                                 : db.begin() + (range.begin() - db.begin());
+    DBEntry *const  end = spanned? db.end() : db.begin() + (range.end() - db.begin());
+    for(DBEntry *p = beg; p < end; p++) {
+      uint64_t const  prefix = p->spec(2) >> 5;
+      while((g != groups.cend()) && (g->prefix < prefix)) {
+	notfound++;
+	g++;
+      }
+      if(spanned && (g == groups.cend()))  break;
+
+      int8_t    pre[8];
+      uint64_t  expected = 0;
+      p->coronal(2, pre);
+      refine(N, pre, [&expected](int8_t const*) { expected++; });
+      if((g == groups.cend()) || (g->prefix != prefix)) {
+	if((expected == 0) && !p->solved(2)) {
+	  p->solve(2, solver, 0, 0, 0);
+	  empty++;
+	}
+	continue;
+      }
+      Group const &grp = *g++;
+
+      // All Children must be present and solved.
+      if((grp.total != expected) || (grp.solved < grp.total)) {
+	pending++;
+	continue;
+      }
+      if(p->solved(2)) {
+	if(p->count(2) == grp.count)  confirmed++;
+	else {
+	  std::cerr << "Conflict:\n\t" << p->format(2) << "\n\tchildren: " << grp.count << std::endl;
+	  conflicts++;
+	}
+	continue;
+      }
+      p->solve(2, solver, grp.count, grp.mod15, grp.mod13);
+      joined++;
+    }
+    notfound += groups.cend() - g;
+    if(!dbx.flush()) {
+      std::cerr << "Flushing the database failed." << std::endl;
+      return  1;
+    }
+
+    std::cout << "Joined " << joined << " of " << groups.size() << " parents.\n";
+    if(empty)      std::cout << '\t' << std::setw(9) << empty     << " without children solved\n";
+    if(pending)    std::cout << '\t' << std::setw(9) << pending   << " with unsolved or missing children\n";
+    if(confirmed)  std::cout << '\t' << std::setw(9) << confirmed << " already solved, confirmed\n";
+    if(conflicts)  std::cout << '\t' << std::setw(9) << conflicts << " already solved, CONFLICTS\n";
+    if(notfound)   std::cout << '\t' << std::setw(9) << notfound  << " NOT found\n";
+    std::cout << std::flush;
+    return  conflicts > 0;
+
+  } // join()
+
+  /**
+   * Estimates the search cost of every entry by random probes of the tree
+   * of its completions and writes it into a sidecar file aligned with the
+   * database: one IEEE single (big endian) estimating the visited nodes per
+   * entry, zero for invalid ones. The probes of each entry are seeded by
+   * its index so that the file does not depend on the number of threads.
+   */
+  int cost(Database &dbx, int const  argc, char const *const  argv[]) {
+    if(argc < 1)  usage();
+    if(dbx.rings() != 2) {
+      std::cerr << "Costs are only estimated for databases of two rings." << std::endl;
+      return  1;
+    }
+    char const *const  file = argv[0];
+
+    unsigned  N       = 27;
+    unsigned  probes  = 32;
+    unsigned  threads = std::thread::hardware_concurrency();
+    for(int  i = 1; i < argc; i++) {
+      if(strncmp(argv[i], "-n:", 3) == 0)  N       = (unsigned)strtoul(argv[i]+3, 0, 0);
+      else if(strncmp(argv[i], "-p:", 3) == 0)  probes  = (unsigned)strtoul(argv[i]+3, 0, 0);
+      else if(strncmp(argv[i], "-x:", 3) == 0)  threads = (unsigned)strtoul(argv[i]+3, 0, 0);
+      else  usage();
+    }
+    if((N < 5) || (32 < N) || (probes == 0)) {
+      std::cerr << "Board dimension must be from 5..32, at least one probe." << std::endl;
+      return  1;
+    }
+    if(threads == 0)  threads = 1;
+
+    DBConstRange const  db(dbx.roRange());
+    size_t const  n = db.size();
+    std::ofstream  out(file, std::ofstream::out|std::ofstream::binary|std::ofstream::trunc);
+    if(!out) {
+      std::cerr << "Cannot open output file " << file << std::endl;
+      return  1;
+    }
+
+    size_t const  CHUNK = 1 << 16;
+    std::unique_ptr<uint32be_t[]>  buf(new uint32be_t[CHUNK]);
+    std::atomic<size_t>  failed(n);
+    auto const  start = std::chrono::steady_clock::now();
+    auto        last  = start;
+    double      total = 0.0;
+
+    for(size_t  ofs = 0; ofs < n; ofs += CHUNK) {
+      size_t const  m = std::min(CHUNK, n-ofs);
+      auto const  work = [&](unsigned const  t) {
+	for(size_t  j = t; j < m; j += threads) {
+	  DBEntry const &e = db.begin()[ofs+j];
+	  float  c = 0.0f;
+	  if(e.valid(2)) {
+	    uint64_t  bv, bh, bu, bd;
+	    if(!e.expand(2, N, bv, bh, bu, bd)) {
+	      failed = ofs+j;
+	      return;
+	    }
+	    uint64_t  seed = (ofs+j+1) * UINT64_C(0x9E3779B97F4A7C15);
+	    c = Kernel::estimate(Blocking::fromBoard(N, bv, bh, bu, bd), probes, seed);
+	  }
+	  uint32_t  bits;
+	  memcpy(&bits, &c, sizeof(bits));
+	  buf[j] = bits;
+	}
+      };
+      std::vector<std::thread>  workers;
+      for(unsigned  t = 1; t < threads; t++)  workers.emplace_back(work, t);
+      work(0);
+      for(std::thread &w : workers)  w.join();
+
+      if(failed < n) {
+	std::cerr << "\nEntry @" << failed << " is no valid pre-placement for N=" << N << ":\n\t"
+		  << db.begin()[failed].format(2) << std::endl;
+	return  1;
+      }
+      for(size_t  j = 0; j < m; j++) {
+	uint32_t const  bits = buf[j];
+	float  c;
+	memcpy(&c, &bits, sizeof(c));
+	total += c;
+      }
+      out.write((char const*)buf.get(), m*sizeof(uint32be_t));
+
+      auto const  now = std::chrono::steady_clock::now();
+      if(now - last >= std::chrono::seconds(1)) {
+	std::cout << "\rProgress: " << (ofs+m) << '/' << n << std::flush;
+	last = now;
+      }
+    }
+    out.close();
+    if(!out) {
+      std::cerr << "\nWriting " << file << " failed." << std::endl;
+      return  1;
+    }
+
+    double const  elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "\rEstimated " << n << " entries for N=" << N << " with " << probes << " probes each in "
+	      << std::fixed << std::setprecision(3) << elapsed << " s.\n"
+	      << "Estimated total: " << std::scientific << std::setprecision(3) << total << " nodes" << std::endl;
+    return  0;
+
+  } // cost()
+
+  /**
+   * Prints the indices of the unsolved entries of the range by descending
+   * estimated cost as read from a sidecar file written by cost so that
+   * the heaviest work can be handed out first.
+   */
+  int schedule(Database &dbx, int const  argc, char const *const  argv[]) {
+    if(argc < 1)  usage();
+    int   i    = 1;
+    bool  show = false;
+    if((i < argc) && (strcmp(argv[i], "-c") == 0)) {
+      show = true;
+      i++;
+    }
+    DBConstRange const  db(dbx.roRange());
+    DBConstRange  range(db);
+    if(!restrict(dbx, range, argc-i, argv+i))  return  1;
+
+    boost::iostreams::mapped_file_source  costs(argv[0]);
+    if(costs.size() != db.size()*sizeof(uint32be_t)) {
+      std::cerr << "Cost file " << argv[0] << " does not match the database." << std::endl;
+      return  1;
+    }
+    uint32be_t const *const  cost = reinterpret_cast<uint32be_t const*>(costs.data());
+
+    // Non-negative IEEE singles order like their bit patterns: sort keys
+    // of the cost above the complemented index for ties in file order.
+    std::vector<uint64_t>  order;
+    double  total = 0.0;
+    for(DBEntry const &e : range) {
+      if(e.solved(db.rings()) || !e.valid(db.rings()))  continue;
+      uint64_t const  idx  = &e - db.begin();
+      uint32_t const  bits = cost[idx];
+      order.push_back((uint64_t(bits) << 32) | uint32_t(~idx));
+    }
+    std::sort(order.begin(), order.end(), [](uint64_t  a, uint64_t  b) { return  a > b; });
+
+    auto const  value = [](uint64_t const  key) {
+      uint32_t const  bits = key >> 32;
+      float  c;
+      memcpy(&c, &bits, sizeof(c));
+      return  c;
+    };
+    for(uint64_t const  key : order)  total += value(key);
+
+    double  head = 0.0;
+    size_t const  top = (order.size()+99)/100;
+    for(size_t  j = 0; j < order.size(); j++) {
+      uint64_t const  key = order[j];
+      if(j < top)  head += value(key);
+      std::cout << uint32_t(~key);
+      if(show)  std::cout << '\t' << value(key);
+      std::cout << '\n';
+    }
+    std::cout << std::flush;
+    std::cerr << "Scheduled " << order.size() << " unsolved entries";
+    if(total > 0.0) {
+      std::cerr << ", the heaviest 1% carrying " << std::fixed << std::setprecision(1)
+		<< (100.0*head/total) << "% of the estimated cost";
+    }
+    std::cerr << '.' << std::endl;
+    return  0;
+
+  } // schedule()
+
+  template<typename Range>
+  int queens(Range const &db, unsigned const  L) {
+    unsigned  len = 0;
+    unsigned  prv = 0;
+    visit(db, [&](DBEntry const &e) {
+	unsigned const  q = e.queens(L);
+	if(q == prv)  len++;
+	else {
+	  if(len > 1)  std::cout << ' ' << len;
+	  std::cout << std::endl << q;
+	  len = 1;
+	  prv = q;
+	}
+      });
     if(len > 1)  std::cout << ' ' << len;
     std::cout << std::endl;
     return  0;
   } // queens()
+  int queens(Database &dbx, int const  argc, char const *const  argv[]) {
+    return  queens(dbx.roRange(), dbx.rings());
+  }
+  int queens(DBArchive &arc, int const  argc, char const *const  argv[]) {
+    return  queens(arc.range(), arc.rings());
+  }
+  int queens(DBColumns &cols, int const  argc, char const *const  argv[]) {
+    return  queens(cols.specs(), cols.rings());
+  }
+
+  //- Archives ---------------------------------------------------------------
+  int compress(Database &dbx, int const  argc, char const *const  argv[]) {
+    if(argc != 1) {
+      usage();
+      return  1;
+    }
+    try {
+      DBArchive::compress(dbx.roRange(), argv[0]);
+    }
+    catch(std::system_error const &e) {
+      std::cerr << e.what() << std::endl;
+      return  1;
+    }
+    return  0;
+  } // compress()
+
+  int decompress(DBArchive &arc, int const  argc, char const *const  argv[]) {
+    if(argc != 1) {
+      usage();
+      return  1;
+    }
+    try {
+      DBWriter  out(argv[0]);
+      {
+	DBWriter::Stream  s(out);
+	std::unique_ptr<DBEntry[]>  buf(new DBEntry[DBArchive::BLOCK]);
+	for(size_t  b = 0; b < arc.blocks(); b++) {
+	  size_t const  n = arc.decode(b, buf.get());
+	  s.write(buf.get(), buf.get()+n);
+	}
+	s.close();
+      }
+      out.close();
+    }
+    catch(std::system_error const &e) {
+      std::cerr << e.what() << std::endl;
+      return  1;
+    }
+    return  0;
+  } // decompress()
+
+  //- Columns ----------------------------------------------------------------
+  int columns(Database &dbx, int const  argc, char const *const  argv[]) {
+    if(argc != 1) {
+      usage();
+      return  1;
+    }
+    try {
+      DBColumns::split(dbx.roRange(), argv[0]);
+    }
+    catch(std::system_error const &e) {
+      std::cerr << e.what() << std::endl;
+      return  1;
+    }
+    return  0;
+  } // columns()
+
+  int rows(DBColumns &cols, int const  argc, char const *const  argv[]) {
+    if(argc != 1) {
+      usage();
+      return  1;
+    }
+    try {
+      DBWriter  out(argv[0]);
+      {
+	DBWriter::Stream  s(out);
+	std::unique_ptr<DBEntry[]>  buf(new DBEntry[DBArchive::BLOCK]);
+	for(size_t  beg = 0; beg < cols.size(); beg += DBArchive::BLOCK) {
+	  size_t const  end = std::min(beg + DBArchive::BLOCK, cols.size());
+	  for(size_t  i = beg; i < end; i++)  buf[i-beg] = cols.entry(i);
+	  s.write(buf.get(), buf.get()+(end-beg));
+	}
+	s.close();
+      }
+      out.close();
+    }
+    catch(std::system_error const &e) {
+      std::cerr << e.what() << std::endl;
+      return  1;
+    }
+    return  0;
+  } // rows()
 
   struct {
     char const *cmd;
@@ -339,23 +1524,101 @@ namespace {
     {"print",  print,  boost::iostreams::mapped_file::readonly},
     {"slice",  slice,  boost::iostreams::mapped_file::readonly},
     {"stats",  stats,  boost::iostreams::mapped_file::readonly},
+    {"index",  index,  boost::iostreams::mapped_file::readonly},
     {"queens", queens, boost::iostreams::mapped_file::readonly},
+    {"expand", expand, boost::iostreams::mapped_file::readonly},
     {"untake", untake, boost::iostreams::mapped_file::readwrite},
     {"unsolve",unsolve,boost::iostreams::mapped_file::readwrite},
-    {"merge",  merge,  boost::iostreams::mapped_file::readwrite}
+    {"merge",  merge,  boost::iostreams::mapped_file::readwrite},
+    {"split",  split,  boost::iostreams::mapped_file::readonly},
+    {"join",   join,   boost::iostreams::mapped_file::readwrite},
+    {"cost",   cost,   boost::iostreams::mapped_file::readonly},
+    {"schedule",schedule,boost::iostreams::mapped_file::readonly},
+    {"compress",compress,boost::iostreams::mapped_file::readonly},
+    {"columns",columns,boost::iostreams::mapped_file::readonly},
+    {"solvers",solvers,boost::iostreams::mapped_file::readonly}
+  };
+
+  // Commands reading Archives
+  struct {
+    char const *cmd;
+    int(*fct)(DBArchive&, int, char const*const*);
+  } const  ARCHIVE_COMMANDS[] = {
+    {"freq",   freq},
+    {"print",  print},
+    {"stats",  stats},
+    {"queens", queens},
+    {"solvers",solvers},
+    {"decompress", decompress}
+  };
+
+  // Commands reading Column Stores
+  struct {
+    char const *cmd;
+    int(*fct)(DBColumns&, int, char const*const*);
+  } const  COLUMN_COMMANDS[] = {
+    {"freq",   freq},
+    {"stats",  stats},
+    {"queens", queens},
+    {"solvers",solvers},
+    {"rows",   rows}
   };
 
 } // anonymous namespace
 
 int main(int const  argc, char const *const  argv[]) {
   prog = *argv;
-  if(argc >= 3) {
-    char const *const  cmd = argv[2];
+  int       i     = 1;
+  unsigned  rings = 0;  // detected
+  if((i < argc) && (strncmp(argv[i], "-r:", 3) == 0)) {
+    rings = (unsigned)strtoul(argv[i++]+3, 0, 0);
+    if((rings < 2) || (3 < rings))  usage();
+  }
+  if(argc-i >= 2) {
+    char const *const  cmd = argv[i+1];
 
+    if(DBArchive::detect(argv[i])) {
+      for(auto const &c : ARCHIVE_COMMANDS) {
+	if(strcmp(cmd, c.cmd) == 0) {
+	  try {
+	    DBArchive  arc(argv[i], rings);
+	    return  c.fct(arc, argc-i-2, argv+i+2);
+	  }
+	  catch(std::runtime_error const &e) {
+	    std::cerr << e.what() << std::endl;
+	    return  1;
+	  }
+	}
+      }
+      std::cerr << "Command not available on archives: " << cmd << "\n\n";
+      usage();
+    }
+    if(DBColumns::detect(argv[i])) {
+      for(auto const &c : COLUMN_COMMANDS) {
+	if(strcmp(cmd, c.cmd) == 0) {
+	  try {
+	    DBColumns  cols(argv[i], rings);
+	    return  c.fct(cols, argc-i-2, argv+i+2);
+	  }
+	  catch(std::runtime_error const &e) {
+	    std::cerr << e.what() << std::endl;
+	    return  1;
+	  }
+	}
+      }
+      std::cerr << "Command not available on columns: " << cmd << "\n\n";
+      usage();
+    }
     for(auto const &c : COMMANDS) {
       if(strcmp(cmd, c.cmd) == 0) {
-	Database  db(argv[1], c.mode);
-	return  c.fct(db, argc-3, argv+3);
+	try {
+	  Database  db(argv[i], c.mode, rings);
+	  return  c.fct(db, argc-i-2, argv+i+2);
+	}
+	catch(std::runtime_error const &e) {
+	  std::cerr << e.what() << std::endl;
+	  return  1;
+	}
       }
     }
     std::cerr << "Unknown command: " << cmd << "\n\n";
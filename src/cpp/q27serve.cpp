@@ -0,0 +1,649 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "Database.hpp"
+#include "Protocol.hpp"
+
+using namespace queens;
+using namespace queens::protocol;
+
+namespace {
+
+  char const *prog = "q27serve";
+
+  // Usage Output
+  void usage() {
+    std::cerr << prog << " [-c:<client port>] [-s:<status port>] [-t:<timeout_min>] [-f:<sec>] <queens.db> <duplicates.db> <solvers.log>\n\n"
+      "Serves the unsolved entries of the database to the clients of the Q27\n"
+      "protocol (FETCH_CASES, ANNOUNCE_SOLVER, REPORT_RESULT, DENOUNCE_SOLVER)\n"
+      "and records their results in place.\n\n"
+      "\t-c\tClient port (default: 27027).\n"
+      "\t-s\tStatus port on localhost (default: 27000).\n"
+      "\t-t\tLease timeout after which an unsolved entry is handed out again\n"
+      "\t\t(default: 360 min, 0 for testing). Entries taken before the start\n"
+      "\t\tcount as leased.\n"
+      "\t-f\tInterval of database flushes and progress reports (default: 60 s).\n\n"
+      "Results for entries solved before are appended to the duplicates in raw\n"
+      "database format, announced solvers to the log. The connections are plain\n"
+      "TCP; terminate TLS in front of the server, e.g. by stunnel.\n"
+	      << std::endl;
+    exit(1);
+  }
+
+  volatile sig_atomic_t  stopped = 0;
+  void stop(int) { stopped = 1; }
+
+  // The protocol exchanges the specs of two rings.
+  unsigned const  RINGS = 2;
+
+  // Throws the system_error of the current errno.
+  void fail(char const *const  what) {
+    throw  std::system_error(errno, std::system_category(), what);
+  }
+
+  // Listening non-blocking Socket
+  int listen(uint16_t const  port, bool const  local) {
+    int const  fd = socket(AF_INET, SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC, 0);
+    if(fd < 0)  fail("socket");
+    int const  one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in  addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(local? INADDR_LOOPBACK : INADDR_ANY);
+    if(bind(fd, (sockaddr const*)&addr, sizeof(addr)) != 0)  fail("bind");
+    if(::listen(fd, SOMAXCONN) != 0)  fail("listen");
+    return  fd;
+  }
+
+ /**
+  * Event-driven server of a memory-mapped database.
+  *
+  * All connections are served by a single epoll loop, which owns the
+  * database exclusively so that no locking is needed. Each readiness
+  * event consumes all complete commands received so far, fetches are
+  * answered by a single scan continuing from a cursor, and the replies
+  * are sent with a single write. Handed out entries are leased: a lease
+  * expiring unsolved puts its entry back to the front of the queue.
+  */
+  class Server {
+    struct Connection {
+      int                                  fd;
+      std::string                          host;     // peer address
+      std::string                          in;       // received unparsed
+      std::string                          out;      // pending to send
+      bool                                 writing;  // EPOLLOUT armed
+      std::unordered_map<uint32_t, unsigned>  solvers;  // client ID -> solver #
+
+    public:
+      Connection(int  _fd, std::string const &_host) : fd(_fd), host(_host), writing(false) {}
+      ~Connection() { close(fd); }
+    };
+
+    struct Lease {
+      DBEntry *entry;
+      uint64_t serial;  // of its current expiry
+    };
+    struct Expiry {
+      time_t    deadline;
+      uint64_t  serial;
+      uint64_t  spec;
+
+    public:
+      bool operator>(Expiry const &o) const {
+	return (deadline > o.deadline) || ((deadline == o.deadline) && (serial > o.serial));
+      }
+    };
+
+  private:
+    Database       &m_dbx;
+    DBRange         m_db;
+    DBEntry        *m_cursor;   // next fresh entry
+    time_t   const  m_timeout;  // of a lease in seconds
+
+    std::ofstream   m_dups;
+    std::ofstream   m_log;
+
+    std::unordered_map<uint64_t, Lease>  m_leases;  // by spec
+    std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry>>  m_expiry;
+    uint64_t                             m_serial;
+
+    // Solver numbers fill the 12-bit field. A number whose solver has no
+    // announcement on a live connection is idle and recycled, least
+    // recently idle first, once the unused ones are exhausted. The last
+    // number is shared by all solvers announced beyond that.
+    static unsigned const  SOLVERS = 1 << 12;
+    static unsigned const  SHARED  = SOLVERS - 1;
+    struct Solver {
+      unsigned  number;
+      unsigned  refs;  // announcements on live connections
+      uint64_t  idle;  // serial of its latest idle period
+    };
+    std::map<std::string, Solver>       m_solvers;  // by host and name
+    std::vector<std::string>            m_owners;   // by number
+    std::set<std::pair<uint64_t, unsigned>>  m_idle;  // by idle serial
+    unsigned                            m_nextSolver;
+    uint64_t                            m_idleSerial;
+
+    int  m_epoll;
+    int  m_clients;
+    int  m_status;
+    std::unordered_map<int, std::unique_ptr<Connection>>  m_conns;
+
+    // Statistics
+    uint64_t  m_done;      // solved entries of the database
+    uint64_t  m_fetched;
+    uint64_t  m_reissued;
+    uint64_t  m_solved;
+    uint64_t  m_dupCount;
+    uint64_t  m_spurious;
+
+  public:
+    Server(Database &dbx, unsigned  timeoutMin, char const *dups, char const *log);
+    ~Server();
+
+  private:
+    Server(Server const&) = delete;
+    Server& operator=(Server const&) = delete;
+
+  public:
+    void open(uint16_t  clientPort, uint16_t  statusPort);
+    void run(unsigned  interval);
+    std::string status() const;
+
+  private:
+    void accept();
+    void serveStatus();
+    void receive(Connection &c);
+    bool process(Connection &c, time_t  now);
+    void send(Connection &c);
+    void drop(Connection &c);
+
+    void     lease(DBEntry *e, time_t  now);
+    DBEntry *next(time_t  now);
+    void fetch(Connection &c, uint32_t  n, time_t  now);
+    void announce(Connection &c, uint32_t  id, std::string const &name);
+    void denounce(unsigned  solver);
+    void report(Connection &c, uint32_t  id, uint64_t  spec, uint64_t  res);
+
+  }; // class Server
+
+  Server::Server(Database &dbx, unsigned const  timeoutMin, char const *const  dups, char const *const  log)
+    : m_dbx(dbx), m_db(dbx.rwRange()), m_cursor(m_db.begin()), m_timeout(60*time_t(timeoutMin)),
+      m_dups(dups, std::ofstream::out|std::ofstream::binary|std::ofstream::app),
+      m_log (log,  std::ofstream::out|std::ofstream::app),
+      m_serial(0), m_owners(SOLVERS), m_nextSolver(1), m_idleSerial(0),
+      m_epoll(-1), m_clients(-1), m_status(-1), m_done(0), m_fetched(0), m_reissued(0), m_solved(0), m_dupCount(0), m_spurious(0) {
+
+    if(!m_dups)  throw  std::runtime_error(std::string("Cannot open duplicates ") + dups);
+    if(!m_log)   throw  std::runtime_error(std::string("Cannot open solver log ") + log);
+
+    // Entries taken before are leased from now on so that they are handed
+    // out again unless their result arrives in time. The solved ones are
+    // counted once, report() keeps track of the rest.
+    time_t const  now = ::time(NULL);
+    for(DBEntry &e : m_db) {
+      if(e.solved(RINGS))  m_done++;
+      else if(e.taken(RINGS) && e.valid(RINGS))  lease(&e, now);
+    }
+  }
+
+  Server::~Server() {
+    m_conns.clear();
+    if(m_status  >= 0)  close(m_status);
+    if(m_clients >= 0)  close(m_clients);
+    if(m_epoll   >= 0)  close(m_epoll);
+  }
+
+  void Server::open(uint16_t const  clientPort, uint16_t const  statusPort) {
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if(m_epoll < 0)  fail("epoll_create1");
+    m_clients = listen(clientPort, false);
+    m_status  = listen(statusPort, true);
+
+    for(int const  fd : { m_clients, m_status }) {
+      epoll_event  ev;
+      ev.events  = EPOLLIN;
+      ev.data.fd = fd;
+      if(epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) != 0)  fail("epoll_ctl");
+    }
+  }
+
+  std::string Server::status() const {
+    std::ostringstream  out;
+    out << "Q27 Database Status\n"
+	<< "Solved:   " << m_done << " / " << m_db.size() << '\n'
+	<< "Leased:   " << m_leases.size() << '\n'
+	<< "Clients:  " << m_conns.size() << '\n'
+	<< "Solvers:  " << (m_solvers.size() - m_idle.size()) << " active\n"
+	<< "Fetched:  " << m_fetched  << " (" << m_reissued << " reissued)\n"
+	<< "Reported: " << m_solved   << " (" << m_dupCount << " duplicates, "
+	<< m_spurious << " spurious)\n";
+    return  out.str();
+  }
+
+  void Server::run(unsigned const  interval) {
+    epoll_event  evs[256];
+    time_t  last = ::time(NULL);
+    while(!stopped) {
+      int const  k = epoll_wait(m_epoll, evs, sizeof(evs)/sizeof(evs[0]), 1000);
+      if(k < 0) {
+	if(errno == EINTR)  continue;
+	fail("epoll_wait");
+      }
+
+      time_t const  now = ::time(NULL);
+      for(int  i = 0; i < k; i++) {
+	int const  fd = evs[i].data.fd;
+	if(fd == m_clients) { accept(); continue; }
+	if(fd == m_status)  { serveStatus(); continue; }
+
+	auto const  it = m_conns.find(fd);
+	if(it == m_conns.end())  continue;
+	Connection &c = *it->second;
+	if(evs[i].events & (EPOLLERR|EPOLLHUP)) {
+	  drop(c);
+	  continue;
+	}
+	if(evs[i].events & EPOLLOUT) {
+	  send(c);
+	  if(!m_conns.count(fd))  continue;
+	}
+	if(evs[i].events & (EPOLLIN|EPOLLRDHUP)) {
+	  receive(c);
+	  if(!m_conns.count(fd))  continue;
+	  if(process(c, now))  send(c);
+	  else {
+	    std::cerr << c.host << ": Malformed command stream." << std::endl;
+	    drop(c);
+	  }
+	}
+      }
+
+      if(now - last >= time_t(interval)) {
+	if(!m_dbx.flush())  std::cerr << "Flushing the database failed." << std::endl;
+	m_dups.flush();
+	std::cout << m_conns.size() << " clients, " << m_leases.size() << " leased, "
+		  << m_fetched << " fetched (" << m_reissued << " reissued), "
+		  << m_solved << " solved, " << m_dupCount << " duplicates, "
+		  << m_spurious << " spurious" << std::endl;
+	last = now;
+      }
+    }
+    if(!m_dbx.flush())  std::cerr << "Flushing the database failed." << std::endl;
+    m_dups.flush();
+  }
+
+  void Server::accept() {
+    while(true) {
+      sockaddr_in  addr;
+      socklen_t    len = sizeof(addr);
+      int const  fd = accept4(m_clients, (sockaddr*)&addr, &len, SOCK_NONBLOCK|SOCK_CLOEXEC);
+      if(fd < 0) {
+	if((errno == EAGAIN) || (errno == EWOULDBLOCK))  return;
+	if((errno == EINTR) || (errno == ECONNABORTED))  continue;
+	std::cerr << "Accepting a client failed: " << strerror(errno) << std::endl;
+	return;
+      }
+      int const  one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+      char  host[INET_ADDRSTRLEN];
+      inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+      std::unique_ptr<Connection>  c(new Connection(fd, host));
+
+      epoll_event  ev;
+      ev.events  = EPOLLIN|EPOLLRDHUP;
+      ev.data.fd = fd;
+      if(epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+	std::cerr << "Registering a client failed: " << strerror(errno) << std::endl;
+	continue;
+      }
+      m_conns[fd] = std::move(c);
+    }
+  }
+
+  void Server::serveStatus() {
+    int const  fd = accept4(m_status, nullptr, nullptr, SOCK_CLOEXEC);
+    if(fd < 0)  return;
+    std::string const  text = status();
+    ssize_t const  k = ::write(fd, text.data(), text.size());
+    (void)k;  // best effort
+    close(fd);
+  }
+
+  void Server::receive(Connection &c) {
+    char  buf[1<<16];
+    while(true) {
+      ssize_t const  k = ::read(c.fd, buf, sizeof(buf));
+      if(k > 0) {
+	c.in.append(buf, k);
+	continue;
+      }
+      if(k == 0) {  // Orderly shutdown after the commands received
+	if(!process(c, ::time(NULL)))  std::cerr << c.host << ": Malformed command stream." << std::endl;
+	drop(c);
+	return;
+      }
+      if(errno == EINTR)  continue;
+      if((errno != EAGAIN) && (errno != EWOULDBLOCK))  drop(c);
+      return;
+    }
+  }
+
+  // Consumes all complete commands received. Returns false on a malformed one.
+  bool Server::process(Connection &c, time_t const  now) {
+    uint8_t const *const  buf = reinterpret_cast<uint8_t const*>(c.in.data());
+    size_t  const  len = c.in.size();
+    size_t  ofs = 0;
+    bool    ok  = true;
+    while(ofs < len) {
+      uint8_t const *const  p = buf + ofs;
+      size_t const  avail = len - ofs;
+      size_t  need;
+      switch(p[0]) {
+      case FETCH_CASES:
+	if(avail < (need = 5))  break;
+	{
+	  uint32_t const  n = get32(p+1);
+	  if(n > (1u << 24)) { ok = false; break; }
+	  fetch(c, n, now);
+	}
+	ofs += need;
+	continue;
+
+      case ANNOUNCE_SOLVER:
+	if(avail < 7)  break;
+	if(avail < (need = 7 + ((size_t(p[5]) << 8) | p[6])))  break;
+	announce(c, get32(p+1), std::string((char const*)p+7, need-7));
+	ofs += need;
+	continue;
+
+      case REPORT_RESULT:
+	if(avail < (need = 21))  break;
+	report(c, get32(p+1), get64(p+5), get64(p+13));
+	ofs += need;
+	continue;
+
+      case DENOUNCE_SOLVER:
+	if(avail < (need = 5))  break;
+	{
+	  auto const  it = c.solvers.find(get32(p+1));
+	  if(it != c.solvers.end()) {
+	    denounce(it->second);
+	    c.solvers.erase(it);
+	  }
+	}
+	ofs += need;
+	continue;
+
+      default:
+	ok = false;
+      }
+      break;
+    }
+    c.in.erase(0, ofs);
+    return  ok;
+  }
+
+  void Server::send(Connection &c) {
+    size_t  ofs = 0;
+    while(ofs < c.out.size()) {
+      ssize_t const  k = ::send(c.fd, c.out.data()+ofs, c.out.size()-ofs, MSG_NOSIGNAL);
+      if(k > 0) {
+	ofs += k;
+	continue;
+      }
+      if(errno == EINTR)  continue;
+      if((errno == EAGAIN) || (errno == EWOULDBLOCK))  break;
+      drop(c);
+      return;
+    }
+    c.out.erase(0, ofs);
+
+    // Wait for the socket to drain if the reply did not fit.
+    bool const  writing = !c.out.empty();
+    if(writing != c.writing) {
+      epoll_event  ev;
+      ev.events  = EPOLLIN|EPOLLRDHUP|(writing? EPOLLOUT : 0);
+      ev.data.fd = c.fd;
+      epoll_ctl(m_epoll, EPOLL_CTL_MOD, c.fd, &ev);
+      c.writing = writing;
+    }
+  }
+
+  void Server::drop(Connection &c) {
+    // Leases survive their connection so that results can still be
+    // reported after a reconnect.
+    for(auto const &s : c.solvers)  denounce(s.second);
+    int const  fd = c.fd;
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    m_conns.erase(fd);
+  }
+
+  // Leases the entry, or renews its lease, until the timeout from now.
+  void Server::lease(DBEntry *const  e, time_t const  now) {
+    uint64_t const  serial = m_serial++;
+    m_leases[e->spec(RINGS)] = Lease{ e, serial };
+    m_expiry.push(Expiry{ now + m_timeout, serial, e->spec(RINGS) });
+  }
+
+  // The next entry to hand out: expired leases first, then fresh entries
+  DBEntry *Server::next(time_t const  now) {
+    while(!m_expiry.empty() && (m_expiry.top().deadline < now)) {
+      Expiry const  top = m_expiry.top();
+      m_expiry.pop();
+
+      auto const  it = m_leases.find(top.spec);
+      if((it == m_leases.end()) || (it->second.serial != top.serial))  continue;  // reported or renewed
+      DBEntry *const  e = it->second.entry;
+      if(e->solved(RINGS)) {
+	m_leases.erase(it);
+	continue;
+      }
+      e->take(RINGS);
+      lease(e, now);
+      m_reissued++;
+      return  e;
+    }
+
+    while(m_cursor != m_db.end()) {
+      DBEntry *const  e = m_cursor++;
+      if(e->taken(RINGS) || e->solved(RINGS) || !e->valid(RINGS))  continue;
+      e->take(RINGS);
+      lease(e, now);
+      return  e;
+    }
+    return  nullptr;
+  }
+
+  void Server::fetch(Connection &c, uint32_t  n, time_t const  now) {
+    c.out.reserve(c.out.size() + 8*size_t(n));
+    while(n-- > 0) {
+      DBEntry const *const  e = next(now);
+      if(e != nullptr)  m_fetched++;
+      put64(c.out, e == nullptr? 0 : e->spec(RINGS));
+    }
+  }
+
+  void Server::announce(Connection &c, uint32_t const  id, std::string const &name) {
+    // Solvers of the same name on the same host share their number across
+    // reconnects. The name is Java's modified UTF-8 taken as is.
+    std::string const  key = c.host + ' ' + name;
+    auto  it = m_solvers.find(key);
+    if(it == m_solvers.end()) {
+      unsigned  number = SHARED;
+      if(m_nextSolver < SHARED)  number = m_nextSolver++;
+      else if(!m_idle.empty()) {
+	number = m_idle.begin()->second;
+	m_idle.erase(m_idle.begin());
+	m_solvers.erase(m_owners[number]);
+      }
+
+      // The log keeps the solver of a number at any time.
+      time_t const  t = ::time(NULL);
+      struct tm  ptm;
+      localtime_r(&t, &ptm);
+      char  stamp[32];
+      strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M", &ptm);
+      m_log << stamp << " SOLVER #" << std::setw(4) << number << ": " << key << std::endl;
+
+      if(number == SHARED) {
+	std::cerr << "Out of solver numbers, sharing #" << SHARED << " with " << key << '.' << std::endl;
+	auto const  prev = c.solvers.find(id);
+	if(prev != c.solvers.end())  denounce(prev->second);
+	c.solvers[id] = SHARED;
+	return;
+      }
+      m_owners[number] = key;
+      it = m_solvers.insert(std::make_pair(key, Solver{ number, 0, 0 })).first;
+    }
+
+    Solver &s = it->second;
+    auto const  prev = c.solvers.find(id);
+    if((prev != c.solvers.end()) && (prev->second == s.number))  return;  // repeated
+    if(s.refs++ == 0)  m_idle.erase(std::make_pair(s.idle, s.number));
+    if(prev != c.solvers.end())  denounce(prev->second);
+    c.solvers[id] = s.number;
+  }
+
+  // Releases an announcement of the solver of the given number.
+  void Server::denounce(unsigned const  number) {
+    if(number == SHARED)  return;
+    auto const  it = m_solvers.find(m_owners[number]);
+    if((it == m_solvers.end()) || (it->second.refs == 0))  return;
+    Solver &s = it->second;
+    if(--s.refs == 0) {
+      s.idle = m_idleSerial++;
+      m_idle.insert(std::make_pair(s.idle, s.number));
+    }
+  }
+
+  void Server::report(Connection &c, uint32_t const  id, uint64_t const  spec, uint64_t const  res) {
+    // Results are accepted for any entry of the database, also for those
+    // whose lease has ended or that were taken before the server started.
+    auto const  sit = c.solvers.find(id);
+    auto const  it  = m_leases.find(spec);
+    DBEntry *e = it != m_leases.end()? it->second.entry : nullptr;
+    if(e == nullptr) {
+      e = m_db.lub(spec);
+      if((e == m_db.end()) || (e->spec(RINGS) != spec))  e = nullptr;
+    }
+    if((sit == c.solvers.end()) || (e == nullptr) || (res >> 52) || (mod13(res) > 12) || (mod15(res) > 14)) {
+      std::cerr << "Spurious result: 0x" << std::hex << std::uppercase << std::setfill('0')
+		<< std::setw(11) << spec << ": 0x" << std::setw(13) << res
+		<< std::dec << std::setfill(' ') << " by " << c.host << " #" << id << std::endl;
+      m_spurious++;
+      return;
+    }
+
+    unsigned const  solver = sit->second;
+    if(!e->solved(RINGS)) {
+      e->solve(RINGS, solver, count(res), mod15(res), mod13(res));
+      m_solved++;
+      m_done++;
+    }
+    else {  // Secondary Result in raw Database Format
+      DBEntry  dup(*e);
+      dup.solve(RINGS, solver, count(res), mod15(res), mod13(res));
+      m_dups.write((char const*)&dup, sizeof(dup));
+      m_dupCount++;
+    }
+    if(it != m_leases.end())  m_leases.erase(it);
+  }
+
+} // anonymous namespace
+
+int main(int const  argc, char const *const  argv[]) {
+  prog = *argv;
+
+  // Parse Options
+  unsigned  clientPort = 27027;
+  unsigned  statusPort = 27000;
+  unsigned  timeout    =   360;
+  unsigned  interval   =    60;
+
+  int  i = 1;
+  for(; (i < argc) && (argv[i][0] == '-'); i++) {
+    char const *const  arg = argv[i];
+    if(strncmp(arg, "-c:", 3) == 0)  clientPort = (unsigned)strtoul(arg+3, 0, 0);
+    else if(strncmp(arg, "-s:", 3) == 0)  statusPort = (unsigned)strtoul(arg+3, 0, 0);
+    else if(strncmp(arg, "-t:", 3) == 0)  timeout    = (unsigned)strtoul(arg+3, 0, 0);
+    else if(strncmp(arg, "-f:", 3) == 0)  interval   = (unsigned)strtoul(arg+3, 0, 0);
+    else {
+      std::cerr << "Unknown option: " << arg << "\n\n";
+      usage();
+    }
+  }
+  if(argc-i != 3)  usage();
+  if((clientPort == 0) || (clientPort > 65535) || (statusPort == 0) || (statusPort > 65535)) {
+    std::cerr << "Ports must be from 1..65535.\n\n";
+    usage();
+  }
+  if(interval == 0)  interval = 1;
+
+  try {
+    Database  dbx(argv[i], boost::iostreams::mapped_file::readwrite, RINGS);
+    Server    server(dbx, timeout, argv[i+1], argv[i+2]);
+    server.open(clientPort, statusPort);
+
+    signal(SIGINT,  stop);
+    signal(SIGTERM, stop);
+    std::cout << "Serving " << dbx.size() << " entries on port " << clientPort
+	      << " (status on localhost:" << statusPort << ") ..." << std::endl;
+    server.run(interval);
+    std::cout << "Stopped.\n" << server.status() << std::flush;
+  }
+  catch(std::exception const &e) {
+    std::cerr << e.what() << std::endl;
+    return  1;
+  }
+  return  0;
+
+} // main()
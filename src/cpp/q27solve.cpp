@@ -0,0 +1,288 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <string.h>
+
+#include "Database.hpp"
+#include "Kernel.hpp"
+#include "ZoneMap.hpp"
+#include "range/RangeParser.hpp"
+#include "range/IR.hpp"
+
+using namespace queens;
+using namespace queens::range;
+
+namespace {
+
+  char const *prog = "q27solve";
+
+  // Usage Output
+  void usage() {
+    std::cerr << prog <<
+      " [-x:<threads>] [-k:<kernel>] [-s:<solver>] [-n:<dim>] [-f:<sec>] [-t:<timeout_min>] [-r:3]"
+      " <queens.db> [<range> ...]\n\n"
+      "Solves the unsolved entries of the database in place.\n\n"
+      "\t-x\tNumber of worker threads (default: all cores).\n"
+      "\t-k\tCompletion kernel:";
+    for(unsigned  i = 0; i < Kernel::NUM_KERNELS; i++) {
+      std::cerr << ' ' << Kernel::KERNELS[i].name;
+      if(Kernel::KERNELS[i].experimental)  std::cerr << " (experimental)";
+    }
+    std::cerr << "\n\t\t(default: " << Kernel::KERNELS[0].name << ").\n"
+      "\t-s\tSolver ID from 1..4095 recorded with the solutions (default: 1).\n"
+      "\t-n\tBoard dimension of the database (default: 27).\n"
+      "\t-f\tInterval of flushing solutions to disk (default: 60s).\n"
+      "\t-t\tReclaim entries taken longer ago, e.g. by a crashed process or\n"
+      "\t\tan expired server lease (default: 360 min, 0 never reclaims).\n"
+      "\t-r:3\tInsists on pre-placements of three rings (coronal2 -r:3) rather\n"
+      "\t\tthan detecting the layout of the entries.\n"
+      "\n\tThe ranges use the syntax of 'q27db print' and restrict\n"
+      "\tthe entries to solve successively. Several processes may solve\n"
+      "\tthe same database as each entry is claimed atomically. Each\n"
+      "\tworker claims from its own blocks of the range before sweeping\n"
+      "\tthe others' for the entries left over.\n"
+	      << std::endl;
+    exit(1);
+  }
+
+  // Termination Request by Signal
+  volatile sig_atomic_t  stopped = 0;
+  void stop(int) { stopped = 1; }
+
+  // Entries claimed and solved by a Worker at a Time
+  unsigned const  BATCH_SIZE = 16;
+
+  // Per-Thread Statistics padded apart to separate Cache Lines
+  struct Counts {
+    std::atomic<uint64_t>  done;
+    uint64_t               nodes;
+    uint64_t               pad[14];
+    Counts() : done(0), nodes(0) {}
+  };
+
+} // anonymous namespace
+
+int main(int const  argc, char const *const  argv[]) {
+  prog = *argv;
+
+  // Parse Options
+  unsigned      threads  = std::thread::hardware_concurrency();
+  Kernel const *kernel   = &Kernel::KERNELS[0];
+  unsigned      solver   = 1;
+  unsigned      N        = 27;
+  unsigned      interval = 60;
+  unsigned      timeout  = 360;
+  unsigned      rings    = 0;  // detected
+
+  int  i = 1;
+  for(; (i < argc) && (argv[i][0] == '-'); i++) {
+    char const *const  arg = argv[i];
+    if(strncmp(arg, "-x:", 3) == 0)  threads  = (unsigned)strtoul(arg+3, 0, 0);
+    else if(strncmp(arg, "-s:", 3) == 0)  solver   = (unsigned)strtoul(arg+3, 0, 0);
+    else if(strncmp(arg, "-n:", 3) == 0)  N        = (unsigned)strtoul(arg+3, 0, 0);
+    else if(strncmp(arg, "-f:", 3) == 0)  interval = (unsigned)strtoul(arg+3, 0, 0);
+    else if(strncmp(arg, "-t:", 3) == 0)  timeout  = (unsigned)strtoul(arg+3, 0, 0);
+    else if(strcmp(arg, "-r:3") == 0)  rings = 3;
+    else if(strncmp(arg, "-k:", 3) == 0) {
+      kernel = Kernel::find(arg+3);
+      if(kernel == nullptr) {
+	std::cerr << "Unknown kernel: " << (arg+3) << "\n\n";
+	usage();
+      }
+      if(!kernel->supported()) {
+	std::cerr << "Kernel " << kernel->name << " is not supported by this CPU." << std::endl;
+	return  1;
+      }
+    }
+    else {
+      std::cerr << "Unknown option: " << arg << "\n\n";
+      usage();
+    }
+  }
+  if(i >= argc)  usage();
+  if((N < Kernel::MIN_N) || (Kernel::MAX_N < N)) {
+    std::cerr << "Board dimension must be from " << Kernel::MIN_N << ".." << Kernel::MAX_N << ".\n\n";
+    usage();
+  }
+  if((solver == 0) || (solver > 4095)) {
+    // An entry without solutions solved by #0 would look unsolved.
+    std::cerr << "Solver ID must be from 1..4095.\n\n";
+    usage();
+  }
+  if(threads == 0)  threads = 1;
+
+  std::unique_ptr<Database>  dbp;
+  try {
+    dbp.reset(new Database(argv[i], boost::iostreams::mapped_file::readwrite, rings));
+  }
+  catch(std::runtime_error const &e) {
+    std::cerr << e.what() << std::endl;
+    return  1;
+  }
+  Database &dbx = *dbp;
+  ZoneMap   zones(argv[i++], dbx.roRange());  // speeds up range searches
+  DBRange   db(dbx.rwRange());
+  DBEntry *const  base = db.begin();
+  unsigned const  L    = dbx.rings();
+
+  { // Parse range restrictions
+    DBConstRange  range(db);
+    RangeParser   parser(&zones);
+    for(; i < argc; i++) {
+      try {
+	range = parser.parse(argv[i])->resolve(range);
+      }
+      catch(ParseException const &e) {
+	std::cerr << "Exception parsing the range specification:\n"
+		  << "\t'" << argv[i] << "' @" << e.position() << ": " << e.message()
+		  << std::endl;
+	return  1;
+      }
+    }
+    db = DBRange(base + (range.begin()-base), base + (range.end()-base), L);
+  }
+
+  // Count the Entries to solve. As the database does not record its
+  // board dimension, a mismatching one is caught here before any entry
+  // is modified.
+  time_t const  stale = timeout == 0? 0 : ::time(NULL) - 60*time_t(timeout);
+  uint64_t  total = 0;
+  for(DBEntry const &e : db) {
+    if(!e.solved(L) && e.valid(L) && (!e.taken(L) || ((stale != 0) && e.stale(L, stale)))) {
+      uint64_t  bv, bh, bu, bd;
+      if(!e.expand(L, N, bv, bh, bu, bd)) {
+	std::cerr << "Entry @" << (&e-base) << " is no valid pre-placement for N=" << N << ":\n\t"
+		  << e.format(L) << std::endl;
+	return  1;
+      }
+      total++;
+    }
+  }
+  std::cout << "Solving " << total << " of " << db.size() << " entries"
+	    << " for N=" << N << " as solver #" << solver
+	    << " using kernel " << kernel->name << " on " << threads << " thread(s) ..."
+	    << std::endl;
+
+  signal(SIGINT,  stop);
+  signal(SIGTERM, stop);
+
+  std::unique_ptr<Counts[]>  counts(new Counts[threads]);
+  auto const  start = std::chrono::steady_clock::now();
+  auto        flushed = start;
+  auto const  report = [&]() {
+    uint64_t  done = 0;
+    for(unsigned  t = 0; t < threads; t++)  done += counts[t].done.load(std::memory_order_relaxed);
+    std::cout << "\rProgress: " << done << '/' << total << std::flush;
+
+    auto const  now = std::chrono::steady_clock::now();
+    if(now - flushed >= std::chrono::seconds(interval)) {
+      if(!dbx.flush())  std::cerr << "\nFlushing the database failed." << std::endl;
+      flushed = now;
+    }
+  };
+
+  // Completion Workers: each claims through its own cursor so that
+  // neither a dispatcher nor other processes solving the same database
+  // are contended with.
+  Kernel::solve_t const  solve = kernel->specialize(N);
+  std::atomic<unsigned>  running(threads);
+  auto const  work = [&](unsigned  tid) {
+    Counts   &c = counts[tid];
+    DBCursor  cursor(db, tid, threads, timeout);
+    DBEntry  *batch[BATCH_SIZE];
+    Blocking  blk  [BATCH_SIZE];
+    uint64_t  res  [BATCH_SIZE];
+    while(!stopped) {
+      unsigned  n = 0;
+      while(n < BATCH_SIZE) {
+	DBEntry *const  e = cursor.claim();
+	if(e == nullptr)  break;
+	batch[n++] = e;
+      }
+      if(n == 0)  break;
+
+      // Decode Pre-Placements: validated before
+      for(unsigned  j = 0; j < n; j++) {
+	uint64_t  bv, bh, bu, bd;
+	batch[j]->expand(L, N, bv, bh, bu, bd);
+	blk[j] = Blocking::fromBoard(N, bv, bh, bu, bd);
+      }
+
+      // Count and record Solutions
+      solve(blk, n, res, c.nodes);
+      for(unsigned  j = 0; j < n; j++) {
+	uint64_t const  cnt = res[j];
+	batch[j]->solve(L, solver, cnt, cnt%15, cnt%13);
+      }
+      c.done.fetch_add(n, std::memory_order_relaxed);
+    }
+    running--;
+  };
+  {
+    std::vector<std::thread>  pool;
+    for(unsigned  t = 0; t < threads; t++)  pool.emplace_back(work, t);
+    bool  told = false;
+    auto  last = start;
+    while(running > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      if(stopped && !told) {
+	std::cout << "\nStopping after the entries in progress ..." << std::endl;
+	told = true;
+      }
+      auto const  now = std::chrono::steady_clock::now();
+      if(now - last >= std::chrono::seconds(1)) {
+	report();
+	last = now;
+      }
+    }
+    for(std::thread &t : pool)  t.join();
+  }
+  report();
+
+  double const  elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if(!dbx.flush()) {
+    std::cerr << "\nFlushing the database failed." << std::endl;
+    return  1;
+  }
+
+  uint64_t  done  = 0;
+  uint64_t  nodes = 0;
+  for(unsigned  t = 0; t < threads; t++) {
+    done  += counts[t].done.load();
+    nodes += counts[t].nodes;
+  }
+  std::cout << "\n\nSolved: " << done << " entries"
+	    << "\nTime:   " << std::fixed << std::setprecision(3) << elapsed << " s"
+	    << "\nRate:   " << std::setprecision(1) << (done/elapsed) << " entries/s"
+	    << "\nNodes:  " << nodes << " (" << std::setprecision(0) << (nodes/elapsed) << "/s)"
+	    << std::endl;
+  return  0;
+
+} // main()
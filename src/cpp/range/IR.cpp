@@ -22,35 +22,46 @@
 
 #include "../Database.hpp"
 
+using queens::DBArchive;
 using queens::DBConstRange;
 using queens::DBEntry;
+using queens::ZoneMap;
 using namespace queens::range;
 
 SNumber::~SNumber() {}
  
 //- class SPredicate ---------------------------------------------------------
 static class : public SPredicate {
-  bool operator()(DBEntry const &e) const { return  true; }
+  bool  operator()(DBEntry const &e, unsigned  rings) const { return  true; }
+  Match operator()(ZoneMap::Zone const &z) const { return  Match::ALL; }
 } PRED_TRUE;
 std::shared_ptr<SPredicate> const  SPredicate::TRUE(&PRED_TRUE, [](void*){});
 
 static class : public SPredicate {
-  bool operator()(DBEntry const &e) const { return  e.taken() && !e.solved(); }
+  bool  operator()(DBEntry const &e, unsigned  rings) const { return  e.taken(rings) && !e.solved(rings); }
+  Match operator()(ZoneMap::Zone const &z) const { return  Match::NONE; }
 } PRED_TAKEN;
 std::shared_ptr<SPredicate> const  SPredicate::TAKEN(&PRED_TAKEN, [](void*){});
 
 static class : public SPredicate {
-  bool operator()(DBEntry const &e) const { return  e.solved(); }
+  bool  operator()(DBEntry const &e, unsigned  rings) const { return  e.solved(rings); }
+  Match operator()(ZoneMap::Zone const &z) const { return  Match::ALL; }
 } PRED_SOLVED;
 std::shared_ptr<SPredicate> const  SPredicate::SOLVED(&PRED_SOLVED, [](void*){});
 
 static class : public SPredicate {
-  bool operator()(DBEntry const &e) const { return  e.wrapped(); }
+  bool  operator()(DBEntry const &e, unsigned  rings) const { return  e.wrapped(rings); }
+  Match operator()(ZoneMap::Zone const &z) const {
+    return  z.wrapped == 0? Match::NONE : z.wrapped == z.solved? Match::ALL : Match::SOME;
+  }
 } PRED_WRAPPED;
 std::shared_ptr<SPredicate> const  SPredicate::WRAPPED(&PRED_WRAPPED, [](void*){});
 
 static class : public SPredicate {
-  bool operator()(DBEntry const &e) const { return  e.valid(); }
+  bool  operator()(DBEntry const &e, unsigned  rings) const { return  e.valid(rings); }
+  Match operator()(ZoneMap::Zone const &z) const {
+    return  z.invalid == 0? Match::ALL : z.invalid == z.solved? Match::NONE : Match::SOME;
+  }
 } PRED_VALID;
 std::shared_ptr<SPredicate> const  SPredicate::VALID(&PRED_VALID, [](void*){});
 
@@ -65,7 +76,11 @@ SPredicate::createInverted(std::shared_ptr<SPredicate> const &target) {
     ~Inverted() {}
 
   public:
-    bool operator()(DBEntry const &e) const { return !(*m_target)(e); }
+    bool  operator()(DBEntry const &e, unsigned  rings) const { return !(*m_target)(e, rings); }
+    Match operator()(ZoneMap::Zone const &z) const {
+      Match const  m = (*m_target)(z);
+      return  m == Match::ALL? Match::NONE : m == Match::NONE? Match::ALL : Match::SOME;
+    }
   };
   return  std::make_shared<Inverted>(target);
 }
@@ -74,64 +89,136 @@ SPredicate::createInverted(std::shared_ptr<SPredicate> const &target) {
 std::shared_ptr<SAddress> SAddress::create(uint64_t  spec, unsigned  wild) {
   class RawAddress : public SAddress {
     uint64_t const  m_spec;
-    uint64_t const  m_mask;
+    unsigned const  m_wild;
 
   public:
-    RawAddress(uint64_t  spec, unsigned  wild)
-      : m_spec(spec<<5), m_mask((UINT64_C(1) << 5*(wild+1))-1) {}
+    RawAddress(uint64_t  spec, unsigned  wild) : m_spec(spec), m_wild(wild) {}
     ~RawAddress() {}
 
+  private:
+    // The two outer rings lead the specs of both entry layouts. With three
+    // rings, they are followed by another 20 bits of the third ring.
+    static unsigned low(unsigned  rings) { return  rings == 3? 25 : 5; }
+    uint64_t spec(unsigned  rings) const { return  m_spec << low(rings); }
+    uint64_t mask(unsigned  rings) const {
+      unsigned const  bits = low(rings) + 5*m_wild;
+      return  bits < 64? ~(~UINT64_C(0) << bits) : ~UINT64_C(0);
+    }
+
   public:
     DBEntry const *operator()(DBConstRange const &db, AddrType  type) const {
       switch(type) {
       case AddrType::LOWER:
-	return  db.lub(m_spec & ~m_mask);
+	return  db.lub(spec(db.rings()) & ~mask(db.rings()));
       case AddrType::UPPER:
-	return  db.glb(m_spec |  m_mask);
+	return  db.glb(spec(db.rings()) |  mask(db.rings()));
       }
       return  nullptr;
     }
+    size_t operator()(DBArchive::Range const &db, AddrType  type) const {
+      unsigned const  L = db.archive().rings();
+      switch(type) {
+      case AddrType::LOWER:
+	return  db.lub(spec(L) & ~mask(L));
+      case AddrType::UPPER:
+	return  db.glb(spec(L) |  mask(L));
+      }
+      return  DBArchive::NONE;
+    }
   };
   return  std::make_shared<RawAddress>(spec, wild);
 }
 
-std::shared_ptr<SAddress> SAddress::createFirst(std::shared_ptr<SPredicate> const &p) {
+std::shared_ptr<SAddress> SAddress::createFirst(std::shared_ptr<SPredicate> const &p, ZoneMap const *const  zones) {
   class First : public SAddress {
     std::shared_ptr<SPredicate>  m_pred;
+    ZoneMap const *const         m_zones;
 
   public:
-    First(std::shared_ptr<SPredicate> const &pred) : m_pred(pred) {}
+    First(std::shared_ptr<SPredicate> const &pred, ZoneMap const *zones) : m_pred(pred), m_zones(zones) {}
     ~First() {}
 
   public:
     DBEntry const *operator()(DBConstRange const &db, AddrType  type) const {
-      for(DBEntry const &e : db) {
-	if((*m_pred)(e))  return &e;
+      ZoneMap const *const  zm = m_zones;
+      for(DBEntry const *ptr = db.begin(); ptr < db.end();) {
+	// Skip or take trusted zones as a whole, scan all others.
+	DBEntry const *end = db.end();
+	if(zm) {
+	  size_t const  z = zm->zone(ptr);
+	  if(zm->end(z) < end)  end = zm->end(z);
+	  ZoneMap::Zone const *const  zn = zm->trusted(z);
+	  if(zn && (ptr == zm->begin(z)) && (end == zm->end(z))) {
+	    SPredicate::Match const  m = (*m_pred)(*zn);
+	    if(m == SPredicate::Match::ALL)  return  ptr;
+	    if(m == SPredicate::Match::NONE) {
+	      ptr = end;
+	      continue;
+	    }
+	  }
+	}
+	for(; ptr < end; ptr++) {
+	  if((*m_pred)(*ptr, db.rings()))  return  ptr;
+	}
+      }
+      return  db.end();
+    }
+    size_t operator()(DBArchive::Range const &db, AddrType  type) const {
+      unsigned const  L = db.archive().rings();
+      for(size_t  i = db.begin(); i < db.end(); i++) {
+	if((*m_pred)(db[i], L))  return  i;
       }
       return  db.end();
     }
   };
-  return  std::make_shared<First>(p);
+  return  std::make_shared<First>(p, zones);
 }
 
-std::shared_ptr<SAddress> SAddress::createLast(std::shared_ptr<SPredicate> const &p) {
+std::shared_ptr<SAddress> SAddress::createLast(std::shared_ptr<SPredicate> const &p, ZoneMap const *const  zones) {
   class Last : public SAddress {
     std::shared_ptr<SPredicate const>  m_pred;
+    ZoneMap const *const               m_zones;
 
   public:
-    Last(std::shared_ptr<SPredicate const> const &pred) : m_pred(pred) {}
+    Last(std::shared_ptr<SPredicate const> const &pred, ZoneMap const *zones) : m_pred(pred), m_zones(zones) {}
     ~Last() {}
 
   public:
     DBEntry const *operator()(DBConstRange const &db, AddrType  type) const {
       DBEntry const *const  beg = db.begin();
-      for(DBEntry const *ptr = db.end(); --ptr >= beg;) {
-	if((*m_pred)(*ptr))  return  ptr;
+      ZoneMap const *const  zm  = m_zones;
+      for(DBEntry const *ptr = db.end(); ptr > beg;) {
+	// Skip or take trusted zones as a whole, scan all others.
+	DBEntry const *low = beg;
+	if(zm) {
+	  size_t const  z = zm->zone(ptr-1);
+	  if(zm->begin(z) > low)  low = zm->begin(z);
+	  ZoneMap::Zone const *const  zn = zm->trusted(z);
+	  if(zn && (ptr == zm->end(z)) && (low == zm->begin(z))) {
+	    SPredicate::Match const  m = (*m_pred)(*zn);
+	    if(m == SPredicate::Match::ALL)  return  ptr-1;
+	    if(m == SPredicate::Match::NONE) {
+	      ptr = low;
+	      continue;
+	    }
+	  }
+	}
+	while(--ptr >= low) {
+	  if((*m_pred)(*ptr, db.rings()))  return  ptr;
+	}
+	ptr = low;
       }
       return  nullptr;
     }
+    size_t operator()(DBArchive::Range const &db, AddrType  type) const {
+      unsigned const  L = db.archive().rings();
+      for(size_t  i = db.end(); i-- > db.begin();) {
+	if((*m_pred)(db[i], L))  return  i;
+      }
+      return  DBArchive::NONE;
+    }
   };
-  return  std::make_shared<Last>(p);
+  return  std::make_shared<Last>(p, zones);
 }
 
 std::shared_ptr<SAddress> SAddress::createOffset(std::shared_ptr<SAddress> const &base, int  ofs) {
@@ -157,6 +244,19 @@ std::shared_ptr<SAddress> SAddress::createOffset(std::shared_ptr<SAddress> const
       }
       return  base;
     }
+    size_t operator()(DBArchive::Range const &db, AddrType  type) const {
+      size_t  base = (*m_base)(db, type);
+      if((base != DBArchive::NONE) && (base != db.end())) {
+	if(m_offs > 0) {
+	  if(base + m_offs > db.end())  return  db.end();
+	}
+	else {
+	  if(base < db.begin() + size_t(-m_offs))  return  DBArchive::NONE;
+	}
+	base += m_offs;
+      }
+      return  base;
+    }
   };
   return  ofs == 0? base : std::make_shared<Offset>(base, ofs);
 }
@@ -175,7 +275,12 @@ std::shared_ptr<SRange> SRange::create(std::shared_ptr<SAddress> const &beg, std
     DBConstRange resolve(DBConstRange const &db) const {
       DBEntry const *beg = (*m_beg)(db, SAddress::AddrType::LOWER);
       DBEntry const *end = (*m_end)(db, SAddress::AddrType::UPPER);
-      return  DBConstRange(beg, (beg > end)||(end == nullptr)? beg : end == db.end()? end : end+1);
+      return  DBConstRange(beg, (beg > end)||(end == nullptr)? beg : end == db.end()? end : end+1, db.rings());
+    }
+    DBArchive::Range resolve(DBArchive::Range const &db) const {
+      size_t const  beg = (*m_beg)(db, SAddress::AddrType::LOWER);
+      size_t const  end = (*m_end)(db, SAddress::AddrType::UPPER);
+      return  DBArchive::Range(db.archive(), beg, (beg > end)||(end == DBArchive::NONE)? beg : end == db.end()? end : end+1);
     }
   };
   return  std::make_shared<Range>(beg, end);
@@ -207,7 +312,25 @@ std::shared_ptr<SRange> SRange::createSpan(std::shared_ptr<SAddress> const &base
 	  if(beg < db.begin())  beg = db.begin();
 	}
       }
-      return  DBConstRange(beg, end);
+      return  DBConstRange(beg, end, db.rings());
+    }
+    DBArchive::Range resolve(DBArchive::Range const &db) const {
+      size_t const  base = (*m_base)(db, m_span >= 0? SAddress::AddrType::LOWER : SAddress::AddrType::UPPER);
+      size_t  beg, end;
+
+      if((base == DBArchive::NONE) || (base == db.end()))  beg = end = base;
+      else {
+	if(m_span >= 0) {
+	  beg = base;
+	  end = base + m_span + 1;
+	  if(end > db.end())  end = db.end();
+	}
+	else {
+	  end = base + 1;
+	  beg = base < db.begin() + size_t(-m_span)? db.begin() : base + m_span;
+	}
+      }
+      return  DBArchive::Range(db.archive(), beg, end);
     }
   };
   return  std::make_shared<Span>(base, span);
@@ -233,7 +356,19 @@ std::shared_ptr<SRange> SRange::createBiSpan(std::shared_ptr<SAddress> const &ba
 	end = base + m_span + 1;
 	if(end > db.end())  end = db.end();
       }
-      return  DBConstRange(beg, end);
+      return  DBConstRange(beg, end, db.rings());
+    }
+    DBArchive::Range resolve(DBArchive::Range const &db) const {
+      size_t const  base = (*m_base)(db, SAddress::AddrType::LOWER);
+      size_t  beg, end;
+
+      if((base == DBArchive::NONE) || (base == db.end()))  beg = end = base;
+      else {
+	beg = base < db.begin() + m_span? db.begin() : base - m_span;
+	end = base + m_span + 1;
+	if(end > db.end())  end = db.end();
+      }
+      return  DBArchive::Range(db.archive(), beg, end);
     }
   };
   return  std::make_shared<BiSpan>(base, span);
@@ -25,6 +25,8 @@
 #include <memory>
 
 #include "../Database.hpp"
+#include "../DBArchive.hpp"
+#include "../ZoneMap.hpp"
 
 namespace queens {
   namespace range {
@@ -58,7 +60,13 @@ namespace queens {
 
       //+ Functional Interface
     public:
-      virtual bool operator()(DBEntry const &e) const = 0;
+      // Tests an entry of the layout of the given number of rings.
+      virtual bool operator()(DBEntry const &e, unsigned  rings) const = 0;
+
+      // Classifies all entries of a trusted, i.e. completely solved, zone
+      // so that searches may skip it as a whole.
+      enum class Match { NONE, SOME, ALL };
+      virtual Match operator()(ZoneMap::Zone const &z) const { return  Match::SOME; }
 
       //+ Static Factories
     public:
@@ -86,11 +94,17 @@ namespace queens {
     public:
       virtual DBEntry const *operator()(DBConstRange const &db, AddrType  type) const = 0;
 
+      // The same address within an archive by index, DBArchive::NONE for
+      // nullptr.
+      virtual size_t operator()(DBArchive::Range const &db, AddrType  type) const = 0;
+
       //+ Static Factories
     public:
       static std::shared_ptr<SAddress> create(uint64_t  spec, unsigned  wild);
-      static std::shared_ptr<SAddress> createFirst(std::shared_ptr<SPredicate> const &p);
-      static std::shared_ptr<SAddress> createLast (std::shared_ptr<SPredicate> const &p);
+      // The first and last entries satisfying the predicate, searched by
+      // the given block index of the database if any.
+      static std::shared_ptr<SAddress> createFirst(std::shared_ptr<SPredicate> const &p, ZoneMap const *zones = nullptr);
+      static std::shared_ptr<SAddress> createLast (std::shared_ptr<SPredicate> const &p, ZoneMap const *zones = nullptr);
       static std::shared_ptr<SAddress> createOffset(std::shared_ptr<SAddress> const &base, int  ofs);
 
     }; // class SAddress
@@ -102,7 +116,8 @@ namespace queens {
       ~SRange() {}
 
     public:
-      virtual DBConstRange resolve(DBConstRange const &db) const = 0;
+      virtual DBConstRange     resolve(DBConstRange     const &db) const = 0;
+      virtual DBArchive::Range resolve(DBArchive::Range const &db) const = 0;
 
       //+ Static Factories
     public:
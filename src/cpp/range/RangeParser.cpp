@@ -1,4 +1,4 @@
-#line 61 "RangeParser.ypp"
+#line 65 "RangeParser.ypp"
 
 #include "RangeParser.hpp"
 #include "IR.hpp"
@@ -382,7 +382,7 @@ void queens::range::RangeParser::parse() {
         case 0:         // accept
           return;
 case 1: {
-#line 180 "RangeParser.ypp"
+#line 184 "RangeParser.ypp"
 
           m_range = SRange::create(
 	              std::static_pointer_cast<SAddress>(yystack[yylen - 1]),
@@ -393,7 +393,7 @@ case 1: {
 break;
 }
 case 2: {
-#line 186 "RangeParser.ypp"
+#line 190 "RangeParser.ypp"
 
           m_range = SRange::create(
 	              std::static_pointer_cast<SAddress>(yystack[yylen - 1]),
@@ -404,7 +404,7 @@ case 2: {
 break;
 }
 case 3: {
-#line 192 "RangeParser.ypp"
+#line 196 "RangeParser.ypp"
 
           m_range = SRange::createSpan(
 	              std::static_pointer_cast<SAddress>(yystack[yylen - 1]),
@@ -415,7 +415,7 @@ case 3: {
 break;
 }
 case 4: {
-#line 198 "RangeParser.ypp"
+#line 202 "RangeParser.ypp"
 
           m_range = SRange::createSpan(
 	              std::static_pointer_cast<SAddress>(yystack[yylen - 1]),
@@ -426,7 +426,7 @@ case 4: {
 break;
 }
 case 5: {
-#line 204 "RangeParser.ypp"
+#line 208 "RangeParser.ypp"
 
           m_range = SRange::createBiSpan(
 	              std::static_pointer_cast<SAddress>(yystack[yylen - 1]),
@@ -437,39 +437,39 @@ case 5: {
 break;
 }
 case 6: {
-#line 211 "RangeParser.ypp"
+#line 215 "RangeParser.ypp"
 
-        yylval = SAddress::createFirst(SPredicate::TRUE);
+        yylval = SAddress::createFirst(SPredicate::TRUE, m_zones);
        
 #line 444 "RangeParser.cpp"
 break;
 }
 case 7: {
-#line 214 "RangeParser.ypp"
+#line 218 "RangeParser.ypp"
 
-	yylval = SAddress::createFirst(std::static_pointer_cast<SPredicate>(yystack[yylen - 3]));
+	yylval = SAddress::createFirst(std::static_pointer_cast<SPredicate>(yystack[yylen - 3]), m_zones);
        
 #line 452 "RangeParser.cpp"
 break;
 }
 case 8: {
-#line 217 "RangeParser.ypp"
+#line 221 "RangeParser.ypp"
 
-	yylval = SAddress::createLast(SPredicate::TRUE);
+	yylval = SAddress::createLast(SPredicate::TRUE, m_zones);
        
 #line 460 "RangeParser.cpp"
 break;
 }
 case 9: {
-#line 220 "RangeParser.ypp"
+#line 224 "RangeParser.ypp"
 
-	yylval = SAddress::createLast(std::static_pointer_cast<SPredicate>(yystack[yylen - 3]));
+	yylval = SAddress::createLast(std::static_pointer_cast<SPredicate>(yystack[yylen - 3]), m_zones);
        
 #line 468 "RangeParser.cpp"
 break;
 }
 case 10: {
-#line 223 "RangeParser.ypp"
+#line 227 "RangeParser.ypp"
 
          uint64_t  spec = 0L;
 	 unsigned  wild = 0;
@@ -487,7 +487,7 @@ case 10: {
 break;
 }
 case 11: {
-#line 236 "RangeParser.ypp"
+#line 240 "RangeParser.ypp"
 
          yylval = SAddress::createOffset(SAddress::createFirst(SPredicate::TRUE),
 				     static_cast<SNumber const&>(*yystack[yylen - 2]));
@@ -496,7 +496,7 @@ case 11: {
 break;
 }
 case 12: {
-#line 240 "RangeParser.ypp"
+#line 244 "RangeParser.ypp"
 
          yylval = SAddress::createOffset(std::static_pointer_cast<SAddress>(yystack[yylen - 1]),
 		                     static_cast<SNumber const&>(*yystack[yylen - 3]));
@@ -505,7 +505,7 @@ case 12: {
 break;
 }
 case 13: {
-#line 244 "RangeParser.ypp"
+#line 248 "RangeParser.ypp"
 
          yylval = SAddress::createOffset(std::static_pointer_cast<SAddress>(yystack[yylen - 1]),
 		                     -static_cast<SNumber const&>(*yystack[yylen - 3]));
@@ -514,31 +514,31 @@ case 13: {
 break;
 }
 case 14: {
-#line 249 "RangeParser.ypp"
+#line 253 "RangeParser.ypp"
  yylval = SPredicate::TAKEN; 
 #line 519 "RangeParser.cpp"
 break;
 }
 case 15: {
-#line 250 "RangeParser.ypp"
+#line 254 "RangeParser.ypp"
  yylval = SPredicate::SOLVED; 
 #line 525 "RangeParser.cpp"
 break;
 }
 case 16: {
-#line 251 "RangeParser.ypp"
+#line 255 "RangeParser.ypp"
  yylval = SPredicate::WRAPPED; 
 #line 531 "RangeParser.cpp"
 break;
 }
 case 17: {
-#line 252 "RangeParser.ypp"
+#line 256 "RangeParser.ypp"
  yylval = SPredicate::VALID; 
 #line 537 "RangeParser.cpp"
 break;
 }
 case 18: {
-#line 253 "RangeParser.ypp"
+#line 257 "RangeParser.ypp"
 
 	yylval = SPredicate::createInverted(std::static_pointer_cast<SPredicate>(yystack[yylen - 2]));
        
@@ -546,7 +546,7 @@ case 18: {
 break;
 }
 case 19: {
-#line 257 "RangeParser.ypp"
+#line 261 "RangeParser.ypp"
 
         int const  v = static_cast<SNumber const&>(*yystack[yylen - 1]);
 	if((v < 0) || (26 < v)) {
@@ -558,7 +558,7 @@ case 19: {
 break;
 }
 case 20: {
-#line 264 "RangeParser.ypp"
+#line 268 "RangeParser.ypp"
  yylval = std::make_shared<SNumber>(-1); 
 #line 563 "RangeParser.cpp"
 break;
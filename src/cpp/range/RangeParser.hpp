@@ -6,28 +6,32 @@
 #include <memory>
 
 namespace queens {
+  class ZoneMap;
   namespace range {
     class SVal;
     class SRange;
   }
 }
 
-#line 15 "RangeParser.hpp"
+#line 16 "RangeParser.hpp"
 #include <string>
 namespace queens {
 namespace range {
 class RangeParser {
   typedef std::shared_ptr< SVal > YYSVal;
   class YYStack;
-#line 36 "RangeParser.ypp"
+#line 37 "RangeParser.ypp"
 
   
   char const              *m_line;
   std::shared_ptr<SRange>  m_range;
+  ZoneMap const           *m_zones;
 
 //- Life Cycle ---------------------------------------------------------------
 public:
-  RangeParser() {}
+  // Searches for first() and last() addresses by the given block index of
+  // the database the ranges are resolved against, if any.
+  RangeParser(ZoneMap const *zones = nullptr) : m_zones(zones) {}
   ~RangeParser() {}
 
 //- Parser Interface Methods -------------------------------------------------
@@ -43,7 +47,7 @@ private:
 public:
   std::shared_ptr<SRange> parse(char const *line) throw (ParseException);
 
-#line 46 "RangeParser.hpp"
+#line 50 "RangeParser.hpp"
 private:
   void parse();
 public:
@@ -0,0 +1,254 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include <jni.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "DBEntry.hpp"
+#include "Kernel.hpp"
+#include "Protocol.hpp"
+#include "WorkPool.hpp"
+
+using namespace queens;
+
+namespace {
+
+  unsigned const  BATCH_SIZE = 16;
+
+  // Plain cases as produced by Solver.fetchCase()
+  struct Batch {
+    unsigned  n;
+    uint64_t  cs[BATCH_SIZE];
+  };
+
+ /**
+  * The completion kernel on a pool of native threads. Cases are submitted
+  * in batches by the Java writer and collected as (case, result) pairs by
+  * the Java reader.
+  */
+  class Engine {
+    unsigned         const  m_N;
+    Kernel::solve_t  const  m_solve;
+
+    std::mutex               m_lock;
+    std::condition_variable  m_avail;     // results or end of stream
+    std::vector<std::pair<uint64_t, uint64_t>>  m_results;
+    uint64_t                 m_pending;   // submitted but not collected
+    bool                     m_finished;  // no more submissions
+    std::atomic<bool>        m_cancelled;
+
+    WorkPool<Batch>  m_pool;  // last: its workers use all of the above
+
+  public:
+    Engine(unsigned  N, unsigned  threads)
+      : m_N(N), m_solve(Kernel::KERNELS[0].specialize(N)),
+	m_pending(0), m_finished(false), m_cancelled(false),
+	m_pool(threads, [this](unsigned, Batch &b) { solve(b); }) {}
+    ~Engine() {
+      m_cancelled = true;
+      m_pool.close();
+    }
+
+  private:
+    Engine(Engine const&) = delete;
+    Engine& operator=(Engine const&) = delete;
+
+  public:
+    void submit(Batch const &b) {
+      if(m_cancelled)  return;
+      {
+	std::lock_guard<std::mutex>  lk(m_lock);
+	m_pending += b.n;
+      }
+      m_pool.submit(b);
+    }
+    void finish() {
+      {
+	std::lock_guard<std::mutex>  lk(m_lock);
+	m_finished = true;
+      }
+      m_avail.notify_all();
+    }
+    void cancel() {
+      {
+	std::lock_guard<std::mutex>  lk(m_lock);
+	m_cancelled = true;
+      }
+      m_avail.notify_all();
+    }
+
+    /**
+     * Waits for results and moves up to n of them into the given arrays.
+     * Returns -1 at the end of the stream, i.e. after cancel() or after
+     * finish() once all submitted cases have been collected.
+     */
+    int collect(uint64_t *cs, uint64_t *res, unsigned  n) {
+      std::unique_lock<std::mutex>  lk(m_lock);
+      m_avail.wait(lk, [this]() {
+	  return  m_cancelled || !m_results.empty() || (m_finished && (m_pending == 0));
+	});
+      if(m_cancelled || m_results.empty())  return -1;
+
+      if(n > m_results.size())  n = m_results.size();
+      for(unsigned  i = 0; i < n; i++) {
+	cs [i] = m_results[m_results.size()-n+i].first;
+	res[i] = m_results[m_results.size()-n+i].second;
+      }
+      m_results.resize(m_results.size()-n);
+      m_pending -= n;
+      return  n;
+    }
+
+  private:
+    void solve(Batch const &b) {
+      if(m_cancelled)  return;
+
+      Blocking  blk[BATCH_SIZE];
+      uint64_t  cnt[BATCH_SIZE];
+      bool      valid[BATCH_SIZE];
+      unsigned  m = 0;
+      for(unsigned  i = 0; i < b.n; i++) {
+	// Strip the parity bit and lift to the spec position of an entry of
+	// two rings.
+	uint64be_t const  raw[2] = { (b.cs[i] & UINT64_C(0x7FFFFFFFFF)) << 25, 0 };
+	uint64_t  bv, bh, bu, bd;
+	valid[i] = reinterpret_cast<DBEntry const*>(raw)->expand(2, m_N, bv, bh, bu, bd);
+	if(valid[i])  blk[m++] = Blocking::fromBoard(m_N, bv, bh, bu, bd);
+      }
+      uint64_t  nodes = 0;
+      m_solve(blk, m, cnt, nodes);
+
+      {
+	// An invalid pre-placement is reported with an impossible result so
+	// that the database rejects it.
+	std::lock_guard<std::mutex>  lk(m_lock);
+	unsigned  j = 0;
+	for(unsigned  i = 0; i < b.n; i++) {
+	  m_results.emplace_back(b.cs[i], valid[i]? protocol::result(cnt[j++]) : ~UINT64_C(0));
+	}
+      }
+      m_avail.notify_all();
+    }
+
+  }; // class Engine
+
+  Engine *engine(jlong const  handle) {
+    return  reinterpret_cast<Engine*>(handle);
+  }
+
+} // anonymous namespace
+
+
+#ifndef _Included_me_preusser_q27_CpuSolver
+#define _Included_me_preusser_q27_CpuSolver
+
+/*
+ * Class:     me_preusser_q27_CpuSolver
+ * Method:    open0
+ * Signature: (II)J
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_me_preusser_q27_CpuSolver_open0(JNIEnv *const  env, jclass const  klass,
+	jint const  N, jint const  threads) {
+  if((N < jint(Kernel::MIN_N)) || (jint(Kernel::MAX_N) < N) || (threads <= 0)) {
+    env->ThrowNew(env->FindClass("java/lang/IllegalArgumentException"), "Unsupported board dimension or thread count.");
+    return  0;
+  }
+  return  reinterpret_cast<jlong>(new Engine(N, threads));
+}
+
+/*
+ * Class:     me_preusser_q27_CpuSolver
+ * Method:    submit0
+ * Signature: (J[JI)V
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_me_preusser_q27_CpuSolver_submit0(JNIEnv *const  env, jclass const  klass,
+	jlong const  handle, jlongArray const  cases, jint const  n) {
+  Batch  b;
+  jlong  buf[BATCH_SIZE];
+  for(jint  ofs = 0; ofs < n; ofs += b.n) {
+    b.n = n-ofs < jint(BATCH_SIZE)? n-ofs : BATCH_SIZE;
+    env->GetLongArrayRegion(cases, ofs, b.n, buf);
+    for(unsigned  i = 0; i < b.n; i++)  b.cs[i] = buf[i];
+    engine(handle)->submit(b);
+  }
+}
+
+/*
+ * Class:     me_preusser_q27_CpuSolver
+ * Method:    collect0
+ * Signature: (J[J[J)I
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_me_preusser_q27_CpuSolver_collect0(JNIEnv *const  env, jclass const  klass,
+	jlong const  handle, jlongArray const  cases, jlongArray const  results) {
+  unsigned const  n = env->GetArrayLength(cases);
+  std::vector<uint64_t>  cs(n), res(n);
+  int const  k = engine(handle)->collect(cs.data(), res.data(), n);
+  if(k > 0) {
+    std::vector<jlong>  buf(k);
+    for(int  i = 0; i < k; i++)  buf[i] = cs[i];
+    env->SetLongArrayRegion(cases, 0, k, buf.data());
+    for(int  i = 0; i < k; i++)  buf[i] = res[i];
+    env->SetLongArrayRegion(results, 0, k, buf.data());
+  }
+  return  k;
+}
+
+/*
+ * Class:     me_preusser_q27_CpuSolver
+ * Method:    finish0
+ * Signature: (J)V
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_me_preusser_q27_CpuSolver_finish0(JNIEnv *const  env, jclass const  klass,
+	jlong const  handle) {
+  engine(handle)->finish();
+}
+
+/*
+ * Class:     me_preusser_q27_CpuSolver
+ * Method:    cancel0
+ * Signature: (J)V
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_me_preusser_q27_CpuSolver_cancel0(JNIEnv *const  env, jclass const  klass,
+	jlong const  handle) {
+  engine(handle)->cancel();
+}
+
+/*
+ * Class:     me_preusser_q27_CpuSolver
+ * Method:    close0
+ * Signature: (J)V
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_me_preusser_q27_CpuSolver_close0(JNIEnv *const  env, jclass const  klass,
+	jlong const  handle) {
+  delete  engine(handle);
+}
+
+#endif
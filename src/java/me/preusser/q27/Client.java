@@ -227,6 +227,7 @@ public final class Client extends Thread {
 		 "    INFO  obtain solver info\n"+
 		 "    STOP /dev/ttyXX\n\tstop solver on given device\n"+
 		 "    STRT /dev/ttyXX \"<Description>\" <pipeline depth>\n\tstart solver on given device\n"+
+		 "    STRT /cpu/<threads> \"<Description>\" <pipeline depth>\n\tstart solver on local cores\n"+
                  "    EXIT\n"+
 		 "    QUIT  close this session\n");
     }
@@ -251,8 +252,8 @@ public final class Client extends Thread {
     }
 
     private void start(final String  args) {
-      //                                   1                        2           3         4
-      final Matcher  m = Pattern.compile("^(/dev/tty\\S+|/dini/board(\\d))\\s+\"(.*)\"\\s+(\\d+)\\s*$").matcher(args);
+      //                                   1                        2                   3              4         5
+      final Matcher  m = Pattern.compile("^(/dev/tty\\S+|/dini/board(\\d)|/cpu/(\\d+))\\s+\"(.*)\"\\s+(\\d+)\\s*$").matcher(args);
       if(m.matches()) {
 	final Map<String, Solver>  solvers = Client.this.solvers;
 	final String  dev = m.group(1);
@@ -260,8 +261,9 @@ public final class Client extends Thread {
 	try { // Create and Register Solver Instance
 
 	  final String  dini  = m.group(2);
-	  final String  desc  = m.group(3);
-	  final int     limit = Integer.parseInt(m.group(4));
+	  final String  cpu   = m.group(3);
+	  final String  desc  = m.group(4);
+	  final int     limit = Integer.parseInt(m.group(5));
 	  final Solver  solver;
 
 	  synchronized(solvers) {
@@ -270,15 +272,15 @@ public final class Client extends Thread {
 	      return;
 	    }
 
-	    solver = (dini == null)?
-	      new UartSolver(new File(dev), desc, limit) :
-	      new DiniSolver(dini.charAt(0) - '0', desc, limit);
+	    solver = (dini != null)? new DiniSolver(dini.charAt(0) - '0', desc, limit) :
+	             (cpu  != null)? new CpuSolver(27, Integer.parseInt(cpu), desc, limit) :
+	                             new UartSolver(new File(dev), desc, limit);
 	    solvers.put(dev, solver);
 	  }
 
 	  // Initialize UART and Start Solver
 	  boolean  fail = false;
-	  if(dini == null) {
+	  if((dini == null) && (cpu == null)) {
 	    final Process  pInit
 	      = Runtime.getRuntime().exec(new String[] {
 		  "bash", "-c",
@@ -301,7 +303,7 @@ public final class Client extends Thread {
     }
 
     private void stop(String args) {
-      final Matcher  m = Pattern.compile("^(/dev/tty\\S+|/dini/board\\d)\\s*$").matcher(args);
+      final Matcher  m = Pattern.compile("^(/dev/tty\\S+|/dini/board\\d|/cpu/\\d+)\\s*$").matcher(args);
       if(m.matches()) {
 	final String  dev = m.group(1);
 
@@ -0,0 +1,150 @@
+/*****************************************************************************
+ * This file is part of the Queens@TUD solver suite
+ * for enumerating and counting the solutions of an N-Queens Puzzle.
+ *
+ * Copyright (C) 2008-2015
+ *      Thomas B. Preusser <thomas.preusser@utexas.edu>
+ *****************************************************************************
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+package me.preusser.q27;
+
+import  java.util.concurrent.atomic.AtomicInteger;
+
+/**
+ * A CpuSolver computes its cases on the cores of the local host by the
+ * native completion kernel (libq27cpu) running on a pool of native threads.
+ * The limit of pending computations should allow for a few batches per
+ * thread to keep all of them busy.
+ */
+public class CpuSolver extends Solver {
+
+  // Cases handed to the native Kernel at once
+  private static final int  BATCH_SIZE = 16;
+
+  private static final ThreadGroup    tgrp = new ThreadGroup("CPU Workers");
+  private static final AtomicInteger  tcnt = new AtomicInteger();
+
+  private final int     N;
+  private final int     threads;
+  private final String  desc;
+  private final int     limit;
+
+  private long    handle;
+  private Thread  reader;
+  private Thread  writer;
+
+  public CpuSolver(final int  N, final int  threads, final String  desc, final int  limit) {
+    super(limit, 600);
+    this.N       = N;
+    this.threads = threads;
+    this.desc    = desc;
+    this.limit   = limit;
+  }
+
+  @Override
+  public String toString() {
+    return  desc + " on /cpu/" + threads;
+  }
+
+  @Override
+  public synchronized void start(final Database  db) throws Exception {
+    if(reader != null)  throw  new IllegalStateException("Already running.");
+
+    // Prepare inherited start()
+    final long  handle = this.handle = open0(N, threads);
+    super.start(db);
+    final int  tid = tcnt.getAndIncrement();
+
+    // Writer: Fetch Cases & hand them over in Batches
+    writer = new Thread(tgrp, "Writer-" + tid) {
+      public void run() {
+	final long[]  cs = new long[BATCH_SIZE];
+	int  n = 0;
+	try {
+	  while(true) {
+	    final long  c = fetchCase();
+	    if(c != 0L)  cs[n++] = c;
+
+	    // Pass on full Batches and whatever is pending before a blocking fetch
+	    if((n > 0) && ((c == 0L) || (n == BATCH_SIZE) || (CpuSolver.this.activeCount() >= limit))) {
+	      submit0(handle, cs, n);
+	      n = 0;
+	    }
+	    if(c == 0L)  return;
+	  }
+	}
+	catch(InterruptedException e) {}
+	catch(Exception e) {
+	  e.printStackTrace();
+	}
+	finally {
+	  finish0(handle);
+	}
+      }
+    }; // Writer
+
+    // Reader: Log Results until the native Engine is exhausted or cancelled
+    final Thread  writer = this.writer;
+    reader = new Thread(tgrp, "Reader-" + tid) {
+      public void run() {
+	final long[]  cs  = new long[BATCH_SIZE*threads];
+	final long[]  res = new long[cs.length];
+	try {
+	  for(int  n; (n = collect0(handle, cs, res)) >= 0;) {
+	    for(int  i = 0; i < n; i++)  logCount(cs[i], res[i]);
+	  }
+	}
+	catch(Exception e) {
+	  e.printStackTrace();
+	}
+	finally {
+	  // The Writer must not submit to a released Engine.
+	  try { writer.join(); } catch(InterruptedException e) {}
+	  synchronized(CpuSolver.this) {
+	    close0(handle);
+	    if(CpuSolver.this.handle == handle)  CpuSolver.this.handle = 0L;
+	  }
+	}
+      }
+    }; // Reader
+
+    writer.start();
+    reader.start();
+  }
+
+  @Override
+  public synchronized void stop() {
+    try {
+      if(handle != 0L)  cancel0(handle);
+    }
+    finally {
+      reader = null;
+      writer = null;
+      super.stop();
+    }
+  }
+
+  private static native long open0   (final int  N, final int  threads);
+  private static native void submit0 (final long  handle, final long[]  cases, final int  n);
+  private static native int  collect0(final long  handle, final long[]  cases, final long[]  results);
+  private static native void finish0 (final long  handle);
+  private static native void cancel0 (final long  handle);
+  private static native void close0  (final long  handle);
+
+  static {
+    System.loadLibrary("q27cpu");
+  }
+
+} // class CpuSolver
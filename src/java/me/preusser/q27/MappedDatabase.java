@@ -62,6 +62,9 @@ public class MappedDatabase implements Database {
 
     final long  size = db.size();
     if((size > 0) && (((int)size & 7) == 0)) {
+      if(!twoRings(db, size/16)) {
+	throw  new IllegalArgumentException("Database of three rings, which only q27solve -r:3 handles");
+      }
       this.db       = db;
       this.mappings = new SoftReference[(int)((size-1)/MAPPING_SIZE)+1];
 
@@ -131,6 +134,39 @@ public class MappedDatabase implements Database {
 
   } // fetchUnsolved
 
+  //+ Layout Check as by DBEntry::layout()
+  private static final long[]  CRC3 = {
+    0x9D3A74E9D3A74E9DL, 0xA74E9D3A74E9D3A7L, 0x4E9D3A74E9D3A74EL
+  };
+  private static int crc3(final long  val) {
+    return  (Long.bitCount(val & CRC3[0]) & 1)       |
+	   ((Long.bitCount(val & CRC3[1]) & 1) << 1) |
+	   ((Long.bitCount(val & CRC3[2]) & 1) << 2);
+  }
+
+  /**
+   * Whether a sample of up to 64 of the n entries does not match the
+   * three-ring layout better than this two-ring one by CRC and a non-zero
+   * symmetry. The entries of one layout match the other only by chance.
+   */
+  private static boolean twoRings(final FileChannel  db, final long  n) throws IOException {
+    final long        k   = n < 64? n : 64;
+    final ByteBuffer  buf = ByteBuffer.allocate(8);
+    int  v2 = 0;
+    int  v3 = 0;
+    for(long  i = 0; i < k; i++) {
+      buf.clear();
+      final long  pos = 16*(i*n/k);
+      while(buf.hasRemaining()) {
+	if(db.read(buf, pos + buf.position()) < 0)  throw  new IOException("Truncated Database");
+      }
+      final long  spec = buf.getLong(0);
+      if((crc3(spec >>> 20) == 0) && (((spec >>> 23) & 3) != 0))  v2++;
+      if((crc3(spec)        == 0) && (((spec >>>  3) & 3) != 0))  v3++;
+    }
+    return  v3 <= v2;
+  }
+
   private static int timestamp(final LocalDateTime  time) {
     return ((((((((((time.getYear()-2015)&3)) << 4) |
 		 time.getMonthValue()) << 5) | time.getDayOfMonth()) << 5) |